@@ -0,0 +1,326 @@
+/**
+ * @file Bench.cpp
+ * @brief Banco de pruebas de rendimiento de Setker (objetivo setker_bench)
+ * @author Javier
+ * @date 2025
+ *
+ * Mide por separado cada fase del intérprete sobre un conjunto fijo de
+ * programas: el analizador léxico (Lexer::next hasta el final), el parser
+ * (Parser::parseAST), el evaluador de árbol (Evaluator::evalNode sobre el
+ * AST ya resuelto) y la máquina virtual (compilación y ejecución). Los
+ * programas son los .stk de bench/workloads más un fuente grande generado
+ * aquí mismo.
+ *
+ * El resultado se escribe en JSON (por defecto en la salida estándar) para
+ * poder guardarlo y comparar ejecuciones; en la salida de error se muestra
+ * un resumen legible. Lo que imprimen los programas se descarta.
+ *
+ * Uso: setker_bench [--min-time segundos] [--filter texto] [--json archivo]
+ *                   [--workloads directorio]
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "Evaluator.h"
+#include "Parser.h"
+#include "Resolver.h"
+#include "Tokenizer.h"
+#include "VM.h"
+#include "../def/ErrorCode.h"
+#include "../def/Context.h"
+
+#ifndef SETKER_BENCH_WORKLOADS
+#define SETKER_BENCH_WORKLOADS "bench/workloads"
+#endif
+
+#ifndef SETKER_BUILD_TYPE
+#define SETKER_BUILD_TYPE ""
+#endif
+
+#ifdef __VERSION__
+#define SETKER_COMPILER __VERSION__
+#else
+#define SETKER_COMPILER ""
+#endif
+
+/**
+ * @namespace Bench
+ * @brief Espacio de nombres del banco de pruebas
+ */
+namespace Bench {
+    using Clock = std::chrono::steady_clock;
+
+    /// Iteraciones mínimas de cada medida, aunque se supere el tiempo mínimo
+    constexpr size_t MIN_ITERATIONS = 5;
+
+    /**
+     * @struct Workload
+     * @brief Programa sobre el que se miden las fases
+     */
+    struct Workload {
+        std::string name;   ///< Nombre del programa (archivo sin extensión)
+        std::string source; ///< Código fuente
+    };
+
+    /**
+     * @struct Result
+     * @brief Medida de una fase sobre un programa
+     */
+    struct Result {
+        std::string workload;      ///< Programa medido
+        std::string phase;         ///< lex, parse, eval o vm
+        size_t iterations = 0;     ///< Repeticiones realizadas
+        double minNs = 0;          ///< Tiempo mínimo por iteración
+        double medianNs = 0;       ///< Mediana por iteración
+        double meanNs = 0;         ///< Media por iteración
+        size_t bytes = 0;          ///< Tamaño del fuente
+        size_t tokens = 0;         ///< Tokens del fuente
+    };
+
+    /**
+     * @struct Settings
+     * @brief Opciones de línea de comandos
+     */
+    struct Settings {
+        double minTime = 0.5;                       ///< Segundos mínimos por medida
+        std::string filter;                         ///< Solo medidas cuyo nombre lo contenga
+        std::string jsonPath;                       ///< Archivo JSON (vacío = salida estándar)
+        std::string workloads = SETKER_BENCH_WORKLOADS; ///< Directorio de los .stk
+    };
+
+    /**
+     * @brief Genera un fuente grande y válido: muchas funciones y sentencias
+     * @param functions Número de funciones
+     * @return std::string Programa (unos 200 bytes por función)
+     */
+    std::string generateLarge(size_t functions) {
+        std::ostringstream out;
+        out << "<| Programa generado por setker_bench |>\n";
+        for (size_t i = 0; i < functions; ++i) {
+            out << "fun f" << i << "(a, b) {\n"
+                << "    var x = a * " << i % 97 << " + b; // mezcla\n"
+                << "    if (x > 100 and b != nil) { x = x - " << i % 13 << "; } else { x = x + 1; }\n"
+                << "    while (x > 50) x = x / 2;\n"
+                << "    return \"f" << i << ":\" + x;\n"
+                << "}\n"
+                << "var r" << i << " = f" << i << "(" << i << ", 3);\n";
+        }
+        out << "print r0;\n";
+        return out.str();
+    }
+
+    /**
+     * @brief Carga los programas de un directorio y añade el generado
+     * @param directory Directorio con archivos .stk
+     * @return std::vector<Workload> Programas ordenados por nombre
+     */
+    std::vector<Workload> loadWorkloads(const std::string& directory) {
+        std::vector<Workload> workloads;
+        std::error_code error;
+        for (const auto& entry : std::filesystem::directory_iterator(directory, error)) {
+            if (entry.path().extension() != ".stk") continue;
+            std::ifstream file(entry.path(), std::ios::binary);
+            std::stringstream contents;
+            contents << file.rdbuf();
+            workloads.push_back({entry.path().stem().string(), contents.str()});
+        }
+        if (error) std::cerr << "Cannot read workloads from " << directory << ": " << error.message() << std::endl;
+        std::sort(workloads.begin(), workloads.end(), [](const Workload& a, const Workload& b) { return a.name < b.name; });
+        workloads.push_back({"generated_large", generateLarge(10000)});
+        return workloads;
+    }
+
+    /**
+     * @brief Repite una operación hasta cubrir el tiempo mínimo
+     * @param minTime Segundos mínimos en total
+     * @param operation Operación a medir (una iteración)
+     * @param result Medida en la que se guardan los tiempos
+     *
+     * Antes de medir se ejecuta una vez para calentar cachés y asignadores.
+     */
+    void measure(double minTime, const std::function<void()>& operation, Result& result) {
+        operation();
+        std::vector<double> samples;
+        auto deadline = Clock::now() + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(minTime));
+        while (samples.size() < MIN_ITERATIONS || Clock::now() < deadline) {
+            auto start = Clock::now();
+            operation();
+            samples.push_back(std::chrono::duration<double, std::nano>(Clock::now() - start).count());
+        }
+        std::sort(samples.begin(), samples.end());
+        double total = 0;
+        for (double sample : samples) total += sample;
+        result.iterations = samples.size();
+        result.minNs = samples.front();
+        result.medianNs = samples[samples.size() / 2];
+        result.meanNs = total / static_cast<double>(samples.size());
+    }
+
+    /**
+     * @brief Cuenta los tokens de un fuente consumiendo el lexer
+     * @param source Código fuente
+     * @return size_t Tokens, sin contar el final de archivo
+     */
+    size_t lexAll(std::string_view source) {
+        Tokenizer::Lexer lexer(source);
+        size_t tokens = 0;
+        while (lexer.next().getType() != TokenType::EOF_OF_FILE) ++tokens;
+        return tokens;
+    }
+
+    /**
+     * @brief Mide las cuatro fases sobre un programa
+     * @param workload Programa
+     * @param settings Opciones (tiempo mínimo y filtro)
+     * @param results Medidas obtenidas (se añaden al final)
+     */
+    void runWorkload(const Workload& workload, const Settings& settings, std::vector<Result>& results) {
+        const std::string_view source = workload.source;
+        const size_t tokens = lexAll(source);
+        auto selected = [&](const char* phase) {
+            return settings.filter.empty() || (workload.name + "/" + phase).find(settings.filter) != std::string::npos;
+        };
+        auto add = [&](const char* phase, const std::function<void()>& operation) {
+            if (!selected(phase)) return;
+            Result result{workload.name, phase};
+            result.bytes = source.size();
+            result.tokens = tokens;
+            try {
+                measure(settings.minTime, operation, result);
+            } catch (const TokenTree::Error& e) {
+                std::cerr << workload.name << "/" << phase << ": " << e.message << std::endl;
+                return;
+            }
+            results.push_back(result);
+        };
+
+        add("lex", [&] { lexAll(source); });
+        add("parse", [&] {
+            Tokenizer::Lexer lexer(source);
+            Parser::parseAST(lexer);
+        });
+
+        // Las fases de ejecución parten de un AST ya construido (y resuelto para el evaluador)
+        Tokenizer::Lexer lexer(source);
+        auto ast = Parser::parseAST(lexer);
+        add("vm", [&] {
+            VM::Machine machine;
+            machine.interpret(ast->root());
+        });
+        Resolver::resolve(ast->root());
+        add("eval", [&] { Evaluator::evalNode(ast->root()); });
+    }
+
+    /**
+     * @brief Escribe las medidas en JSON
+     * @param out Flujo de salida
+     * @param results Medidas
+     * @param settings Opciones con las que se obtuvieron
+     */
+    void writeJson(std::ostream& out, const std::vector<Result>& results, const Settings& settings) {
+        out << std::fixed << std::setprecision(1);
+        out << "{\n  \"context\": {\n"
+            << "    \"timestamp\": " << std::time(nullptr) << ",\n"
+            << "    \"compiler\": \"" << SETKER_COMPILER << "\",\n"
+            << "    \"build_type\": \"" << SETKER_BUILD_TYPE << "\",\n"
+            << "    \"min_time_s\": " << settings.minTime << "\n"
+            << "  },\n  \"benchmarks\": [";
+        for (size_t i = 0; i < results.size(); ++i) {
+            const Result& r = results[i];
+            double perSecond = r.minNs > 0 ? 1e9 / r.minNs : 0;
+            out << (i ? "," : "") << "\n    {"
+                << "\"name\": \"" << r.workload << "/" << r.phase << "\", "
+                << "\"workload\": \"" << r.workload << "\", "
+                << "\"phase\": \"" << r.phase << "\", "
+                << "\"iterations\": " << r.iterations << ", "
+                << "\"min_ns\": " << r.minNs << ", "
+                << "\"median_ns\": " << r.medianNs << ", "
+                << "\"mean_ns\": " << r.meanNs << ", "
+                << "\"bytes\": " << r.bytes << ", "
+                << "\"tokens\": " << r.tokens << ", "
+                << "\"bytes_per_second\": " << r.bytes * perSecond << ", "
+                << "\"tokens_per_second\": " << r.tokens * perSecond << "}";
+        }
+        out << "\n  ]\n}\n";
+    }
+
+    /**
+     * @brief Muestra un resumen legible de las medidas
+     * @param out Flujo de salida
+     * @param results Medidas
+     */
+    void writeSummary(std::ostream& out, const std::vector<Result>& results) {
+        auto flags = out.flags();
+        out << std::left << std::setw(28) << "benchmark" << std::right << std::setw(12) << "min ms"
+            << std::setw(12) << "median ms" << std::setw(8) << "iters" << std::setw(12) << "MB/s" << '\n';
+        out << std::fixed << std::setprecision(3);
+        for (const Result& r : results) {
+            double megabytes = r.minNs > 0 ? r.bytes / (r.minNs / 1e9) / 1e6 : 0;
+            out << std::left << std::setw(28) << r.workload + "/" + r.phase << std::right
+                << std::setw(12) << r.minNs / 1e6 << std::setw(12) << r.medianNs / 1e6
+                << std::setw(8) << r.iterations << std::setw(12) << std::setprecision(1) << megabytes
+                << std::setprecision(3) << '\n';
+        }
+        out.flags(flags);
+    }
+}
+
+/**
+ * @brief Punto de entrada de setker_bench
+ * @param argc Número de argumentos
+ * @param argv Argumentos (ver el comentario del archivo)
+ * @return int 0 si se completaron las medidas, 1 si los argumentos no son válidos
+ */
+int main(int argc, char* argv[]) {
+    Bench::Settings settings;
+    for (int i = 1; i < argc; ++i) {
+        bool hasValue = i + 1 < argc;
+        if (std::strcmp(argv[i], "--min-time") == 0 && hasValue) {
+            settings.minTime = std::stod(argv[++i]);
+        } else if (std::strcmp(argv[i], "--filter") == 0 && hasValue) {
+            settings.filter = argv[++i];
+        } else if (std::strcmp(argv[i], "--json") == 0 && hasValue) {
+            settings.jsonPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--workloads") == 0 && hasValue) {
+            settings.workloads = argv[++i];
+        } else {
+            std::cerr << "Usage: setker_bench [--min-time seconds] [--filter text] [--json file] [--workloads dir]" << std::endl;
+            return 1;
+        }
+    }
+
+    // Lo que imprimen los programas no debe mezclarse con el JSON
+    std::FILE* discarded = std::tmpfile();
+    if (discarded) TokenTree::Context::process().output.setFile(discarded);
+
+    std::vector<Bench::Result> results;
+    for (const auto& workload : Bench::loadWorkloads(settings.workloads)) {
+        Bench::runWorkload(workload, settings, results);
+    }
+    TokenTree::Context::process().output.flush();
+
+    Bench::writeSummary(std::cerr, results);
+    if (settings.jsonPath.empty()) {
+        Bench::writeJson(std::cout, results, settings);
+    } else {
+        std::ofstream json(settings.jsonPath);
+        if (!json) {
+            std::cerr << "Error writing file: " << settings.jsonPath << std::endl;
+            return 1;
+        }
+        Bench::writeJson(json, results, settings);
+    }
+    return 0;
+}
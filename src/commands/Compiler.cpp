@@ -0,0 +1,504 @@
+/**
+ * @file Compiler.cpp
+ * @brief Implementación del compilador de AST a bytecode
+ * @author Javier
+ * @date 2025
+ *
+ * Este archivo recorre el AST una única vez y emite el bytecode de cada
+ * función. Reproduce la semántica del evaluador:
+ * - Cada bloque y cada llamada tienen su propio ámbito de variables
+ * - Las variables de nivel superior son globales y se resuelven por nombre
+ * - Las closures capturan las variables por referencia (upvalues)
+ * - Los errores informan la ruta de sentencias "[line N]" del evaluador
+ */
+
+#include "Compiler.h"
+#include "Resolver.h"
+
+#include <bit>
+#include <limits>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace TokenTree;
+
+namespace Compiler {
+    namespace {
+        using Type = ASTNode::Type;
+        using Kind = Binding::Kind;
+        using Value = Environment::Value;
+
+        constexpr size_t MAX_U16 = std::numeric_limits<uint16_t>::max();
+        constexpr size_t MAX_ARGS = std::numeric_limits<uint8_t>::max();
+
+        /**
+         * @class FunctionCompiler
+         * @brief Estado de compilación de una función
+         *
+         * Cada función (incluido el programa) tiene su propio compilador,
+         * enlazado con el de la función que la contiene para resolver
+         * variables capturadas.
+         */
+        class FunctionCompiler {
+        public:
+            FunctionCompiler(FunctionCompiler* enclosing, std::string_view name, GlobalTable& globals)
+                : enclosing(enclosing), globals(globals), proto(std::make_shared<FunctionProto>()) {
+                proto->name = name;
+                currentPath = internPath();
+            }
+
+            std::shared_ptr<FunctionProto> compileScript(const ASTNode* program) {
+                const auto& children = program->getChildren();
+                for (size_t i = 0; i < children.size(); ++i) {
+                    enterStatement(i);
+                    statement(children[i].get());
+                    leaveStatement();
+                }
+                emitOp(OpCode::Nil);
+                emitOp(OpCode::Return);
+                return proto;
+            }
+
+            std::shared_ptr<FunctionProto> compileFunction(const ASTNode* node) {
+                const auto& children = node->getChildren();
+                // Último hijo es el cuerpo, los anteriores son parámetros
+                size_t arity = children.size() - 1;
+                if (arity > MAX_ARGS) {
+                    throw Error(ErrorCodes::CompileError, "Can't have more than 255 parameters.");
+                }
+                proto->arity = static_cast<int>(arity);
+                // La ranura 0 guarda la propia función; los parámetros van a continuación.
+                // Con nombres repetidos gana el último, igual que Environment::define.
+                Scope params;
+                for (size_t i = 0; i < arity; ++i) {
+                    params.slots.insert_or_assign(std::string(children[i]->getValue()), static_cast<uint16_t>(i + 1));
+                }
+                params.size = static_cast<uint16_t>(arity);
+                nextSlot = arity + 1;
+                scopes.push_back(std::move(params));
+                block(children.back().get());
+                emitOp(OpCode::Nil);
+                emitOp(OpCode::Return);
+                return proto;
+            }
+
+        private:
+            /**
+             * @struct Scope
+             * @brief Ámbito léxico (parámetros o bloque) y sus ranuras
+             */
+            struct Scope {
+                NameMap<uint16_t> slots;                         ///< Ranura de cada nombre
+                uint16_t size = 0;                               ///< Ranuras reservadas
+            };
+
+            FunctionCompiler* enclosing;          ///< Compilador de la función envolvente
+            GlobalTable& globals;                 ///< Tabla de globales de la VM
+            std::shared_ptr<FunctionProto> proto; ///< Función en construcción
+            std::vector<Scope> scopes;            ///< Ámbitos abiertos (vacío = nivel global)
+            size_t nextSlot = 1;                  ///< Primera ranura libre del marco
+            std::vector<uint32_t> path;           ///< Índices de la sentencia en curso
+            uint32_t currentPath = 0;             ///< Identificador de la ruta en curso
+            std::map<std::vector<uint32_t>, uint32_t> pathIds;      ///< Rutas ya registradas
+            std::unordered_map<uint64_t, uint16_t> numberConstants; ///< Constantes numéricas (por bits)
+            NameMap<uint16_t> stringConstants;                      ///< Constantes de cadena
+
+            Chunk& chunk() { return proto->chunk; }
+
+            // ---- Rutas de sentencias para los mensajes de error ----
+
+            uint32_t internPath() {
+                auto [it, inserted] = pathIds.try_emplace(path, static_cast<uint32_t>(chunk().paths.size()));
+                if (inserted) chunk().paths.push_back(path);
+                return it->second;
+            }
+
+            void enterStatement(size_t index) {
+                path.push_back(static_cast<uint32_t>(index));
+                currentPath = internPath();
+            }
+
+            void leaveStatement() {
+                path.pop_back();
+                currentPath = internPath();
+            }
+
+            // ---- Emisión de código ----
+
+            void emitByte(uint8_t byte) {
+                auto& sites = chunk().sites;
+                if (sites.empty() || sites.back().second != currentPath) {
+                    sites.emplace_back(static_cast<uint32_t>(chunk().code.size()), currentPath);
+                }
+                chunk().code.push_back(byte);
+            }
+
+            void emitOp(OpCode op) {
+                emitByte(static_cast<uint8_t>(op));
+            }
+
+            void emitU16(size_t value) {
+                emitByte(static_cast<uint8_t>((value >> 8) & 0xff));
+                emitByte(static_cast<uint8_t>(value & 0xff));
+            }
+
+            size_t emitJump(OpCode op) {
+                emitOp(op);
+                emitU16(MAX_U16);
+                return chunk().code.size() - 2;
+            }
+
+            void patchJump(size_t offset) {
+                size_t jump = chunk().code.size() - offset - 2;
+                if (jump > MAX_U16) {
+                    throw Error(ErrorCodes::CompileError, "Too much code to jump over.");
+                }
+                chunk().code[offset] = static_cast<uint8_t>((jump >> 8) & 0xff);
+                chunk().code[offset + 1] = static_cast<uint8_t>(jump & 0xff);
+            }
+
+            void emitLoop(size_t loopStart) {
+                emitOp(OpCode::Loop);
+                size_t offset = chunk().code.size() - loopStart + 2;
+                if (offset > MAX_U16) {
+                    throw Error(ErrorCodes::CompileError, "Loop body too large.");
+                }
+                emitU16(offset);
+            }
+
+            uint16_t addConstant(const Value& value) {
+                if (chunk().constants.size() > MAX_U16) {
+                    throw Error(ErrorCodes::CompileError, "Too many constants in one chunk.");
+                }
+                chunk().constants.push_back(value);
+                return static_cast<uint16_t>(chunk().constants.size() - 1);
+            }
+
+            uint16_t numberConstant(double number) {
+                auto bits = std::bit_cast<uint64_t>(number);
+                auto it = numberConstants.find(bits);
+                if (it != numberConstants.end()) return it->second;
+                uint16_t index = addConstant(number);
+                numberConstants.emplace(bits, index);
+                return index;
+            }
+
+            uint16_t stringConstant(std::string_view text) {
+                auto it = stringConstants.find(text);
+                if (it != stringConstants.end()) return it->second;
+                uint16_t index = addConstant(makeString(text));
+                stringConstants.emplace(text, index);
+                return index;
+            }
+
+            // ---- Ámbitos y variables ----
+
+            bool isGlobalScope() const {
+                return enclosing == nullptr && scopes.empty();
+            }
+
+            void beginScope(const std::vector<std::string_view>& names) {
+                Scope scope;
+                for (const auto& name : names) {
+                    if (scope.slots.contains(name)) continue;
+                    if (nextSlot > MAX_U16) {
+                        throw Error(ErrorCodes::CompileError, "Too many local variables in function.");
+                    }
+                    scope.slots.emplace(name, static_cast<uint16_t>(nextSlot++));
+                }
+                scope.size = static_cast<uint16_t>(scope.slots.size());
+                if (scope.size > 0) {
+                    emitOp(OpCode::Reserve);
+                    emitU16(scope.size);
+                }
+                scopes.push_back(std::move(scope));
+            }
+
+            void endScope() {
+                uint16_t size = scopes.back().size;
+                if (size > 0) {
+                    emitOp(OpCode::PopScope);
+                    emitU16(size);
+                }
+                nextSlot -= size;
+                scopes.pop_back();
+            }
+
+            uint16_t addUpvalue(const Binding& binding) {
+                bool isLocal = binding.kind == Kind::Local;
+                auto& upvalues = proto->upvalues;
+                for (size_t i = 0; i < upvalues.size(); ++i) {
+                    if (upvalues[i].isLocal == isLocal && upvalues[i].index == binding.index) {
+                        return static_cast<uint16_t>(i);
+                    }
+                }
+                if (upvalues.size() > MAX_U16) {
+                    throw Error(ErrorCodes::CompileError, "Too many closure variables in function.");
+                }
+                upvalues.push_back({isLocal, binding.index});
+                return static_cast<uint16_t>(upvalues.size() - 1);
+            }
+
+            /**
+             * @brief Reúne las ranuras locales que declaran un nombre
+             * @param name Nombre de la variable
+             * @param chain Ligaduras encontradas, de la más interior a la más exterior
+             */
+            void collectLocals(std::string_view name, std::vector<Binding>& chain) {
+                for (auto it = scopes.rbegin(); it != scopes.rend(); ++it) {
+                    auto found = it->slots.find(name);
+                    if (found != it->slots.end()) chain.push_back({Kind::Local, found->second});
+                }
+                if (enclosing) {
+                    std::vector<Binding> outer;
+                    enclosing->collectLocals(name, outer);
+                    for (const auto& binding : outer) {
+                        chain.push_back({Kind::Upvalue, addUpvalue(binding)});
+                    }
+                }
+            }
+
+            /**
+             * @brief Resuelve un nombre a la lista ordenada de lugares donde puede vivir
+             * @param name Nombre de la variable
+             * @return std::vector<Binding> Ligaduras candidatas; la última siempre es global
+             */
+            std::vector<Binding> resolve(std::string_view name) {
+                std::vector<Binding> chain;
+                collectLocals(name, chain);
+                chain.push_back({Kind::Global, globals.intern(name)});
+                return chain;
+            }
+
+            void emitVariable(std::string_view name, OpCode localOp, OpCode upvalueOp, OpCode globalOp) {
+                auto chain = resolve(name);
+                auto offset = static_cast<uint32_t>(chunk().code.size());
+                const Binding& first = chain.front();
+                emitOp(first.kind == Kind::Local ? localOp : first.kind == Kind::Upvalue ? upvalueOp : globalOp);
+                emitU16(first.index);
+                if (chain.size() > 1) {
+                    chunk().fallbacks.emplace_back(offset, std::vector<Binding>(chain.begin() + 1, chain.end()));
+                }
+            }
+
+            void defineVariable(std::string_view name) {
+                if (isGlobalScope()) {
+                    emitOp(OpCode::DefineGlobal);
+                    emitU16(globals.intern(name));
+                } else {
+                    emitOp(OpCode::DefineLocal);
+                    emitU16(scopes.back().slots.find(name)->second);
+                }
+            }
+
+            // ---- Sentencias ----
+
+            void statement(const ASTNode* node) {
+                const auto& children = node->getChildren();
+                switch (node->getType()) {
+                    case Type::Program:
+                        block(node);
+                        return;
+                    case Type::VarDecl:
+                        if (!children.empty()) expression(children[0].get());
+                        else emitOp(OpCode::Nil);
+                        defineVariable(node->getValue());
+                        return;
+                    case Type::Function:
+                        function(node);
+                        return;
+                    case Type::PrintStmt:
+                        if (!children.empty()) {
+                            expression(children[0].get());
+                            emitOp(OpCode::Print);
+                        }
+                        return;
+                    case Type::IfStmt: {
+                        expression(children[0].get());
+                        size_t thenJump = emitJump(OpCode::JumpIfFalse);
+                        emitOp(OpCode::Pop);
+                        statement(children[1].get());
+                        size_t elseJump = emitJump(OpCode::Jump);
+                        patchJump(thenJump);
+                        emitOp(OpCode::Pop);
+                        if (children.size() == 3) statement(children[2].get());
+                        patchJump(elseJump);
+                        return;
+                    }
+                    case Type::WhileStmt: {
+                        size_t loopStart = chunk().code.size();
+                        expression(children[0].get());
+                        size_t exitJump = emitJump(OpCode::JumpIfFalse);
+                        emitOp(OpCode::Pop);
+                        statement(children[1].get());
+                        emitLoop(loopStart);
+                        patchJump(exitJump);
+                        emitOp(OpCode::Pop);
+                        return;
+                    }
+                    case Type::ReturnStmt:
+                        if (!children.empty()) expression(children[0].get());
+                        else emitOp(OpCode::Nil);
+                        emitOp(OpCode::Return);
+                        return;
+                    default:
+                        // Sentencia de expresión: se descarta su valor
+                        expression(node);
+                        emitOp(OpCode::Pop);
+                        return;
+                }
+            }
+
+            void block(const ASTNode* node) {
+                const auto& children = node->getChildren();
+                std::vector<std::string_view> names;
+                for (const auto& child : children) Resolver::collectDeclarations(child.get(), names);
+                beginScope(names);
+                for (size_t i = 0; i < children.size(); ++i) {
+                    enterStatement(i);
+                    statement(children[i].get());
+                    leaveStatement();
+                }
+                endScope();
+            }
+
+            void function(const ASTNode* node) {
+                FunctionCompiler compiler(this, node->getValue(), globals);
+                auto fn = compiler.compileFunction(node);
+                if (chunk().functions.size() > MAX_U16) {
+                    throw Error(ErrorCodes::CompileError, "Too many functions in one chunk.");
+                }
+                chunk().functions.push_back(std::move(fn));
+                emitOp(OpCode::Closure);
+                emitU16(chunk().functions.size() - 1);
+                defineVariable(node->getValue());
+            }
+
+            // ---- Expresiones ----
+
+            void expression(const ASTNode* node) {
+                switch (node->getType()) {
+                    case Type::Number:
+                        emitOp(OpCode::Constant);
+                        emitU16(numberConstant(node->getLiteral().asNumber()));
+                        return;
+                    case Type::String:
+                        emitOp(OpCode::Constant);
+                        emitU16(stringConstant(node->getLiteral().asString()));
+                        return;
+                    case Type::Boolean:
+                        emitOp(node->getLiteral().asBool() ? OpCode::True : OpCode::False);
+                        return;
+                    case Type::Nil:
+                        emitOp(OpCode::Nil);
+                        return;
+                    case Type::Identifier:
+                        emitVariable(node->getValue(), OpCode::GetLocal, OpCode::GetUpvalue, OpCode::GetGlobal);
+                        return;
+                    case Type::Grouping:
+                        expression(node->getChildren()[0].get());
+                        return;
+                    case Type::Unary:
+                        expression(node->getChildren()[0].get());
+                        emitOp(node->getOperator() == Operator::Not ? OpCode::Not : OpCode::Negate);
+                        return;
+                    case Type::Assign:
+                        assignment(node);
+                        return;
+                    case Type::BinaryOp:
+                        operation(node);
+                        return;
+                    case Type::Call:
+                        call(node);
+                        return;
+                    case Type::Array: {
+                        const auto& elements = node->getChildren();
+                        if (elements.size() > MAX_U16) {
+                            throw Error(ErrorCodes::CompileError, "Too many elements in array literal.");
+                        }
+                        for (const auto& element : elements) expression(element.get());
+                        emitOp(OpCode::Array);
+                        emitU16(elements.size());
+                        return;
+                    }
+                    case Type::Index:
+                        expression(node->getChildren()[0].get());
+                        expression(node->getChildren()[1].get());
+                        emitOp(OpCode::GetIndex);
+                        return;
+                    case Type::SetIndex:
+                        // Mismo orden que el evaluador: array, índice y valor
+                        for (const auto& child : node->getChildren()) expression(child.get());
+                        emitOp(OpCode::SetIndex);
+                        return;
+                    default:
+                        throw Error(ErrorCodes::CompileError, "Unexpected statement in expression.");
+                }
+            }
+
+            void assignment(const ASTNode* node) {
+                const auto& children = node->getChildren();
+                const auto* target = children[0].get();
+                if (target->getType() != Type::Identifier) {
+                    throw Error(ErrorCodes::InvalidAssignmentTarget, "Invalid assignment target.");
+                }
+                expression(children[1].get());
+                emitVariable(target->getValue(), OpCode::SetLocal, OpCode::SetUpvalue, OpCode::SetGlobal);
+            }
+
+            void operation(const ASTNode* node) {
+                const auto& children = node->getChildren();
+                const Operator op = node->getOperator();
+                if (op == Operator::Or || op == Operator::And) {
+                    // Cortocircuito: el resultado es el operando que decide
+                    expression(children[0].get());
+                    size_t endJump = emitJump(op == Operator::Or ? OpCode::JumpIfTrue : OpCode::JumpIfFalse);
+                    emitOp(OpCode::Pop);
+                    expression(children[1].get());
+                    patchJump(endJump);
+                    return;
+                }
+                expression(children[0].get());
+                expression(children[1].get());
+                switch (op) {
+                    case Operator::Add:          emitOp(OpCode::Add); return;
+                    case Operator::Subtract:     emitOp(OpCode::Subtract); return;
+                    case Operator::Multiply:     emitOp(OpCode::Multiply); return;
+                    case Operator::Divide:       emitOp(OpCode::Divide); return;
+                    case Operator::Modulo:       emitOp(OpCode::Modulo); return;
+                    case Operator::Equal:        emitOp(OpCode::Equal); return;
+                    case Operator::NotEqual:     emitOp(OpCode::NotEqual); return;
+                    case Operator::Less:         emitOp(OpCode::Less); return;
+                    case Operator::LessEqual:    emitOp(OpCode::LessEqual); return;
+                    case Operator::Greater:      emitOp(OpCode::Greater); return;
+                    case Operator::GreaterEqual: emitOp(OpCode::GreaterEqual); return;
+                    default:
+                        throw Error(ErrorCodes::CompileError, "Unknown binary operator '" + std::string(node->getValue()) + "'.");
+                }
+            }
+
+            void call(const ASTNode* node) {
+                std::string_view name = node->getValue();
+                const auto& args = node->getChildren();
+                if (args.size() > MAX_ARGS) {
+                    throw Error(ErrorCodes::CompileError, "Can't have more than 255 arguments.");
+                }
+                // Igual que el evaluador: se comprueba la aridad antes de evaluar argumentos
+                emitVariable(name, OpCode::GetLocal, OpCode::GetUpvalue, OpCode::GetGlobal);
+                emitOp(OpCode::CheckCall);
+                emitByte(static_cast<uint8_t>(args.size()));
+                emitU16(stringConstant(name));
+                for (const auto& arg : args) expression(arg.get());
+                emitOp(OpCode::Call);
+                emitByte(static_cast<uint8_t>(args.size()));
+            }
+        };
+    }
+
+    std::shared_ptr<FunctionProto> compile(const ASTNode* program, GlobalTable& globals) {
+        FunctionCompiler compiler(nullptr, "script", globals);
+        return compiler.compileScript(program);
+    }
+}
@@ -0,0 +1,46 @@
+/**
+ * @file Compiler.h
+ * @brief Compilador de AST a bytecode para la máquina virtual
+ * @author Javier
+ * @date 2025
+ *
+ * Este archivo define el compilador que transforma el AST producido por
+ * Parser::parseAST en funciones de bytecode (FunctionProto) ejecutables
+ * por la máquina virtual del modo 'run --vm'.
+ */
+
+#ifndef COMPILER_H
+#define COMPILER_H
+
+#include <memory>
+
+#include "../def/ASTNode.h"
+#include "../def/Chunk.h"
+#include "../def/ErrorCode.h"
+
+/**
+ * @namespace Compiler
+ * @brief Espacio de nombres para el compilador a bytecode
+ *
+ * Resuelve en tiempo de compilación la ubicación de cada variable
+ * (ranura local, upvalue o global) y genera el código de cada función.
+ */
+namespace Compiler {
+    /**
+     * @brief Compila un programa completo
+     * @param program Nodo raíz del AST (tipo Program)
+     * @param globals Tabla de globales de la máquina virtual destino
+     * @return std::shared_ptr<TokenTree::FunctionProto> Función de nivel superior ("script")
+     * @throws Error Si el programa excede los límites del bytecode
+     *
+     * Las declaraciones de cada bloque se reservan al entrar en él, de
+     * modo que una función puede referirse a variables del bloque que se
+     * declaran después de ella (por ejemplo, funciones mutuamente recursivas).
+     * Mientras una ranura no ha sido definida, los accesos a ella siguen
+     * buscando en los ámbitos exteriores, igual que Environment::get.
+     */
+    std::shared_ptr<TokenTree::FunctionProto> compile(const TokenTree::ASTNode* program,
+                                                      TokenTree::GlobalTable& globals);
+}
+
+#endif // COMPILER_H
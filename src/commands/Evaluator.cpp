@@ -15,19 +15,32 @@
  * - Funciones definidas por el usuario con soporte para closures
  * - Estructuras de control (if/else, while, for)
  * - Instrucciones print y return
- * - Función nativa clock() para obtener tiempo actual
+ * - Funciones nativas (Native.h), como clock() para medir tiempos
+ * - Arrays (Array.h): literales, lectura y asignación de elementos
  * - Manejo robusto de errores de tiempo de ejecución
  */
 
 #include "Evaluator.h"
 #include "Parser.h"
+#include "Profiler.h"
+#include "Resolver.h"
+#include "Stats.h"
+#include "VM.h"
+#include "../def/Array.h"
 #include "../def/Environment.h"
+#include "../def/Context.h"
+#include "../def/FrameArena.h"
+#include "../def/Native.h"
+#include "../def/Output.h"
+#include "../def/Workers.h"
 #include "../def/ErrorCode.h"
-#include <variant>
 #include <iostream>
 #include <cmath>
+#include <algorithm>
+#include <array>
+#include <charconv>
 #include <string>
-#include <ctime>
+#include <optional>
 
 using namespace TokenTree;
 using namespace Parser;
@@ -38,13 +51,15 @@ namespace Evaluator {
 
     /**
      * @brief Función auxiliar para parsear AST desde tokens
-     * @param tokens Vector de tokens
-     * @return std::unique_ptr<ASTNode> AST resultante
+     * @param lexer Fuente de los tokens
+     * @return std::unique_ptr<AST> AST resultante, ya resuelto
      */
-    std::unique_ptr<ASTNode> parseAST(const std::pmr::vector<Token>& tokens) {
+    std::unique_ptr<AST> parseAST(Tokenizer::Lexer& lexer) {
         // Usa la función interna de Parser para construir el AST
-        // Requiere exponer parseAST en Parser
-        return Parser::parseAST(tokens);
+        // y lo anota con las ranuras de las variables locales
+        auto ast = Parser::parseAST(lexer);
+        Resolver::resolve(ast->root());
+        return ast;
     }
 
     /**
@@ -58,22 +73,542 @@ namespace Evaluator {
      * - Todo lo demás es true
      */
     bool isTruthy(const Value& v) {
-        if (std::holds_alternative<std::monostate>(v)) return false;
-        if (auto b = std::get_if<bool>(&v)) return *b;
+        if (v.isNil()) return false;
+        if (v.isBool()) return v.asBool();
         return true;
     }
 
+    bool valuesEqual(const Value& lv, const Value& rv) {
+        // Solo true si ambos son del mismo tipo y valor (las funciones nunca son iguales)
+        if (lv.isNumber()) return rv.isNumber() && lv.asNumber() == rv.asNumber();
+        if (lv.isString()) return rv.isString() && lv.as<StringObject>()->equals(*rv.as<StringObject>());
+        // Un array solo es igual a sí mismo
+        if (lv.isObject(Object::Kind::Array)) return rv.isObject() && lv.asObject() == rv.asObject();
+        if (lv.isBool()) return rv.isBool() && lv.asBool() == rv.asBool();
+        return lv.isNil() && rv.isNil();
+    }
+
+    /**
+     * @brief Añade la representación de un valor a una concatenación
+     * @param out Texto en construcción
+     * @param v Valor a convertir (cadena, número, booleano o nil)
+     * @return bool false si el valor no puede concatenarse (funciones)
+     */
+    static bool appendText(std::string& out, const Value& v) {
+        if (v.isString()) {
+            out += v.asString();
+        } else if (v.isNumber()) {
+            double d = v.asNumber();
+            out += (std::floor(d) == d) ? std::to_string((long long)d) : std::to_string(d);
+        } else if (v.isBool()) {
+            out += v.asBool() ? "true" : "false";
+        } else if (v.isNil()) {
+            out += "nil";
+        } else {
+            return false;
+        }
+        return true;
+    }
+
+    Value addValues(const Value& lv, const Value& rv) {
+        if (lv.isNumber() && rv.isNumber()) return lv.asNumber() + rv.asNumber();
+        // String concatenation con conversión automática del otro operando
+        if (lv.isString() || rv.isString()) {
+            std::string text;
+            if (appendText(text, lv) && appendText(text, rv)) {
+                if (Stats::active) Stats::active->string(text.size());
+                return makeString(std::move(text));
+            }
+        }
+        // Si no es concatenación válida, la suma requiere números
+        throw Error(ErrorCodes::OperandsMustBeNumbers, "Operands must be numbers.");
+    }
+
+    /**
+     * @brief Concatena dos cadenas (la forma ConcatStrStr de '+')
+     * @param lv Cadena izquierda
+     * @param rv Cadena derecha
+     * @return Value Cadena resultante, igual que addValues(lv, rv)
+     */
+    static Value concatStrings(const Value& lv, const Value& rv) {
+        const std::string& left = lv.asString();
+        const std::string& right = rv.asString();
+        std::string text;
+        text.reserve(left.size() + right.size());
+        text += left;
+        text += right;
+        if (Stats::active) Stats::active->string(text.size());
+        return makeString(std::move(text));
+    }
+
+    /**
+     * @brief Forma especializada que corresponde a los operandos de una operación
+     * @param op Operador del nodo BinaryOp
+     * @param lv Operando izquierdo observado
+     * @param rv Operando derecho observado
+     * @return Specialization Forma NumNum o StrStr, o Generic si no hay ninguna
+     */
+    static Specialization specializationFor(Operator op, const Value& lv, const Value& rv) {
+        if (lv.isNumber() && rv.isNumber()) {
+            switch (op) {
+                case Operator::Add:          return Specialization::AddNumNum;
+                case Operator::Subtract:     return Specialization::SubtractNumNum;
+                case Operator::Multiply:     return Specialization::MultiplyNumNum;
+                case Operator::Divide:       return Specialization::DivideNumNum;
+                case Operator::Modulo:       return Specialization::ModuloNumNum;
+                case Operator::Less:         return Specialization::LessNumNum;
+                case Operator::LessEqual:    return Specialization::LessEqualNumNum;
+                case Operator::Greater:      return Specialization::GreaterNumNum;
+                case Operator::GreaterEqual: return Specialization::GreaterEqualNumNum;
+                case Operator::Equal:        return Specialization::EqualNumNum;
+                case Operator::NotEqual:     return Specialization::NotEqualNumNum;
+                default:                     break;
+            }
+        } else if (op == Operator::Add && lv.isString() && rv.isString()) {
+            return Specialization::ConcatStrStr;
+        }
+        return Specialization::Generic;
+    }
+
+    /**
+     * @brief Da formato a un número como lo muestra print
+     * @param d Número
+     * @param buffer Espacio para el texto
+     * @return std::string_view Texto del número dentro de buffer
+     *
+     * Los enteros se muestran sin decimales y el resto con 6 cifras
+     * significativas (lo mismo que operator<< de iostream por defecto). Los
+     * enteros que no caben en long long, como inf, también usan este formato.
+     */
+    static std::string_view formatNumber(double d, char (&buffer)[32]) {
+        auto result = std::floor(d) == d && std::fabs(d) < 0x1p63
+                          ? std::to_chars(buffer, std::end(buffer), (long long)d)
+                          : std::to_chars(buffer, std::end(buffer), d, std::chars_format::general, 6);
+        return {buffer, static_cast<size_t>(result.ptr - buffer)};
+    }
+
+    /**
+     * @brief Valida el índice de un acceso a un elemento
+     * @param target Valor indexado
+     * @param index Posición
+     * @return size_t Posición ya comprobada dentro del array
+     * @throws Error Si target no es un array o index no es una posición válida
+     */
+    static size_t elementIndex(const Value& target, const Value& index) {
+        if (!target.isObject(Object::Kind::Array)) {
+            throw Error(ErrorCodes::IndexOnNonArray, "Only arrays can be indexed.");
+        }
+        if (!index.isNumber()) throw Error(ErrorCodes::InvalidIndex, "Array index must be a number.");
+        double position = index.asNumber();
+        if (std::floor(position) != position) throw Error(ErrorCodes::InvalidIndex, "Array index must be an integer.");
+        size_t length = target.as<ArrayObject>()->size();
+        if (position < 0 || position >= static_cast<double>(length)) {
+            char buffer[32];
+            throw Error(ErrorCodes::InvalidIndex, "Array index " + std::string(formatNumber(position, buffer)) +
+                        " out of range for length " + std::to_string(length) + ".");
+        }
+        return static_cast<size_t>(position);
+    }
+
+    Value readElement(const Value& target, const Value& index) {
+        size_t position = elementIndex(target, index);
+        return target.as<ArrayObject>()->get(position);
+    }
+
+    void writeElement(const Value& target, const Value& index, const Value& value) {
+        size_t position = elementIndex(target, index);
+        target.as<ArrayObject>()->set(position, value);
+    }
+
+    /**
+     * @brief Escribe un valor con el formato de print en cualquier salida
+     * @tparam Sink std::ostream u Output
+     * @param out Salida
+     * @param value Valor a escribir
+     * @param open Arrays que se están escribiendo (para no repetir los ciclos)
+     */
+    template <class Sink>
+    static void writeValue(Sink& out, const Value& value, std::vector<const ArrayObject*>& open) {
+        if (value.isNil()) {
+            out << std::string_view("nil");
+        } else if (value.isBool()) {
+            out << std::string_view(value.asBool() ? "true" : "false");
+        } else if (value.isNumber()) {
+            char buffer[32];
+            out << formatNumber(value.asNumber(), buffer);
+        }
+        // Funciones definidas
+        else if (value.isObject(Object::Kind::Function)) {
+            out << std::string_view("<fn ") << std::string_view(value.as<LoxFunction>()->name) << '>';
+        }
+        else if (value.isObject(Object::Kind::Closure)) {
+            out << std::string_view("<fn ") << std::string_view(value.as<VM::Closure>()->proto->name) << '>';
+        }
+        else if (value.isObject(Object::Kind::Native)) {
+            out << std::string_view("<native fn>");
+        }
+        else if (value.isString()) {
+            out << std::string_view(value.asString());
+        }
+        else if (value.isObject(Object::Kind::Array)) {
+            const ArrayObject* array = value.as<ArrayObject>();
+            // Un array que se contiene a sí mismo se muestra como [...] al volver a aparecer
+            if (std::find(open.begin(), open.end(), array) != open.end()) {
+                out << std::string_view("[...]");
+                return;
+            }
+            open.push_back(array);
+            out << '[';
+            for (size_t i = 0; i < array->size(); ++i) {
+                if (i > 0) out << std::string_view(", ");
+                writeValue(out, array->get(i), open);
+            }
+            out << ']';
+            open.pop_back();
+        }
+    }
+
+    void printValue(std::ostream& out, const Value& value) {
+        std::vector<const ArrayObject*> open;
+        writeValue(out, value, open);
+    }
+
+    void printValue(Output& out, const Value& value) {
+        std::vector<const ArrayObject*> open;
+        writeValue(out, value, open);
+    }
+
     // Declaraciones de función para evaluación con entorno
-    Value evalNode(const ASTNode* node, std::shared_ptr<Environment> env);
+    Value evalNode(const ASTNode* node, Environment* env);
+    static ExecResult execute(const ASTNode* node, Environment* env);
+
+    /**
+     * @brief Arena de ranuras para los entornos que no escapan
+     * @return FrameArena& Arena del intérprete en ejecución (Context)
+     */
+    static FrameArena& frameArena() {
+        return Context::current().frames;
+    }
+
+    /**
+     * @brief Busca por nombre la variable global de un nodo, usando su caché
+     * @param node Nodo Identifier, Call o destino de un Assign
+     * @param env Entorno actual
+     * @return Value* Valor de la variable global, o nullptr si no existe
+     *
+     * Solo la primera ejecución del nodo (por cada entorno global) calcula
+     * el hash del nombre; las siguientes reutilizan la dirección guardada.
+     * Los workers de parallel_map comparten el AST con otros hilos y no
+     * guardan nada en él: buscan siempre por nombre.
+     */
+    static Value* globalSlot(const ASTNode* node, Environment* env) {
+        Environment& globals = env->global();
+        GlobalCache& cache = node->getGlobalCache();
+        if (cache.globals != globals.getSerial()) {
+            Value* value = globals.findLocal(node->getValue());
+            if (!value) return nullptr; // Aún no definida: se volverá a buscar
+            if (Transfer::active) return value;
+            cache = {globals.getSerial(), value};
+        }
+        return cache.value;
+    }
+
+    /**
+     * @brief Cuenta en las estadísticas la búsqueda de una variable
+     * @param node Identifier, Call o destino de Assign ya resuelto
+     * @param env Entorno desde el que se busca
+     */
+    static void countLookup(const ASTNode* node, const Environment* env) {
+        if (const LocalSlot* slot = env->match(node->getSlots())) Stats::active->lookup(slot->depth);
+        else Stats::active->globalLookup();
+    }
+
+    /**
+     * @brief Lee una variable usando las ranuras calculadas por el resolver
+     * @param node Nodo Identifier o Call ya resuelto
+     * @param env Entorno actual
+     * @return Value Valor de la variable
+     * @throws std::runtime_error Si la variable no está definida
+     */
+    static Value lookup(const ASTNode* node, Environment* env) {
+        if (Stats::active) countLookup(node, env);
+        if (const Value* slot = env->find(node->getSlots())) return *slot;
+        if (const Value* value = globalSlot(node, env)) return *value;
+        return env->global().get(node->getValue());
+    }
+
+    /**
+     * @brief Define la variable de una declaración en su ranura (o global)
+     * @param node Nodo VarDecl o Function ya resuelto
+     * @param env Entorno actual
+     * @param value Valor inicial
+     */
+    static void define(const ASTNode* node, Environment* env, const Value& value) {
+        const auto& slots = node->getSlots();
+        if (slots.empty()) env->define(node->getValue(), value);
+        else env->defineAt(slots.front().index, value);
+    }
 
     /**
      * @brief Evaluación con entorno global por defecto
      * @param node Nodo a evaluar
      * @return Value Resultado de la evaluación
      */
+    /**
+     * @brief Cuenta la evaluación de un nodo si se está perfilando o midiendo
+     * @param node Nodo evaluado (cada uno se cuenta una sola vez por evaluación)
+     * @throws Error BudgetExceeded si la ejecución supera uno de sus límites
+     */
+    static void profileHit(const ASTNode* node) {
+        if (Profiler::active) Profiler::active->hit(node);
+        if (Stats::active) Stats::active->visit(node);
+    }
+
+    static Value tailCall(Value callee);
+
     Value evalNode(const ASTNode* node) {
-        static std::shared_ptr<Environment> globalEnv = std::make_shared<Environment>();
-        return evalNode(node, globalEnv);
+        // Las globales son las del intérprete en ejecución (Context)
+        std::shared_ptr<Environment> globals = Context::current().globals;
+        // Un return de nivel superior termina el programa con su valor
+        ExecResult result = execute(node, globals.get());
+        if (result.flow == Flow::TailCall) return tailCall(std::move(result.value));
+        return std::move(result.value);
+    }
+
+    /**
+     * @brief Ejecuta las sentencias de un bloque o programa en un entorno
+     * @param node Nodo Program con las sentencias
+     * @param env Entorno en el que se ejecutan
+     * @return ExecResult Valor de la última sentencia, o el return que la interrumpió
+     * @throws Error Con la línea de la sentencia que falló añadida al mensaje
+     */
+    static ExecResult executeStatements(const ASTNode* node, Environment* env) {
+        ExecResult last;
+        const auto& children = node->getChildren();
+        for (size_t i = 0; i < children.size(); ++i) {
+            try {
+                last = execute(children[i].get(), env);
+                if (last.flow != Flow::Normal) {
+                    // La línea que esta sentencia añadiría a un error de la llamada de cola
+                    if (last.flow == Flow::TailCall) Context::current().tail.lines.push_back(static_cast<uint32_t>(i + 1));
+                    return last;
+                }
+            } catch (const Error& e) {
+                throw Error(e.type, e.message + "\n[line " + std::to_string(i + 1) + "]");
+            } catch (const std::runtime_error& e) {
+                throw Error(ErrorCodes::RuntimeError, std::string(e.what()) + "\n[line " + std::to_string(i + 1) + "]");
+            }
+        }
+        return last;
+    }
+
+    /**
+     * @class CallFrame
+     * @brief Entorno local de una llamada a una función definida por el usuario
+     *
+     * Se reserva en el heap solo si alguna función declarada en su interior
+     * puede capturarlo; si no, usa ranuras de la arena y un entorno en la
+     * pila de C++.
+     */
+    class CallFrame {
+    public:
+        explicit CallFrame(const LoxFunction* function)
+            : heapEnv(function->frameEscapes ? std::make_shared<Environment>(function->closure, function->frameSize)
+                                             : nullptr),
+              counted(function->frameEscapes) {
+            if (heapEnv) {
+                local = heapEnv.get();
+            } else {
+                frame.emplace(frameArena(), function->frameSize);
+                stackEnv.emplace(function->closure.get(), frame->slots());
+                local = &*stackEnv;
+            }
+            if (Stats::active) Stats::active->call();
+        }
+        CallFrame(const CallFrame&) = delete;
+        CallFrame& operator=(const CallFrame&) = delete;
+
+        Environment* env() const { return local; }
+
+    private:
+        std::shared_ptr<Environment> heapEnv;
+        std::optional<FrameArena::Frame> frame;
+        std::optional<Environment> stackEnv;
+        Environment* local;
+        Stats::EnvironmentScope counted; ///< Se construye cuando heapEnv ya está registrado en el Heap
+    };
+
+    /**
+     * @class TailTrace
+     * @brief Líneas que los marcos eliminados por las llamadas de cola añadirían a un error
+     *
+     * Cada llamada de cola aporta las sentencias que abandonó. Se guardan en
+     * TailCalls::trace como tramos [número de líneas, repeticiones, líneas...]
+     * y una aportación igual a la anterior solo incrementa su contador, de
+     * modo que una función con recursión de cola no gasta memoria por vuelta.
+     * Una recursión mutua alterna tramos distintos: se conservan los
+     * TailCalls::KEPT_RUNS primeros y los KEPT_RUNS últimos, y de los de en
+     * medio solo se cuentan sus marcos.
+     */
+    class TailTrace {
+    public:
+        explicit TailTrace(std::vector<size_t>& stack) : stack(stack), base(stack.size()), last(stack.size()) {}
+        ~TailTrace() { stack.resize(base); }
+        TailTrace(const TailTrace&) = delete;
+        TailTrace& operator=(const TailTrace&) = delete;
+
+        /**
+         * @brief Añade las sentencias que abandonó una llamada de cola
+         * @param lines Índices de sentencia, del bloque más interno al cuerpo de la función
+         */
+        void add(const std::vector<uint32_t>& lines) {
+            if (last < stack.size() && stack[last] == lines.size() &&
+                std::equal(lines.begin(), lines.end(), stack.begin() + last + 2)) {
+                ++stack[last + 1];
+                return;
+            }
+            if (runs == 2 * TailCalls::KEPT_RUNS) {
+                // Descartar el más antiguo de los últimos tramos
+                size_t oldest = runStart(TailCalls::KEPT_RUNS);
+                size_t length = 2 + stack[oldest];
+                elided += stack[oldest + 1];
+                stack.erase(stack.begin() + oldest, stack.begin() + oldest + length);
+                --runs;
+            }
+            last = stack.size();
+            stack.push_back(lines.size());
+            stack.push_back(1);
+            stack.insert(stack.end(), lines.begin(), lines.end());
+            ++runs;
+        }
+
+        /**
+         * @brief Construye el sufijo de un error, de la llamada más reciente a la más antigua
+         * @return std::string Líneas "\n[line N]" que habrían añadido los marcos eliminados
+         */
+        std::string render() const {
+            std::vector<size_t> starts;
+            for (size_t at = base; at < stack.size(); at += 2 + stack[at]) starts.push_back(at);
+            std::string suffix;
+            for (size_t run = starts.size(); run-- > 0;) {
+                if (elided && run + 1 == TailCalls::KEPT_RUNS) {
+                    suffix += "\n[... " + std::to_string(elided) + " more frames]";
+                }
+                size_t at = starts[run];
+                for (size_t repeat = 0; repeat < stack[at + 1]; ++repeat) {
+                    for (size_t i = 0; i < stack[at]; ++i) {
+                        suffix += "\n[line " + std::to_string(stack[at + 2 + i]) + "]";
+                    }
+                }
+            }
+            return suffix;
+        }
+
+    private:
+        std::vector<size_t>& stack; ///< Pila compartida por las llamadas activas
+        size_t base;                ///< Inicio de los tramos de esta llamada
+        size_t last;                ///< Inicio del último tramo (o fin de la pila si no hay)
+        size_t runs = 0;            ///< Tramos de esta llamada en la pila
+        size_t elided = 0;          ///< Marcos de los tramos descartados
+
+        /// @brief Posición del tramo número index de esta llamada
+        size_t runStart(size_t index) const {
+            size_t at = base;
+            for (size_t i = 0; i < index; ++i) at += 2 + stack[at];
+            return at;
+        }
+    };
+
+    /**
+     * @brief Ejecuta las llamadas de cola encadenadas a partir de una pendiente
+     * @param callee Función que se llama (sus argumentos están en TailCalls::args)
+     * @return Value Valor que retorna la última función de la cadena
+     * @throws Error Con las líneas de los marcos eliminados añadidas al mensaje
+     *
+     * Cada vuelta libera el entorno de la función anterior antes de crear el
+     * de la siguiente, así que la pila de C++ y la arena no crecen.
+     */
+    static Value tailCall(Value callee) {
+        TailCalls& tail = Context::current().tail;
+        TailTrace trace(tail.trace);
+        while (true) {
+            trace.add(tail.lines);
+            const LoxFunction* function = callee.as<LoxFunction>();
+            ExecResult result;
+            try {
+                CallFrame frame(function);
+                for (size_t i = 0; i < tail.args.size(); ++i) {
+                    frame.env()->defineAt(function->paramSlots[i], std::move(tail.args[i]));
+                }
+                tail.args.clear();
+                Profiler::Scope profiled(function->body, function->name);
+                result = execute(function->body, frame.env());
+            } catch (const Error& e) {
+                throw Error(e.type, e.message + trace.render());
+            }
+            if (result.flow != Flow::TailCall) {
+                return result.flow == Flow::Return ? std::move(result.value) : Value();
+            }
+            callee = std::move(result.value);
+        }
+    }
+
+    /**
+     * @brief Llama a una función nativa (o falla si el valor no es invocable)
+     * @param node Nodo Call
+     * @param callee Valor al que se refiere el nombre llamado
+     * @param env Entorno en el que se evalúan los argumentos
+     * @return Value Resultado de la función nativa
+     * @throws Error Si no es una función o el número de argumentos no coincide
+     */
+    static Value callNative(const ASTNode* node, const Value& callee, Environment* env) {
+        // Función nativa: argumentos en un búfer local, sin entorno
+        if (callee.isObject(Object::Kind::Native)) {
+            const NativeFunction* native = callee.as<NativeFunction>();
+            const auto& args = node->getChildren();
+            if (args.size() != native->arity) {
+                throw Error(ErrorCodes::ArgumentCountMismatch, "Expected " + std::to_string(native->arity) + " args but got " + std::to_string(args.size()) + ".");
+            }
+            std::array<Value, NativeFunction::MAX_ARITY> values;
+            for (size_t i = 0; i < args.size(); ++i) values[i] = evalNode(args[i].get(), env);
+            Profiler::Scope profiled(native, native->name);
+            if (Stats::active) Stats::active->nativeCall();
+            return native->fn(values.data());
+        }
+        // No es una función
+        throw Error(ErrorCodes::CallOnNonFunction, "Attempt to call non-function '" + std::string(node->getValue()) + "'.");
+    }
+
+    /**
+     * @brief Comprueba el número de argumentos de una llamada
+     * @throws Error Si no coincide con el de parámetros de la función
+     */
+    static void checkArity(const LoxFunction* function, size_t count) {
+        if (count != function->params.size()) {
+            throw Error(ErrorCodes::ArgumentCountMismatch, "Expected " + std::to_string(function->params.size()) + " args but got " + std::to_string(count) + ".");
+        }
+    }
+
+    Value LoxFunction::transfer(Transfer& transfer) const {
+        auto copy = makeRef<LoxFunction>(name, params, body, nullptr, paramSlots, frameSize, frameEscapes);
+        // Antes que el entorno: lo normal es que la propia función esté guardada en él
+        transfer.remember(this, copy);
+        copy->closure = transfer.copy(closure.get());
+        return copy;
+    }
+
+    Value LoxFunction::call(const Value* args, size_t count) const {
+        checkArity(this, count);
+        ExecResult result;
+        {
+            CallFrame frame(this);
+            for (size_t i = 0; i < count; ++i) frame.env()->defineAt(paramSlots[i], args[i]);
+            Profiler::Scope profiled(body, name);
+            result = execute(body, frame.env());
+        }
+        if (result.flow == Flow::TailCall) return tailCall(std::move(result.value));
+        if (result.flow == Flow::Return) return std::move(result.value);
+        return Value();
     }
 
     /**
@@ -82,331 +617,343 @@ namespace Evaluator {
      * @param env Entorno de ejecución
      * @return Value Resultado de la evaluación
      * @throws Error Para errores de tiempo de ejecución
-     * @throws ReturnException Para instrucciones return
      * 
      * Esta función implementa el núcleo del intérprete, manejando todos
      * los tipos de nodos del AST y ejecutando las operaciones correspondientes.
      * Utiliza recursión para evaluar subexpresiones y mantiene el estado
      * del programa a través del entorno de variables.
      */
-    Value evalNode(const ASTNode* node, std::shared_ptr<Environment> env) {
+    Value evalNode(const ASTNode* node, Environment* env) {
         using Type = ASTNode::Type;
+        profileHit(node);
 
         switch (node->getType()) {
             case Type::Function: {
                 // Declaración de función user-defined con parámetros
                 {
-                    const auto& name = node->getValue();
+                    std::string name(node->getValue());
                     const auto& children = node->getChildren();
                     // Último hijo es el cuerpo, los anteriores son parámetros
                     std::vector<std::string> params;
+                    std::vector<uint32_t> paramSlots;
                     for (size_t i = 0; i + 1 < children.size(); ++i) {
-                        params.push_back(children[i]->getValue());
+                        params.emplace_back(children[i]->getValue());
+                        paramSlots.push_back(children[i]->getSlots().front().index);
                     }
                     const ASTNode* body = children.back().get();
-                    auto func = std::make_shared<LoxFunction>(name, params, body, env);
-                    env->define(node->getValue(), func);
+                    // El resolver garantiza que el entorno de una declaración vive en el heap
+                    auto func = makeRef<LoxFunction>(std::move(name), params, body, env->shared_from_this(),
+                                                              std::move(paramSlots), node->getScopeSize(),
+                                                              node->isCaptured());
+                    define(node, env, func);
+                    // Punto seguro del recolector de ciclos: la función ya está completa y guardada
+                    Context::current().heap.poll();
                     return func;
                 }
             }
             case Type::VarDecl: {
-                Value val = std::monostate{};
+                Value val;
                 if (!node->getChildren().empty()) {
                     val = evalNode(node->getChildren()[0].get(), env);
                 }
-                env->define(node->getValue(), val);
+                define(node, env, val);
                 return val;
             }
             case Type::Identifier: {
-                return env->get(node->getValue());
+                return lookup(node, env);
             }
             case Type::Number: {
-                return std::stod(node->getValue());
+                return node->getLiteral();
             }
             case Type::Boolean: {
-                return node->getValue() == "true";
+                return node->getLiteral();
             }
             case Type::Nil: {
-                return std::monostate{};
+                return Value();
             }
             case Type::String: {
-                return node->getValue();
+                // El objeto del literal es del intérprete que parseó: un worker usa su copia
+                if (Transfer::active) return Transfer::active->copy(node->getLiteral());
+                return node->getLiteral();
             }
-            case Type::BinaryOp: {
-                const auto& op = node->getValue();
-                const auto& children = node->getChildren();
+            case Type::Assign: {
                 // Asignación: a = b (right-associative)
-                if (op == "=" && children.size() == 2) {
-                    // Validar target
-                    const auto* target = children[0].get();
-                    if (target->getType() != ASTNode::Type::Identifier) {
-                        throw Error(ErrorCodes::InvalidAssignmentTarget, "Invalid assignment target.");
-                    }
-                    // Evaluar valor
-                    Value val = evalNode(children[1].get(), env);
-                    // Asignar en entorno (lanza std::runtime_error si no existe)
-                    env->assign(target->getValue(), val);
-                    return val;
+                const auto& children = node->getChildren();
+                // Validar target
+                const auto* target = children[0].get();
+                if (target->getType() != ASTNode::Type::Identifier) {
+                    throw Error(ErrorCodes::InvalidAssignmentTarget, "Invalid assignment target.");
                 }
-                // Lógica OR: devuelve operand0 si truthy, sino operand1
-                if (op == "or" && children.size() == 2) {
-                    Value left = evalNode(children[0].get(), env);
-                    if (isTruthy(left)) return left;
-                    return evalNode(children[1].get(), env);
+                // Evaluar valor
+                Value val = evalNode(children[1].get(), env);
+                // Asignar en entorno (lanza std::runtime_error si no existe)
+                if (Stats::active) countLookup(target, env);
+                if (Value* slot = env->find(target->getSlots())) *slot = val;
+                else if (Value* global = globalSlot(target, env)) *global = val;
+                else env->global().assign(target->getValue(), val);
+                return val;
+            }
+            case Type::Grouping: {
+                return evalNode(node->getChildren()[0].get(), env);
+            }
+            case Type::Array: {
+                const auto& elements = node->getChildren();
+                auto array = makeRef<ArrayObject>();
+                array->reserve(elements.size());
+                for (const auto& element : elements) array->push(evalNode(element.get(), env));
+                // Punto seguro del recolector de ciclos: el array ya está completo
+                Context::current().heap.poll();
+                return array;
+            }
+            case Type::Index: {
+                const auto& children = node->getChildren();
+                Value target = evalNode(children[0].get(), env);
+                Value index = evalNode(children[1].get(), env);
+                return readElement(target, index);
+            }
+            case Type::SetIndex: {
+                // a[i] = v: se evalúan el array, el índice y el valor, en ese orden
+                const auto& children = node->getChildren();
+                Value target = evalNode(children[0].get(), env);
+                Value index = evalNode(children[1].get(), env);
+                Value val = evalNode(children[2].get(), env);
+                writeElement(target, index, val);
+                return val;
+            }
+            case Type::Unary: {
+                Value operand = evalNode(node->getChildren()[0].get(), env);
+                if (node->getOperator() == Operator::Not) {
+                    return !isTruthy(operand);
+                }
+                if (!operand.isNumber()) {
+                    throw Error(ErrorCodes::OperandMustBeNumber, "Operand must be a number.");
                 }
-                // Lógica AND: devuelve operand0 si falsy (short-circuit), sino operand1
-                if (op == "and" && children.size() == 2) {
+                return -operand.asNumber();
+            }
+            case Type::BinaryOp: {
+                const auto& children = node->getChildren();
+                const Operator op = node->getOperator();
+                // Lógica OR / AND: devuelven el operando que decide (short-circuit)
+                if (op == Operator::Or || op == Operator::And) {
                     Value left = evalNode(children[0].get(), env);
-                    if (!isTruthy(left)) return left;
+                    if (isTruthy(left) == (op == Operator::Or)) return left;
                     return evalNode(children[1].get(), env);
                 }
-                // Handle unary operators (single child)
-                if (op == "!" && children.size() == 1) {
-                    Value v = evalNode(children[0].get(), env);
-                    return !isTruthy(v);
-                }
-                if (op == "-" && children.size() == 1) {
-                    Value operand = evalNode(children[0].get(), env);
-                    if (!std::holds_alternative<double>(operand)) {
-                        throw Error(ErrorCodes::OperandMustBeNumber, "Operand must be a number.");
+                Value lv = evalNode(children[0].get(), env);
+                Value rv = evalNode(children[1].get(), env);
+                // Forma especializada: una sola comprobación de tipos y la operación directa
+                const Specialization form = node->getSpecialization();
+                if (lv.isNumber() && rv.isNumber()) {
+                    const double a = lv.asNumber();
+                    const double b = rv.asNumber();
+                    switch (form) {
+                        case Specialization::AddNumNum:          return a + b;
+                        case Specialization::SubtractNumNum:     return a - b;
+                        case Specialization::MultiplyNumNum:     return a * b;
+                        case Specialization::DivideNumNum:       return a / b;
+                        case Specialization::ModuloNumNum:       return std::fmod(a, b);
+                        case Specialization::LessNumNum:         return a < b;
+                        case Specialization::LessEqualNumNum:    return a <= b;
+                        case Specialization::GreaterNumNum:      return a > b;
+                        case Specialization::GreaterEqualNumNum: return a >= b;
+                        case Specialization::EqualNumNum:        return a == b;
+                        case Specialization::NotEqualNumNum:     return a != b;
+                        default:                                 break;
                     }
-                    double v = std::get<double>(operand);
-                    return -v;
+                } else if (form == Specialization::ConcatStrStr && lv.isString() && rv.isString()) {
+                    return concatStrings(lv, rv);
                 }
-                // Handle grouping
-                if (op == "group" && children.size() == 1) {
-                    return evalNode(children[0].get(), env);
-                }                // Handle binary arithmetic operators
-                if (children.size() == 2 && (op == "+" || op == "-" || op == "*" || op == "/" || op == "%")) {
-                    Value lv = evalNode(children[0].get(), env);
-                    Value rv = evalNode(children[1].get(), env);
-                    if (op == "+") {
-                        // String concatenation con conversión automática
-                        if (auto ls = std::get_if<std::string>(&lv)) {
-                            if (auto rs = std::get_if<std::string>(&rv)) {
-                                return *ls + *rs;
-                            } else if (auto rd = std::get_if<double>(&rv)) {
-                                // String + Number
-                                std::string numStr = (std::floor(*rd) == *rd) ? 
-                                    std::to_string((long long)*rd) : std::to_string(*rd);
-                                return *ls + numStr;
-                            } else if (auto rb = std::get_if<bool>(&rv)) {
-                                // String + Boolean
-                                return *ls + (*rb ? "true" : "false");
-                            } else if (std::holds_alternative<std::monostate>(rv)) {
-                                // String + nil
-                                return *ls + "nil";
-                            }
-                        } else if (auto ld = std::get_if<double>(&lv)) {
-                            if (auto rs = std::get_if<std::string>(&rv)) {
-                                // Number + String
-                                std::string numStr = (std::floor(*ld) == *ld) ? 
-                                    std::to_string((long long)*ld) : std::to_string(*ld);
-                                return numStr + *rs;
-                            }
-                        } else if (auto lb = std::get_if<bool>(&lv)) {
-                            if (auto rs = std::get_if<std::string>(&rv)) {
-                                // Boolean + String
-                                return (*lb ? "true" : "false") + *rs;
-                            }
-                        } else if (std::holds_alternative<std::monostate>(lv)) {
-                            if (auto rs = std::get_if<std::string>(&rv)) {
-                                // nil + String
-                                return "nil" + *rs;
-                            }
-                        }
-                        
-                        // Si llegamos aquí con +, pero no es concatenación válida, seguir con aritmética
-                    }
-                    // Operaciones numéricas (-, *, /, %) requieren números
-                    if (!std::holds_alternative<double>(lv) || !std::holds_alternative<double>(rv)) {
-                        throw Error(ErrorCodes::OperandsMustBeNumbers, "Operands must be numbers.");
-                    }
-                    double left = std::get<double>(lv);
-                    double right = std::get<double>(rv);
-                    if (op == "+") return left + right;
-                    if (op == "-") return left - right;
-                    if (op == "*") return left * right;
-                    if (op == "/") return left / right;
-                    if (op == "%") return std::fmod(left, right);
+                // Primera ejecución: se especializa según los tipos vistos. Si
+                // falla la comprobación de una forma especializada, el nodo
+                // queda en la genérica para no alternar entre formas
+                if (form != Specialization::Generic) {
+                    node->specialize(form == Specialization::Unseen ? specializationFor(op, lv, rv)
+                                                                    : Specialization::Generic);
                 }
-                // Handle equality
-                if (children.size() == 2 && (op == "==" || op == "!=")) {
-                    Value lv = evalNode(children[0].get(), env);
-                    Value rv = evalNode(children[1].get(), env);
-                    bool eq = false;
-                    // Solo true si ambos son del mismo tipo y valor
-                    if (auto ld = std::get_if<double>(&lv)) {
-                        if (auto rd = std::get_if<double>(&rv)) {
-                            eq = (*ld == *rd);
-                        } else {
-                            eq = false;
-                        }
-                    } else if (auto ls = std::get_if<std::string>(&lv)) {
-                        if (auto rs = std::get_if<std::string>(&rv)) {
-                            eq = (*ls == *rs);
-                        } else {
-                            eq = false;
-                        }
-                    } else if (auto lb = std::get_if<bool>(&lv)) {
-                        if (auto rb = std::get_if<bool>(&rv)) {
-                            eq = (*lb == *rb);
-                        } else {
-                            eq = false;
-                        }
-                    } else if (std::holds_alternative<std::monostate>(lv) && std::holds_alternative<std::monostate>(rv)) {
-                        eq = true;
-                    } else {
-                        eq = false;
-                    }
-                    return op == "==" ? eq : !eq;
+                switch (op) {
+                    case Operator::Add:
+                        return addValues(lv, rv);
+                    case Operator::Equal:
+                        return valuesEqual(lv, rv);
+                    case Operator::NotEqual:
+                        return !valuesEqual(lv, rv);
+                    default:
+                        break;
                 }
-                // Handle comparison
-                if (children.size() == 2 && (op == "<" || op == ">" || op == "<=" || op == ">=")) {
-                    Value lv = evalNode(children[0].get(), env);
-                    Value rv = evalNode(children[1].get(), env);
-                    // Ambos deben ser del mismo tipo y deben ser números
-                    if (lv.index() != rv.index() || !std::holds_alternative<double>(lv)) {
-                        throw Error(ErrorCodes::OperandsMustBeNumbers, "Operands must be numbers.");
-                    }
-                    double left = std::get<double>(lv);
-                    double right = std::get<double>(rv);
-                    if (op == "<") return left < right;
-                    if (op == ">") return left > right;
-                    if (op == "<=") return left <= right;
-                    if (op == ">=") return left >= right;
+                // Las operaciones restantes (aritméticas y comparaciones) requieren números
+                if (!lv.isNumber() || !rv.isNumber()) {
+                    throw Error(ErrorCodes::OperandsMustBeNumbers, "Operands must be numbers.");
                 }
-                break;
-            }
-            case Type::Program: {
-                // Ejecutar todos los hijos (statements), con entorno local si es bloque
-                bool isBlock = (node->getValue() == "block");
-                // Si es un bloque, crear entorno anidado que hereda de env, sino usar env
-                auto execEnv = isBlock ? std::make_shared<Environment>(env) : env;
-                Value last = std::monostate{};
-                const auto& children = node->getChildren();
-                for (size_t i = 0; i < children.size(); ++i) {
-                    try {
-                        last = evalNode(children[i].get(), execEnv);
-                    } catch (const Error& e) {
-                        throw Error(e.type, e.message + "\n[line " + std::to_string(i + 1) + "]");
-                    } catch (const std::runtime_error& e) {
-                        throw Error(ErrorCodes::RuntimeError, std::string(e.what()) + "\n[line " + std::to_string(i + 1) + "]");
-                    }
+                double left = lv.asNumber();
+                double right = rv.asNumber();
+                switch (op) {
+                    case Operator::Subtract:     return left - right;
+                    case Operator::Multiply:     return left * right;
+                    case Operator::Divide:       return left / right;
+                    case Operator::Modulo:       return std::fmod(left, right);
+                    case Operator::Less:         return left < right;
+                    case Operator::LessEqual:    return left <= right;
+                    case Operator::Greater:      return left > right;
+                    case Operator::GreaterEqual: return left >= right;
+                    default:                     break;
                 }
-                return last;
+                break;
             }
             case Type::PrintStmt: {
                 // Evaluar la expresión hija y mostrarla
                 if (!node->getChildren().empty()) {
                     Value value = evalNode(node->getChildren()[0].get(), env);
-                    if (std::holds_alternative<std::monostate>(value)) {
-                        std::cout << "nil";
-                    } else if (auto b = std::get_if<bool>(&value)) {
-                        std::cout << (*b ? "true" : "false");
-                    } else if (auto d = std::get_if<double>(&value)) {
-                        if (std::floor(*d) == *d) std::cout << (long long)*d;
-                        else std::cout << *d;
-                    }
-                    // Funciones definidas
-                    else if (auto f = std::get_if<FunctionPtr>(&value)) {
-                        std::cout << "<fn " << (*f)->name << ">";
-                    }
-                    else if (auto s = std::get_if<std::string>(&value)) {
-                        std::cout << *s;
+                    Output& out = Context::current().output;
+                    printValue(out, value);
+                    out.endLine();
+                }
+                return Value();
+            }
+            case Type::Call: {
+                // Obtener función definida o variable
+                Value callee = lookup(node, env);
+                if (!callee.isObject(Object::Kind::Function)) return callNative(node, callee, env);
+                // Función definida por usuario: callee la mantiene viva durante la llamada
+                const LoxFunction* function = callee.as<LoxFunction>();
+                const auto& args = node->getChildren();
+                checkArity(function, args.size());
+                ExecResult result;
+                {
+                    CallFrame frame(function);
+                    // Evaluar y definir parámetros
+                    for (size_t i = 0; i < args.size(); ++i) {
+                        Value val = evalNode(args[i].get(), env);
+                        frame.env()->defineAt(function->paramSlots[i], val);
                     }
-                    std::cout << std::endl;
+                    // Ejecutar cuerpo de función: solo un return aporta valor
+                    Profiler::Scope profiled(function->body, function->name);
+                    result = execute(function->body, frame.env());
+                }
+                // Un return f(...) continúa aquí, ya liberado el marco de esta función
+                if (result.flow == Flow::TailCall) return tailCall(std::move(result.value));
+                if (result.flow == Flow::Return) return std::move(result.value);
+                return Value();
+            }
+            default:
+                break;
+        }
+        return Value();
+    }
+
+    /**
+     * @brief Ejecuta una sentencia propagando return sin excepciones
+     * @param node Sentencia a ejecutar
+     * @param env Entorno de ejecución
+     * @return ExecResult Valor de la sentencia y si terminó con return
+     * @throws Error Para errores de tiempo de ejecución
+     *
+     * Maneja las sentencias que contienen otras sentencias (bloques, if,
+     * while) y return; el resto se delega en evalNode.
+     */
+    static ExecResult execute(const ASTNode* node, Environment* env) {
+        using Type = ASTNode::Type;
+
+        switch (node->getType()) {
+            case Type::Program: {
+                profileHit(node);
+                // Ejecutar todos los hijos (statements), con entorno local si es bloque
+                if (node->getValue() != "block") {
+                    return executeStatements(node, env);
+                }
+                // Un bloque que alguna closure puede capturar necesita un entorno en el heap;
+                // el resto usa ranuras de la arena y un entorno en la pila de C++
+                if (node->isCaptured()) {
+                    auto blockEnv = std::make_shared<Environment>(env->shared_from_this(), node->getScopeSize());
+                    Stats::EnvironmentScope counted(true);
+                    return executeStatements(node, blockEnv.get());
                 }
-                return std::monostate{};
+                FrameArena::Frame frame(frameArena(), node->getScopeSize());
+                Environment blockEnv(env, frame.slots());
+                Stats::EnvironmentScope counted(false);
+                return executeStatements(node, &blockEnv);
             }
             case Type::IfStmt: {
+                profileHit(node);
                 // Evaluar condición y ejecutar rama then o else
                 Value cond = evalNode(node->getChildren()[0].get(), env);
                 if (isTruthy(cond)) {
-                    return evalNode(node->getChildren()[1].get(), env);
+                    return execute(node->getChildren()[1].get(), env);
                 }
                 // Ejecutar rama else si existe
                 if (node->getChildren().size() == 3) {
-                    return evalNode(node->getChildren()[2].get(), env);
+                    return execute(node->getChildren()[2].get(), env);
                 }
-                return std::monostate{};
+                return {};
             }
             case Type::WhileStmt: {
+                profileHit(node);
                 // Ejecutar bucle while: evaluar condición y ejecutar cuerpo mientras sea truthy
                 while (true) {
                     Value cond = evalNode(node->getChildren()[0].get(), env);
                     if (!isTruthy(cond)) break;
-                    evalNode(node->getChildren()[1].get(), env);
+                    ExecResult body = execute(node->getChildren()[1].get(), env);
+                    if (body.flow != Flow::Normal) return body;
                 }
-                return std::monostate{};
+                return {};
             }
             case Type::ReturnStmt: {
+                profileHit(node);
                 // Devolver valor desde una función
-                Value retVal = std::monostate{};
-                if (!node->getChildren().empty()) {
-                    retVal = evalNode(node->getChildren()[0].get(), env);
-                }
-                throw ReturnException(retVal);
-            }
-            case Type::Call: {
-                const auto& name = node->getValue();
-                // Función nativa 'clock'
-                if (name == "clock") {
-                    double t = static_cast<double>(std::time(nullptr));
-                    return t;
+                ExecResult result{Flow::Return, Value()};
+                if (node->getChildren().empty()) return result;
+                const ASTNode* value = node->getChildren()[0].get();
+                if (value->getType() != Type::Call) {
+                    result.value = evalNode(value, env);
+                    return result;
                 }
-                // Obtener función definida o variable
-                Value callee = env->get(name);
-                // Función definida por usuario con parámetros
-                if (auto funcPtr = std::get_if<FunctionPtr>(&callee)) {
-                    auto function = *funcPtr;
-                    const auto& args = node->getChildren();
-                    // Verificar número de argumentos
-                    if (args.size() != function->params.size()) {
-                        throw Error(ErrorCodes::ArgumentCountMismatch, "Expected " + std::to_string(function->params.size()) + " args but got " + std::to_string(args.size()) + ".");
-                    }
-                    // Crear nuevo entorno con closure de la función
-                    auto localEnv = std::make_shared<Environment>(function->closure);
-                    // Evaluar y definir parámetros
-                    for (size_t i = 0; i < args.size(); ++i) {
-                        Value val = evalNode(args[i].get(), env);
-                        localEnv->define(function->params[i], val);
-                    }
-                    // Ejecutar cuerpo de función capturando return
-                    try {
-                        evalNode(function->body, localEnv);
-                        return std::monostate{};
-                    } catch (const ReturnException& ret) {
-                        return ret.value;
-                    }
+                // return f(...): los errores de la búsqueda, la aridad y los
+                // argumentos se producen aquí, como en una llamada normal
+                profileHit(value);
+                Value callee = lookup(value, env);
+                if (!callee.isObject(Object::Kind::Function)) {
+                    result.value = callNative(value, callee, env);
+                    return result;
                 }
-                // No es una función
-                throw Error(ErrorCodes::CallOnNonFunction, "Attempt to call non-function '" + name + "'.");
+                const auto& args = value->getChildren();
+                checkArity(callee.as<LoxFunction>(), args.size());
+                // Los argumentos se evalúan en un marco temporal: otras llamadas
+                // de cola dentro de ellos usan TailCalls mientras tanto
+                FrameArena::Frame values(frameArena(), args.size());
+                for (size_t i = 0; i < args.size(); ++i) values.slots()[i] = evalNode(args[i].get(), env);
+                TailCalls& tail = Context::current().tail;
+                tail.args.assign(std::make_move_iterator(values.slots()), std::make_move_iterator(values.slots() + args.size()));
+                tail.lines.clear();
+                return {Flow::TailCall, std::move(callee)};
             }
             default:
-                break;
+                return {Flow::Normal, evalNode(node, env)};
         }
-        return std::monostate{};
     }
 
-    int evaluate(const std::pmr::vector<Token>& tokens) {
+    int evaluate(Tokenizer::Lexer& lexer) {
         try {
-            auto ast = parseAST(tokens);
-            Value result = evalNode(ast.get());
-            if (std::holds_alternative<std::monostate>(result)) {
+            auto ast = parseAST(lexer);
+            // Los errores léxicos tienen prioridad sobre cualquier otro
+            if (int code = lexer.finish()) return code;
+            Value result = evalNode(ast->root());
+            Context::current().output.flush(); // Lo impreso con print va antes que el resultado
+            if (result.isNil()) {
                 std::cout << "nil";
-            } else if (auto b = std::get_if<bool>(&result)) {
-                std::cout << (*b ? "true" : "false");
-            } else if (auto d = std::get_if<double>(&result)) {
+            } else if (result.isBool()) {
+                std::cout << (result.asBool() ? "true" : "false");
+            } else if (result.isNumber()) {
                 // imprimir sin .0 si es entero
-                if (std::floor(*d) == *d) std::cout << (long long)*d;
-                else std::cout << *d;
-            } else if (auto s = std::get_if<std::string>(&result)) {
-                std::cout << *s;
+                double d = result.asNumber();
+                if (std::floor(d) == d) std::cout << (long long)d;
+                else std::cout << d;
+            } else if (result.isString()) {
+                std::cout << result.asString();
             }
             std::cout << std::endl;
             return 0;
         } catch (const Error& e) {
+            if (int code = lexer.finish()) return code;
+            Context::current().output.flush();
             std::cerr << e.message;
             return e.type.code;
         }
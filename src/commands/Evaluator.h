@@ -12,12 +12,14 @@
 #ifndef EVALUATOR_H
 #define EVALUATOR_H
 
-#include <memory_resource>
+#include <ostream>
 #include <vector>
+#include "Tokenizer.h"
 #include "../def/Tokens.h"
 #include "../def/ASTNode.h"
 #include "../def/Environment.h"
 #include "../def/ErrorCode.h"
+#include "../def/Output.h"
 
 /**
  * @namespace Evaluator
@@ -46,12 +48,17 @@ namespace Evaluator {
      * Estructura que encapsula toda la información necesaria para
      * representar y ejecutar funciones definidas en el código fuente,
      * incluyendo soporte para closures y captura de entorno.
+     * Es un objeto del heap referenciado directamente por Value, y un
+     * contenedor del Heap: el entorno que captura suele guardarla a ella.
      */
-    struct LoxFunction { 
+    struct LoxFunction : TokenTree::Object, TokenTree::Collectable {
         std::string name;                               ///< Nombre de la función
         std::vector<std::string> params;               ///< Lista de parámetros
         const TokenTree::ASTNode* body;                ///< Cuerpo de la función (AST)
         std::shared_ptr<TokenTree::Environment> closure; ///< Entorno capturado (closure)
+        std::vector<uint32_t> paramSlots;              ///< Ranura de cada parámetro
+        uint32_t frameSize;                            ///< Ranuras del entorno de parámetros
+        bool frameEscapes;                             ///< El entorno de cada llamada puede ser capturado
         
         /**
          * @brief Constructor de LoxFunction
@@ -59,53 +66,139 @@ namespace Evaluator {
          * @param params Vector de nombres de parámetros
          * @param body Puntero al nodo AST del cuerpo de la función
          * @param closure Entorno capturado para closures
+         * @param paramSlots Ranura de cada parámetro (calculada por el resolver)
+         * @param frameSize Número de ranuras del entorno de parámetros
+         * @param frameEscapes true si una closure puede capturar el entorno de una llamada
          */
         LoxFunction(std::string name, std::vector<std::string> params, 
-                   const TokenTree::ASTNode* body, std::shared_ptr<TokenTree::Environment> closure) 
-            : name(std::move(name)), params(std::move(params)), body(body), closure(closure) {} 
+                   const TokenTree::ASTNode* body, std::shared_ptr<TokenTree::Environment> closure,
+                   std::vector<uint32_t> paramSlots, uint32_t frameSize, bool frameEscapes)
+            : Object(Object::Kind::Function), name(std::move(name)), params(std::move(params)), body(body), closure(closure),
+              paramSlots(std::move(paramSlots)), frameSize(frameSize), frameEscapes(frameEscapes) {
+            track(Type::Function);
+        }
+
+        TokenTree::Collectable* collectable() override { return this; }
+
+        /// Copia: el mismo cuerpo con una copia del entorno capturado
+        Value transfer(TokenTree::Transfer& transfer) const override;
+
+        /// Ejecuta la función con argumentos ya evaluados (parallel_map)
+        Value call(const Value* args, size_t count) const override;
+
+    protected:
+        size_t references() const override { return refCount; }
+        void traverse(Tracer& tracer) const override {
+            if (closure) tracer.visit(closure.get());
+        }
+        void pin(Pins& pins) override { pins.objects.emplace_back(static_cast<Object*>(this)); }
+        void clear() override { closure.reset(); }
     };
     
     /**
-     * @struct ReturnException
-     * @brief Excepción interna para manejar instrucciones return
-     * 
-     * Se utiliza como mecanismo de control de flujo interno para
-     * implementar el comportamiento de la instrucción return en funciones.
-     * No es un error, sino una forma controlada de terminar la ejecución
-     * de una función y devolver un valor.
+     * @enum Flow
+     * @brief Forma en que terminó la ejecución de una sentencia
+     *
+     * Permite propagar un return (y, en el futuro, break/continue) hasta la
+     * llamada que lo consume como un valor de retorno normal, sin recurrir
+     * a excepciones de C++.
      */
-    struct ReturnException {
-        Value value; ///< Valor retornado por la función
-        
-        /**
-         * @brief Constructor de ReturnException
-         * @param v Valor a retornar
-         */
-        explicit ReturnException(const Value& v) : value(v) {}
+    enum class Flow {
+        Normal,  ///< La ejecución continúa con la siguiente sentencia
+        Return,  ///< Se ejecutó return: se abandona la función en curso
+        TailCall ///< Se ejecutó return f(...): la llamada en curso pasa a ejecutar f (valor = f)
+    };
+
+    /**
+     * @struct ExecResult
+     * @brief Resultado de ejecutar una sentencia: valor y forma de terminar
+     */
+    struct ExecResult {
+        Flow flow = Flow::Normal;      ///< Cómo terminó la sentencia
+        Value value;                    ///< Valor de la sentencia o valor retornado (nil por defecto)
     };
 
     /**
      * @typedef FunctionPtr
-     * @brief Puntero compartido a función definida por el usuario
+     * @brief Referencia a función definida por el usuario
      */
-    using FunctionPtr = std::shared_ptr<LoxFunction>;
+    using FunctionPtr = TokenTree::Ref<LoxFunction>;
 
     /**
      * @brief Evalúa tokens y muestra el resultado
-     * @param tokens Vector de tokens a evaluar
+     * @param lexer Fuente de los tokens a evaluar
      * @return int Código de salida (0 = éxito, >0 = error)
      * 
      * Combina parsing y evaluación para mostrar el resultado de
      * evaluar una expresión. Utilizado por el comando 'evaluate'.
      */
-    int evaluate(const std::pmr::vector<Token>& tokens);
+    int evaluate(Tokenizer::Lexer& lexer);
+
+    /**
+     * @brief Determina si un valor es "verdadero" en contexto booleano
+     * @param v Valor a evaluar
+     * @return bool false para nil y false, true para todo lo demás
+     */
+    bool isTruthy(const Value& v);
+
+    /**
+     * @brief Compara dos valores con la semántica de '=='
+     * @param lv Operando izquierdo
+     * @param rv Operando derecho
+     * @return bool true solo si ambos son del mismo tipo y valor
+     */
+    bool valuesEqual(const Value& lv, const Value& rv);
+
+    /**
+     * @brief Aplica el operador '+' (suma numérica o concatenación)
+     * @param lv Operando izquierdo
+     * @param rv Operando derecho
+     * @return Value Suma de números o cadena concatenada
+     * @throws Error OperandsMustBeNumbers si la combinación no es válida
+     *
+     * Si uno de los operandos es una cadena, el otro se convierte a texto
+     * (números, booleanos y nil); en otro caso ambos deben ser números.
+     */
+    Value addValues(const Value& lv, const Value& rv);
+
+    /**
+     * @brief Lee un elemento con la semántica de a[i]
+     * @param target Valor indexado
+     * @param index Posición
+     * @return Value Elemento
+     * @throws Error IndexOnNonArray si target no es un array, InvalidIndex si
+     *         index no es un entero entre 0 y la longitud - 1
+     */
+    Value readElement(const Value& target, const Value& index);
+
+    /**
+     * @brief Sustituye un elemento con la semántica de a[i] = v
+     * @param target Valor indexado
+     * @param index Posición
+     * @param value Valor nuevo
+     * @throws Error Los mismos que readElement
+     */
+    void writeElement(const Value& target, const Value& index, const Value& value);
+
+    /**
+     * @brief Escribe un valor con el formato de la instrucción print
+     * @param out Flujo de salida
+     * @param value Valor a escribir
+     */
+    void printValue(std::ostream& out, const Value& value);
+
+    /**
+     * @brief Escribe un valor con el formato de la instrucción print
+     * @param out Salida con búfer (la de print)
+     * @param value Valor a escribir
+     */
+    void printValue(TokenTree::Output& out, const Value& value);
     
     /**
      * @brief Evalúa un nodo del AST directamente
      * @param node Puntero al nodo AST a evaluar
      * @return Value Resultado de la evaluación
      * @throws Error Si ocurre un error durante la evaluación
-     * @throws ReturnException Si se ejecuta una instrucción return
      * 
      * Función principal de evaluación que recorre recursivamente
      * el AST ejecutando las instrucciones y evaluando expresiones.
@@ -116,6 +209,9 @@ namespace Evaluator {
      * - Funciones y llamadas
      * - Estructuras de control (if, while, for)
      * - Instrucciones (print, return)
+     *
+     * Usa las globales, la arena y la salida del Context del hilo actual
+     * (TokenTree::Context::current), que persisten entre llamadas.
      */
     Value evalNode(const TokenTree::ASTNode* node);
 }
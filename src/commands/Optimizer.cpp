@@ -0,0 +1,171 @@
+/**
+ * @file Optimizer.cpp
+ * @brief Implementación del plegado de constantes y las ramas muertas
+ * @author Javier
+ * @date 2025
+ *
+ * La pasada recorre el árbol de abajo arriba: cada nodo se transforma
+ * después que sus hijos, de modo que 60 * 60 * 24 se pliega en dos pasos
+ * y una condición como !(1 > 2) llega ya reducida a un literal al if.
+ */
+
+#include "Optimizer.h"
+
+#include <cmath>
+#include <optional>
+#include <sstream>
+
+#include "Evaluator.h"
+#include "../def/ErrorCode.h"
+
+using namespace TokenTree;
+
+namespace Optimizer {
+    namespace {
+        using Type = ASTNode::Type;
+
+        /**
+         * @brief Obtiene el valor de un nodo literal
+         * @param node Nodo a inspeccionar
+         * @return std::optional<Value> Su valor, o nada si no es un literal
+         */
+        std::optional<Value> constantOf(const ASTNode* node) {
+            switch (node->getType()) {
+                case Type::Number:
+                case Type::String:
+                case Type::Boolean:
+                    return node->getLiteral();
+                case Type::Nil:
+                    return Value();
+                default:
+                    return std::nullopt;
+            }
+        }
+
+        /**
+         * @brief Crea el nodo literal de un valor plegado
+         * @param ast Árbol en el que se reserva
+         * @param value Número, cadena, booleano o nil
+         * @return NodePtr Nodo equivalente al que habría creado el parser
+         */
+        NodePtr literalNode(AST& ast, Value value) {
+            std::ostringstream text;
+            Evaluator::printValue(text, value);
+            if (value.isNumber()) return ast.make(Type::Number, text.str(), std::move(value));
+            if (value.isString()) return ast.make(Type::String, text.str(), std::move(value));
+            if (value.isBool()) return ast.make(Type::Boolean, text.str(), std::move(value));
+            return ast.make(Type::Nil, "nil");
+        }
+
+        /**
+         * @brief Calcula una operación binaria entre constantes
+         * @param op Operador (ni and ni or)
+         * @param left Operando izquierdo
+         * @param right Operando derecho
+         * @return std::optional<Value> Resultado, o nada si la operación fallaría
+         *
+         * Reproduce Evaluator::evalNode para BinaryOp.
+         */
+        std::optional<Value> binary(Operator op, const Value& left, const Value& right) {
+            switch (op) {
+                case Operator::Add:
+                    try {
+                        return Evaluator::addValues(left, right);
+                    } catch (const Error&) {
+                        return std::nullopt;
+                    }
+                case Operator::Equal:
+                    return Value(Evaluator::valuesEqual(left, right));
+                case Operator::NotEqual:
+                    return Value(!Evaluator::valuesEqual(left, right));
+                default:
+                    break;
+            }
+            if (!left.isNumber() || !right.isNumber()) return std::nullopt;
+            double a = left.asNumber();
+            double b = right.asNumber();
+            switch (op) {
+                case Operator::Subtract:     return Value(a - b);
+                case Operator::Multiply:     return Value(a * b);
+                case Operator::Divide:       return Value(a / b);
+                case Operator::Modulo:       return Value(std::fmod(a, b));
+                case Operator::Less:         return Value(a < b);
+                case Operator::LessEqual:    return Value(a <= b);
+                case Operator::Greater:      return Value(a > b);
+                case Operator::GreaterEqual: return Value(a >= b);
+                default:                     return std::nullopt;
+            }
+        }
+
+        /**
+         * @brief Optimiza un subárbol
+         * @param ast Árbol al que pertenece
+         * @param node Subárbol (se consume)
+         * @return NodePtr Subárbol equivalente que ocupa su lugar
+         */
+        NodePtr fold(AST& ast, NodePtr node) {
+            const size_t count = node->getChildren().size();
+            for (size_t i = 0; i < count; ++i) {
+                // El destino de una asignación se deja intacto: (a) = 1 debe seguir fallando
+                if (node->getType() == Type::Assign && i == 0) continue;
+                node->setChild(i, fold(ast, node->takeChild(i)));
+            }
+            const auto& children = node->getChildren();
+
+            switch (node->getType()) {
+                case Type::Grouping:
+                    return node->takeChild(0);
+
+                case Type::Unary: {
+                    auto operand = constantOf(children[0].get());
+                    if (!operand) break;
+                    if (node->getOperator() == Operator::Not) return literalNode(ast, !Evaluator::isTruthy(*operand));
+                    if (operand->isNumber()) return literalNode(ast, -operand->asNumber());
+                    break; // -"a": el error se produce al ejecutar
+                }
+
+                case Type::BinaryOp: {
+                    const Operator op = node->getOperator();
+                    auto left = constantOf(children[0].get());
+                    if (!left) break;
+                    if (op == Operator::Or || op == Operator::And) {
+                        // El operando izquierdo decide: el resultado es él o el derecho, sea cual sea
+                        if (Evaluator::isTruthy(*left) == (op == Operator::Or)) return node->takeChild(0);
+                        return node->takeChild(1);
+                    }
+                    auto right = constantOf(children[1].get());
+                    if (!right) break;
+                    if (auto result = binary(op, *left, *right)) return literalNode(ast, std::move(*result));
+                    break;
+                }
+
+                case Type::IfStmt: {
+                    auto condition = constantOf(children[0].get());
+                    if (!condition) break;
+                    if (Evaluator::isTruthy(*condition)) return node->takeChild(1);
+                    if (children.size() == 3) return node->takeChild(2);
+                    return ast.make(Type::Nil, "nil");
+                }
+
+                case Type::WhileStmt: {
+                    auto condition = constantOf(children[0].get());
+                    if (condition && !Evaluator::isTruthy(*condition)) return ast.make(Type::Nil, "nil");
+                    break;
+                }
+
+                default:
+                    break;
+            }
+            return node;
+        }
+    }
+
+    void optimize(AST& ast) {
+        ASTNode* root = ast.root();
+        if (!root) return;
+        // La raíz es un Program: sus sentencias se sustituyen en su sitio
+        for (size_t i = 0; i < root->getChildren().size(); ++i) {
+            root->setChild(i, fold(ast, root->takeChild(i)));
+        }
+    }
+}
@@ -0,0 +1,43 @@
+/**
+ * @file Optimizer.h
+ * @brief Plegado de constantes y eliminación de ramas muertas sobre el AST
+ * @author Javier
+ * @date 2025
+ *
+ * Este archivo define la pasada opcional (run -O) que se ejecuta entre
+ * Parser::parseAST y la resolución de variables. Simplifica el árbol sin
+ * cambiar lo que el programa imprime ni los errores que produce, así que
+ * sirve igual para el evaluador y para la máquina virtual.
+ */
+
+#ifndef OPTIMIZER_H
+#define OPTIMIZER_H
+
+#include "../def/ASTNode.h"
+
+/**
+ * @namespace Optimizer
+ * @brief Espacio de nombres para las optimizaciones del AST
+ */
+namespace Optimizer {
+    /**
+     * @brief Simplifica un AST recién parseado
+     * @param ast Árbol a transformar (todavía sin resolver)
+     *
+     * - Quita los nodos Grouping (salvo el destino de una asignación, que
+     *   debe seguir siendo inválido)
+     * - Pliega operaciones unarias y binarias cuyos operandos son literales,
+     *   con las mismas reglas que el evaluador; si la operación fallaría en
+     *   ejecución (por ejemplo "a" - 1) se deja tal cual para que el error
+     *   se produzca en su momento
+     * - Resuelve and/or con el operando izquierdo constante
+     * - Sustituye un if con condición constante por la rama elegida y un
+     *   while con condición falsa por una sentencia vacía (nil)
+     *
+     * Las sentencias nunca se eliminan de un bloque: se sustituyen, para que
+     * los números de sentencia de los mensajes "[line N]" no cambien.
+     */
+    void optimize(TokenTree::AST& ast);
+}
+
+#endif // OPTIMIZER_H
@@ -21,7 +21,7 @@
  * returnStmt     → "return" expression? ";"
  * exprStmt       → expression ";"
  * expression     → assignment
- * assignment     → IDENTIFIER "=" assignment | logic_or
+ * assignment     → ( IDENTIFIER | call "[" expression "]" ) "=" assignment | logic_or
  * logic_or       → logic_and ( "or" logic_and )*
  * logic_and      → equality ( "and" equality )*
  * equality       → comparison ( ( "!=" | "==" ) comparison )*
@@ -29,147 +29,211 @@
  * addition       → multiplication ( ( "-" | "+" ) multiplication )*
  * multiplication → unary ( ( "/" | "*" | "%" ) unary )*
  * unary          → ( "!" | "-" ) unary | call
- * call           → primary ( "(" arguments? ")" )*
+ * call           → primary ( "(" arguments? ")" | "[" expression "]" )*
  * primary        → NUMBER | STRING | "true" | "false" | "nil" | IDENTIFIER | "(" expression ")"
+ *                | "[" ( expression ( "," expression )* )? "]"
  */
 
 #include "Parser.h"
 #include "../def/ErrorCode.h"
+#include "../def/Parallel.h"
 #include <iostream>
-#include <variant>
 #include <sstream>
 #include <stdexcept>
 
 namespace Parser {
     // Declaraciones adelantadas para los diferentes niveles de precedencia
-    static std::unique_ptr<ASTNode> parseEquality(const std::pmr::vector<Token>& tokens, size_t& pos);
-    static std::unique_ptr<ASTNode> parseComparison(const std::pmr::vector<Token>& tokens, size_t& pos);
-    static std::unique_ptr<ASTNode> parseAdditive(const std::pmr::vector<Token>& tokens, size_t& pos);
-    static std::unique_ptr<ASTNode> parseExpression(const std::pmr::vector<Token>& tokens, size_t& pos);
-    static std::unique_ptr<ASTNode> parseAnd(const std::pmr::vector<Token>& tokens, size_t& pos);
-    static std::unique_ptr<ASTNode> parseOr(const std::pmr::vector<Token>& tokens, size_t& pos);
-    static std::unique_ptr<ASTNode> parseAssignment(const std::pmr::vector<Token>& tokens, size_t& pos);
-    static std::unique_ptr<ASTNode> parseStatement(const std::pmr::vector<Token>& tokens, size_t& pos);
-    static std::unique_ptr<ASTNode> parsePrimary(const std::pmr::vector<Token>& tokens, size_t& pos);
-    static std::unique_ptr<ASTNode> parseCall(const std::pmr::vector<Token>& tokens, size_t& pos);
+    static NodePtr parseEquality(Lexer& lexer, AST& ast);
+    static NodePtr parseComparison(Lexer& lexer, AST& ast);
+    static NodePtr parseAdditive(Lexer& lexer, AST& ast);
+    static NodePtr parseExpression(Lexer& lexer, AST& ast);
+    static NodePtr parseAnd(Lexer& lexer, AST& ast);
+    static NodePtr parseOr(Lexer& lexer, AST& ast);
+    static NodePtr parseAssignment(Lexer& lexer, AST& ast);
+    static NodePtr parseStatement(Lexer& lexer, AST& ast);
+    static NodePtr parsePrimary(Lexer& lexer, AST& ast);
+    static NodePtr parseCall(Lexer& lexer, AST& ast);
+
+    /**
+     * @brief Traduce el token de un operador binario a su Operator
+     * @param type Tipo del token del operador
+     * @return Operator Operador correspondiente (Operator::None si no lo es)
+     */
+    static Operator binaryOperator(TokenType type) {
+        switch (type) {
+            case TokenType::PLUS:          return Operator::Add;
+            case TokenType::MINUS:         return Operator::Subtract;
+            case TokenType::MULT:          return Operator::Multiply;
+            case TokenType::SLASH:         return Operator::Divide;
+            case TokenType::MOD:           return Operator::Modulo;
+            case TokenType::EQUAL_EQUAL:   return Operator::Equal;
+            case TokenType::BANG_EQUAL:    return Operator::NotEqual;
+            case TokenType::LESS:          return Operator::Less;
+            case TokenType::LESS_EQUAL:    return Operator::LessEqual;
+            case TokenType::GREATER:       return Operator::Greater;
+            case TokenType::GREATER_EQUAL: return Operator::GreaterEqual;
+            case TokenType::AND:           return Operator::And;
+            case TokenType::OR:            return Operator::Or;
+            default:                       return Operator::None;
+        }
+    }
 
     /**
      * @brief Analiza operadores unarios (! y -)
-     * @param tokens Vector de tokens
-     * @param pos Posición actual (modificada por referencia)
-     * @return std::unique_ptr<ASTNode> Nodo AST para la expresión unaria
+     * @param lexer Fuente de tokens (se consumen los del nodo)
+     * @param ast Árbol en construcción (reserva los nodos)
+     * @return NodePtr Nodo AST para la expresión unaria
      */
-    static std::unique_ptr<ASTNode> parseUnary(const std::pmr::vector<Token>& tokens, size_t& pos) {
-        if (pos < tokens.size()) {
-            auto type = tokens[pos].getType();
-            if (type == TokenType::BANG || type == TokenType::MINUS) {
-                std::string op = tokens[pos].getLexeme();
-                pos++; // consumir operador
-                auto right = parseUnary(tokens, pos);
-                auto node = std::make_unique<ASTNode>(ASTNode::Type::BinaryOp, op);
-                node->addChild(std::move(right));
-                return node;
-            }
+    static NodePtr parseUnary(Lexer& lexer, AST& ast) {
+        auto type = lexer.peek().getType();
+        if (type == TokenType::BANG || type == TokenType::MINUS) {
+            std::string_view op = lexer.peek().getLexeme();
+            lexer.next(); // consumir operador
+            auto right = parseUnary(lexer, ast);
+            auto node = ast.make(ASTNode::Type::Unary, op,
+                                                  type == TokenType::BANG ? Operator::Not : Operator::Negate);
+            node->addChild(std::move(right));
+            return node;
         }
-        return parseCall(tokens, pos);
+        return parseCall(lexer, ast);
     }
 
     /**
      * @brief Analiza expresiones primarias (literales, identificadores, agrupación)
-     * @param tokens Vector de tokens
-     * @param pos Posición actual (modificada por referencia)
-     * @return std::unique_ptr<ASTNode> Nodo AST para la expresión primaria
+     * @param lexer Fuente de tokens (se consumen los del nodo)
+     * @param ast Árbol en construcción (reserva los nodos)
+     * @return NodePtr Nodo AST para la expresión primaria
      * @throws Error Si encuentra un token inesperado
      */
-    static std::unique_ptr<ASTNode> parsePrimary(const std::pmr::vector<Token>& tokens, size_t& pos) {
-        const Token& token = tokens[pos];
+    static NodePtr parsePrimary(Lexer& lexer, AST& ast) {
+        // Copia: el token consultado cambia al consumir con next()
+        const Token token = lexer.peek();
         
         // Error si falta expresión antes de ')' o fin
         if (token.getType() == TokenType::R_PAREN || token.getType() == TokenType::EOF_OF_FILE) {
-            throw Error(ErrorCodes::ParseError, "Error at '" + token.getLexeme() + "': Expect expression.\n");
+            throw Error(ErrorCodes::ParseError, "Error at '" + std::string(token.getLexeme()) + "': Expect expression.\n");
         }
 
         // Agrupación con paréntesis
         if (token.getType() == TokenType::L_PAREN) {
-            pos++; // consumir '('
-            auto inner = parseExpression(tokens, pos);
-            if (pos >= tokens.size() || tokens[pos].getType() != TokenType::R_PAREN) {
-                if (pos < tokens.size() && tokens[pos].getType() == TokenType::EOF_OF_FILE) {
+            lexer.next(); // consumir '('
+            auto inner = parseExpression(lexer, ast);
+            if (lexer.peek().getType() != TokenType::R_PAREN) {
+                if (lexer.peek().getType() == TokenType::EOF_OF_FILE) {
                     throw Error(ErrorCodes::ParseError, "Error at end: Expect ')'\n");
                 } else {
                     throw Error(ErrorCodes::ParseError, "Expected ')'\n");
                 }
             }
-            pos++; // consumir ')'
+            lexer.next(); // consumir ')'
             // crear nodo de agrupación
-            auto groupNode = std::make_unique<ASTNode>(ASTNode::Type::BinaryOp, "group");
+            auto groupNode = ast.make(ASTNode::Type::Grouping, "group");
             groupNode->addChild(std::move(inner));
             return groupNode;
         }
 
+        // Literal de array: '[' elementos? ']'
+        if (token.getType() == TokenType::L_BRACKET) {
+            lexer.next(); // consumir '['
+            auto arrayNode = ast.make(ASTNode::Type::Array, "array");
+            if (lexer.peek().getType() != TokenType::R_BRACKET) {
+                do {
+                    arrayNode->addChild(parseExpression(lexer, ast));
+                    if (lexer.peek().getType() == TokenType::COMMA) {
+                        lexer.next(); // consumir ',' y seguir
+                    } else {
+                        break;
+                    }
+                } while (true);
+            }
+            if (lexer.peek().getType() != TokenType::R_BRACKET) {
+                throw Error(ErrorCodes::ParseError, "Error: Expect ']' after array elements.\n");
+            }
+            lexer.next(); // consumir ']'
+            return arrayNode;
+        }
+
         // Literales de cadena
         if (token.getType() == TokenType::STRING) {
-            std::string literal = std::get<std::string>(token.getLiteral());
-            pos++;
-            return std::make_unique<ASTNode>(ASTNode::Type::String, literal);
+            std::string_view literal = token.getLexeme();
+            lexer.next();
+            return ast.make(ASTNode::Type::String, literal, makeString(literal));
         }
         // Literales booleanos
         if (token.getType() == TokenType::TRUE || token.getType() == TokenType::FALSE) {
-            std::string lexeme = token.getLexeme();
-            pos++;
-            return std::make_unique<ASTNode>(ASTNode::Type::Boolean, lexeme);
+            std::string_view lexeme = token.getLexeme();
+            bool literal = token.getType() == TokenType::TRUE;
+            lexer.next();
+            return ast.make(ASTNode::Type::Boolean, lexeme, ASTNode::Literal(literal));
         }
         // Literal nil
         if (token.getType() == TokenType::NIL) {
-            std::string lexeme = token.getLexeme();
-            pos++;
-            return std::make_unique<ASTNode>(ASTNode::Type::Nil, lexeme);
+            std::string_view lexeme = token.getLexeme();
+            lexer.next();
+            return ast.make(ASTNode::Type::Nil, lexeme);
         }
         // Literales numéricos
         if (token.getType() == TokenType::NUMBER) {
-            std::string lexeme = token.getLexeme();
-            pos++;
-            return std::make_unique<ASTNode>(ASTNode::Type::Number, lexeme);
+            std::string_view lexeme = token.getLexeme();
+            // El valor se decodifica una sola vez, al construir el nodo
+            double literal = token.getNumber();
+            lexer.next();
+            return ast.make(ASTNode::Type::Number, lexeme, ASTNode::Literal(literal));
         }
         // Identificadores
         if (token.getType() == TokenType::IDENTIFIER) {
-            std::string name = token.getLexeme();
-            pos++;
-            return std::make_unique<ASTNode>(ASTNode::Type::Identifier, name);
+            std::string_view name = token.getLexeme();
+            lexer.next();
+            return ast.make(ASTNode::Type::Identifier, name);
         }
         // Token inesperado
-        throw Error(ErrorCodes::ParseError, "Error at '" + token.getLexeme() + "': Expect expression.\n");
+        throw Error(ErrorCodes::ParseError, "Error at '" + std::string(token.getLexeme()) + "': Expect expression.\n");
     }
 
     /**
-     * @brief Analiza llamadas a función con argumentos
-     * @param tokens Vector de tokens
-     * @param pos Posición actual (modificada por referencia)
-     * @return std::unique_ptr<ASTNode> Nodo AST para la llamada
+     * @brief Analiza llamadas a función con argumentos e indexaciones
+     * @param lexer Fuente de tokens (se consumen los del nodo)
+     * @param ast Árbol en construcción (reserva los nodos)
+     * @return NodePtr Nodo AST para la llamada o el acceso a un elemento
      */
-    static std::unique_ptr<ASTNode> parseCall(const std::pmr::vector<Token>& tokens, size_t& pos) {
-        auto expr = parsePrimary(tokens, pos);
-        while (pos < tokens.size() && tokens[pos].getType() == TokenType::L_PAREN) {
-            pos++; // consumir '('
-            // parsear lista de argumentos
-            std::vector<std::unique_ptr<ASTNode>> args;
-            if (pos < tokens.size() && tokens[pos].getType() != TokenType::R_PAREN) {
+    static NodePtr parseCall(Lexer& lexer, AST& ast) {
+        auto expr = parsePrimary(lexer, ast);
+        while (lexer.peek().getType() == TokenType::L_PAREN || lexer.peek().getType() == TokenType::L_BRACKET) {
+            if (lexer.peek().getType() == TokenType::L_BRACKET) {
+                lexer.next(); // consumir '['
+                auto index = parseExpression(lexer, ast);
+                if (lexer.peek().getType() != TokenType::R_BRACKET) {
+                    throw Error(ErrorCodes::ParseError, "Error: Expect ']' after index.\n");
+                }
+                lexer.next(); // consumir ']'
+                auto indexNode = ast.make(ASTNode::Type::Index, "[]");
+                indexNode->addChild(std::move(expr));
+                indexNode->addChild(std::move(index));
+                expr = std::move(indexNode);
+                continue;
+            }
+            // la llamada guarda solo el nombre de la función: `fs[1]()` o `f()()`
+            // no tienen nombre al que llamar
+            if (expr->getType() != ASTNode::Type::Identifier) {
+                throw Error(ErrorCodes::ParseError, "Error at '(': Can only call functions by name.\n");
+            }
+            lexer.next(); // consumir '('
+            // crear nodo de llamada con el nombre y parsear los argumentos como hijos
+            auto callNode = ast.make(ASTNode::Type::Call, expr->getValue());
+            if (lexer.peek().getType() != TokenType::R_PAREN) {
                 do {
-                    args.push_back(parseExpression(tokens, pos));
-                    if (pos < tokens.size() && tokens[pos].getType() == TokenType::COMMA) {
-                        pos++; // consumir ',' y seguir
+                    callNode->addChild(parseExpression(lexer, ast));
+                    if (lexer.peek().getType() == TokenType::COMMA) {
+                        lexer.next(); // consumir ',' y seguir
                     } else {
                         break;
                     }
                 } while (true);
             }
-            if (pos >= tokens.size() || tokens[pos].getType() != TokenType::R_PAREN) {
+            if (lexer.peek().getType() != TokenType::R_PAREN) {
                 throw Error(ErrorCodes::ParseError, "Error: Expect ')' after arguments.\n");
             }
-            pos++; // consumir ')'
-            // crear nodo de llamada con nombre y argumentos
-            auto callNode = std::make_unique<ASTNode>(ASTNode::Type::Call, expr->getValue());
-            for (auto &arg : args) callNode->addChild(std::move(arg));
+            lexer.next(); // consumir ')'
             expr = std::move(callNode);
         }
         return expr;
@@ -177,21 +241,30 @@ namespace Parser {
 
     /**
      * @brief Analiza asignaciones (right-associative)
-     * @param tokens Vector de tokens
-     * @param pos Posición actual (modificada por referencia)
-     * @return std::unique_ptr<ASTNode> Nodo AST para la asignación
+     * @param lexer Fuente de tokens (se consumen los del nodo)
+     * @param ast Árbol en construcción (reserva los nodos)
+     * @return NodePtr Nodo AST para la asignación
      */
-    static std::unique_ptr<ASTNode> parseAssignment(const std::pmr::vector<Token>& tokens, size_t& pos) {
+    static NodePtr parseAssignment(Lexer& lexer, AST& ast) {
         // Parse OR expressions first
-        auto expr = parseOr(tokens, pos);
-        if (pos < tokens.size() && tokens[pos].getType() == TokenType::EQUAL) {
-            pos++; // consumir '='
-            auto value = parseAssignment(tokens, pos);
+        auto expr = parseOr(lexer, ast);
+        if (lexer.peek().getType() == TokenType::EQUAL) {
+            lexer.next(); // consumir '='
+            auto value = parseAssignment(lexer, ast);
+            // a[i] = v: el destino aporta el array y el índice
+            if (expr->getType() == ASTNode::Type::Index) {
+                auto node = ast.make(ASTNode::Type::SetIndex, "[]=");
+                node->reserveChildren(3);
+                node->addChild(expr->takeChild(0));
+                node->addChild(expr->takeChild(1));
+                node->addChild(std::move(value));
+                return node;
+            }
             // validación de target
             if (expr->getType() != ASTNode::Type::Identifier) {
                 throw Error(ErrorCodes::InvalidAssignmentTarget);
             }
-            auto node = std::make_unique<ASTNode>(ASTNode::Type::BinaryOp, "=");
+            auto node = ast.make(ASTNode::Type::Assign, "=");
             node->addChild(std::move(expr));
             node->addChild(std::move(value));
             return node;
@@ -201,17 +274,18 @@ namespace Parser {
 
     /**
      * @brief Analiza operadores OR lógicos (left-associative)
-     * @param tokens Vector de tokens
-     * @param pos Posición actual (modificada por referencia)
-     * @return std::unique_ptr<ASTNode> Nodo AST para la expresión OR
+     * @param lexer Fuente de tokens (se consumen los del nodo)
+     * @param ast Árbol en construcción (reserva los nodos)
+     * @return NodePtr Nodo AST para la expresión OR
      */
-    static std::unique_ptr<ASTNode> parseOr(const std::pmr::vector<Token>& tokens, size_t& pos) {
-        auto left = parseAnd(tokens, pos);
-        while (pos < tokens.size() && tokens[pos].getType() == TokenType::OR) {
-            std::string op = tokens[pos].getLexeme();
-            pos++; // consumir 'or'
-            auto right = parseAnd(tokens, pos);
-            auto node = std::make_unique<ASTNode>(ASTNode::Type::BinaryOp, op);
+    static NodePtr parseOr(Lexer& lexer, AST& ast) {
+        auto left = parseAnd(lexer, ast);
+        while (lexer.peek().getType() == TokenType::OR) {
+            std::string_view op = lexer.peek().getLexeme();
+            Operator opKind = binaryOperator(lexer.peek().getType());
+            lexer.next(); // consumir 'or'
+            auto right = parseAnd(lexer, ast);
+            auto node = ast.make(ASTNode::Type::BinaryOp, op, opKind);
             node->addChild(std::move(left));
             node->addChild(std::move(right));
             left = std::move(node);
@@ -221,17 +295,18 @@ namespace Parser {
 
     /**
      * @brief Analiza operadores AND lógicos (left-associative)
-     * @param tokens Vector de tokens
-     * @param pos Posición actual (modificada por referencia)
-     * @return std::unique_ptr<ASTNode> Nodo AST para la expresión AND
+     * @param lexer Fuente de tokens (se consumen los del nodo)
+     * @param ast Árbol en construcción (reserva los nodos)
+     * @return NodePtr Nodo AST para la expresión AND
      */
-    static std::unique_ptr<ASTNode> parseAnd(const std::pmr::vector<Token>& tokens, size_t& pos) {
-        auto left = parseEquality(tokens, pos);
-        while (pos < tokens.size() && tokens[pos].getType() == TokenType::AND) {
-            std::string op = tokens[pos].getLexeme();
-            pos++; // consumir 'and'
-            auto right = parseEquality(tokens, pos);
-            auto node = std::make_unique<ASTNode>(ASTNode::Type::BinaryOp, op);
+    static NodePtr parseAnd(Lexer& lexer, AST& ast) {
+        auto left = parseEquality(lexer, ast);
+        while (lexer.peek().getType() == TokenType::AND) {
+            std::string_view op = lexer.peek().getLexeme();
+            Operator opKind = binaryOperator(lexer.peek().getType());
+            lexer.next(); // consumir 'and'
+            auto right = parseEquality(lexer, ast);
+            auto node = ast.make(ASTNode::Type::BinaryOp, op, opKind);
             node->addChild(std::move(left));
             node->addChild(std::move(right));
             left = std::move(node);
@@ -241,18 +316,18 @@ namespace Parser {
 
     /**
      * @brief Analiza operaciones multiplicativas (*, /, %)
-     * @param tokens Vector de tokens
-     * @param pos Posición actual (modificada por referencia)
-     * @return std::unique_ptr<ASTNode> Nodo AST para la operación multiplicativa
+     * @param lexer Fuente de tokens (se consumen los del nodo)
+     * @param ast Árbol en construcción (reserva los nodos)
+     * @return NodePtr Nodo AST para la operación multiplicativa
      */
-    static std::unique_ptr<ASTNode> parseMultiplicative(const std::pmr::vector<Token>& tokens, size_t& pos) {
-        auto left = parseUnary(tokens, pos);
-        while (pos < tokens.size() &&
-               (tokens[pos].getType() == TokenType::MULT || tokens[pos].getType() == TokenType::SLASH || tokens[pos].getType() == TokenType::MOD)) {
-            std::string op = tokens[pos].getLexeme();
-            pos++; // consumir '*', '/', o '%'
-            auto right = parseUnary(tokens, pos);
-            auto node = std::make_unique<ASTNode>(ASTNode::Type::BinaryOp, op);
+    static NodePtr parseMultiplicative(Lexer& lexer, AST& ast) {
+        auto left = parseUnary(lexer, ast);
+        while ((lexer.peek().getType() == TokenType::MULT || lexer.peek().getType() == TokenType::SLASH || lexer.peek().getType() == TokenType::MOD)) {
+            std::string_view op = lexer.peek().getLexeme();
+            Operator opKind = binaryOperator(lexer.peek().getType());
+            lexer.next(); // consumir '*', '/', o '%'
+            auto right = parseUnary(lexer, ast);
+            auto node = ast.make(ASTNode::Type::BinaryOp, op, opKind);
             node->addChild(std::move(left));
             node->addChild(std::move(right));
             left = std::move(node);
@@ -262,18 +337,18 @@ namespace Parser {
 
     /**
      * @brief Analiza operaciones aditivas (+, -)
-     * @param tokens Vector de tokens
-     * @param pos Posición actual (modificada por referencia)
-     * @return std::unique_ptr<ASTNode> Nodo AST para la operación aditiva
+     * @param lexer Fuente de tokens (se consumen los del nodo)
+     * @param ast Árbol en construcción (reserva los nodos)
+     * @return NodePtr Nodo AST para la operación aditiva
      */
-    static std::unique_ptr<ASTNode> parseAdditive(const std::pmr::vector<Token>& tokens, size_t& pos) {
-        auto left = parseMultiplicative(tokens, pos);
-        while (pos < tokens.size() &&
-               (tokens[pos].getType() == TokenType::PLUS || tokens[pos].getType() == TokenType::MINUS)) {
-            std::string op = tokens[pos].getLexeme();
-            pos++; // consumir '+' o '-'
-            auto right = parseMultiplicative(tokens, pos);
-            auto node = std::make_unique<ASTNode>(ASTNode::Type::BinaryOp, op);
+    static NodePtr parseAdditive(Lexer& lexer, AST& ast) {
+        auto left = parseMultiplicative(lexer, ast);
+        while ((lexer.peek().getType() == TokenType::PLUS || lexer.peek().getType() == TokenType::MINUS)) {
+            std::string_view op = lexer.peek().getLexeme();
+            Operator opKind = binaryOperator(lexer.peek().getType());
+            lexer.next(); // consumir '+' o '-'
+            auto right = parseMultiplicative(lexer, ast);
+            auto node = ast.make(ASTNode::Type::BinaryOp, op, opKind);
             node->addChild(std::move(left));
             node->addChild(std::move(right));
             left = std::move(node);
@@ -283,19 +358,19 @@ namespace Parser {
 
     /**
      * @brief Analiza operaciones de comparación (<, <=, >, >=)
-     * @param tokens Vector de tokens
-     * @param pos Posición actual (modificada por referencia)
-     * @return std::unique_ptr<ASTNode> Nodo AST para la comparación
+     * @param lexer Fuente de tokens (se consumen los del nodo)
+     * @param ast Árbol en construcción (reserva los nodos)
+     * @return NodePtr Nodo AST para la comparación
      */
-    static std::unique_ptr<ASTNode> parseComparison(const std::pmr::vector<Token>& tokens, size_t& pos) {
-        auto left = parseAdditive(tokens, pos);
-        while (pos < tokens.size() &&
-               (tokens[pos].getType() == TokenType::LESS || tokens[pos].getType() == TokenType::LESS_EQUAL ||
-                tokens[pos].getType() == TokenType::GREATER || tokens[pos].getType() == TokenType::GREATER_EQUAL)) {
-            std::string op = tokens[pos].getLexeme();
-            pos++; // consumir operador de comparación
-            auto right = parseAdditive(tokens, pos);
-            auto node = std::make_unique<ASTNode>(ASTNode::Type::BinaryOp, op);
+    static NodePtr parseComparison(Lexer& lexer, AST& ast) {
+        auto left = parseAdditive(lexer, ast);
+        while ((lexer.peek().getType() == TokenType::LESS || lexer.peek().getType() == TokenType::LESS_EQUAL ||
+                lexer.peek().getType() == TokenType::GREATER || lexer.peek().getType() == TokenType::GREATER_EQUAL)) {
+            std::string_view op = lexer.peek().getLexeme();
+            Operator opKind = binaryOperator(lexer.peek().getType());
+            lexer.next(); // consumir operador de comparación
+            auto right = parseAdditive(lexer, ast);
+            auto node = ast.make(ASTNode::Type::BinaryOp, op, opKind);
             node->addChild(std::move(left));
             node->addChild(std::move(right));
             left = std::move(node);
@@ -305,18 +380,18 @@ namespace Parser {
 
     /**
      * @brief Analiza operaciones de igualdad (==, !=)
-     * @param tokens Vector de tokens
-     * @param pos Posición actual (modificada por referencia)
-     * @return std::unique_ptr<ASTNode> Nodo AST para la igualdad
+     * @param lexer Fuente de tokens (se consumen los del nodo)
+     * @param ast Árbol en construcción (reserva los nodos)
+     * @return NodePtr Nodo AST para la igualdad
      */
-    static std::unique_ptr<ASTNode> parseEquality(const std::pmr::vector<Token>& tokens, size_t& pos) {
-        auto left = parseComparison(tokens, pos);
-        while (pos < tokens.size() &&
-               (tokens[pos].getType() == TokenType::EQUAL_EQUAL || tokens[pos].getType() == TokenType::BANG_EQUAL)) {
-            std::string op = tokens[pos].getLexeme();
-            pos++; // consumir == o !=
-            auto right = parseComparison(tokens, pos);
-            auto node = std::make_unique<ASTNode>(ASTNode::Type::BinaryOp, op);
+    static NodePtr parseEquality(Lexer& lexer, AST& ast) {
+        auto left = parseComparison(lexer, ast);
+        while ((lexer.peek().getType() == TokenType::EQUAL_EQUAL || lexer.peek().getType() == TokenType::BANG_EQUAL)) {
+            std::string_view op = lexer.peek().getLexeme();
+            Operator opKind = binaryOperator(lexer.peek().getType());
+            lexer.next(); // consumir == o !=
+            auto right = parseComparison(lexer, ast);
+            auto node = ast.make(ASTNode::Type::BinaryOp, op, opKind);
             node->addChild(std::move(left));
             node->addChild(std::move(right));
             left = std::move(node);
@@ -326,19 +401,19 @@ namespace Parser {
 
     /**
      * @brief Punto de entrada para analizar expresiones
-     * @param tokens Vector de tokens
-     * @param pos Posición actual (modificada por referencia)
-     * @return std::unique_ptr<ASTNode> Nodo AST para la expresión
+     * @param lexer Fuente de tokens (se consumen los del nodo)
+     * @param ast Árbol en construcción (reserva los nodos)
+     * @return NodePtr Nodo AST para la expresión
      */
-    static std::unique_ptr<ASTNode> parseExpression(const std::pmr::vector<Token>& tokens, size_t& pos) {
-        return parseAssignment(tokens, pos);
+    static NodePtr parseExpression(Lexer& lexer, AST& ast) {
+        return parseAssignment(lexer, ast);
     }
 
     /**
      * @brief Analiza declaraciones y instrucciones
-     * @param tokens Vector de tokens
-     * @param pos Posición actual (modificada por referencia)
-     * @return std::unique_ptr<ASTNode> Nodo AST para la declaración
+     * @param lexer Fuente de tokens (se consumen los del nodo)
+     * @param ast Árbol en construcción (reserva los nodos)
+     * @return NodePtr Nodo AST para la declaración
      * 
      * Maneja todos los tipos de declaraciones del lenguaje:
      * - Declaraciones de función
@@ -348,64 +423,64 @@ namespace Parser {
      * - Instrucciones print y return
      * - Expresiones
      */
-    static std::unique_ptr<ASTNode> parseStatement(const std::pmr::vector<Token>& tokens, size_t& pos) {
+    static NodePtr parseStatement(Lexer& lexer, AST& ast) {
         // Manejar sentencia return
-        if (pos < tokens.size() && tokens[pos].getType() == TokenType::RETURN) {
-            pos++; // consumir 'return'
-            std::unique_ptr<ASTNode> value = nullptr;
-            if (pos < tokens.size() && tokens[pos].getType() != TokenType::SEMICOLON) {
-                value = parseExpression(tokens, pos);
+        if (lexer.peek().getType() == TokenType::RETURN) {
+            lexer.next(); // consumir 'return'
+            NodePtr value = nullptr;
+            if (lexer.peek().getType() != TokenType::SEMICOLON) {
+                value = parseExpression(lexer, ast);
             }
-            if (pos >= tokens.size() || tokens[pos].getType() != TokenType::SEMICOLON) {
+            if (lexer.peek().getType() != TokenType::SEMICOLON) {
                 throw Error(ErrorCodes::ParseError, "Error: Expect ';' after return value.\n");
             }
-            pos++; // consumir ';'
-            auto node = std::make_unique<ASTNode>(ASTNode::Type::ReturnStmt, "return");
+            lexer.next(); // consumir ';'
+            auto node = ast.make(ASTNode::Type::ReturnStmt, "return");
             if (value) node->addChild(std::move(value));
             return node;
         }
 
         // Declaración de función: 'fun' IDENTIFIER '()' block
-        if (pos < tokens.size() && tokens[pos].getType() == TokenType::FUN) {
-            pos++; // consumir 'fun'
-            if (pos >= tokens.size() || tokens[pos].getType() != TokenType::IDENTIFIER) {
+        if (lexer.peek().getType() == TokenType::FUN) {
+            lexer.next(); // consumir 'fun'
+            if (lexer.peek().getType() != TokenType::IDENTIFIER) {
                 throw Error(ErrorCodes::ParseError, "Error: Expect function name after 'fun'.\n");
             }
-            std::string funcName = tokens[pos].getLexeme();
-            pos++; // consumir nombre
-            if (pos >= tokens.size() || tokens[pos].getType() != TokenType::L_PAREN) {
+            std::string_view funcName = lexer.peek().getLexeme();
+            lexer.next(); // consumir nombre
+            if (lexer.peek().getType() != TokenType::L_PAREN) {
                 throw Error(ErrorCodes::ParseError, "Error: Expect '(' after function name.\n");
             }
-            pos++; // consumir '('
+            lexer.next(); // consumir '('
             // Parsear parámetros
-            std::vector<std::string> parameters;
-            if (pos < tokens.size() && tokens[pos].getType() != TokenType::R_PAREN) {
+            std::vector<std::string_view> parameters;
+            if (lexer.peek().getType() != TokenType::R_PAREN) {
                 do {
-                    if (tokens[pos].getType() != TokenType::IDENTIFIER) {
+                    if (lexer.peek().getType() != TokenType::IDENTIFIER) {
                         throw Error(ErrorCodes::ParseError, "Error: Expect parameter name.\n");
                     }
-                    parameters.push_back(tokens[pos].getLexeme());
-                    pos++; // consumir nombre
-                    if (pos < tokens.size() && tokens[pos].getType() == TokenType::COMMA) {
-                        pos++; // consumir ','
+                    parameters.emplace_back(lexer.peek().getLexeme());
+                    lexer.next(); // consumir nombre
+                    if (lexer.peek().getType() == TokenType::COMMA) {
+                        lexer.next(); // consumir ','
                     } else {
                         break;
                     }
                 } while (true);
             }
-            if (pos >= tokens.size() || tokens[pos].getType() != TokenType::R_PAREN) {
+            if (lexer.peek().getType() != TokenType::R_PAREN) {
                 throw Error(ErrorCodes::ParseError, "Error: Expect ')' after parameters.\n");
             }
-            pos++; // consumir ')'
+            lexer.next(); // consumir ')'
             // Cuerpo de función (debe ser bloque)
-            auto body = parseStatement(tokens, pos);
+            auto body = parseStatement(lexer, ast);
             if (body->getType() != ASTNode::Type::Program || body->getValue() != "block") {
                 throw Error(ErrorCodes::ParseError, "Error: Expect function body to be a block.\n");
             }
-            auto node = std::make_unique<ASTNode>(ASTNode::Type::Function, funcName);
+            auto node = ast.make(ASTNode::Type::Function, funcName);
             // Añadir nodos de parámetros
-            for (auto &p : parameters) {
-                node->addChild(std::make_unique<ASTNode>(ASTNode::Type::Identifier, p));
+            for (std::string_view p : parameters) {
+                node->addChild(ast.make(ASTNode::Type::Identifier, p));
             }
             // Añadir cuerpo como último hijo
             node->addChild(std::move(body));
@@ -413,67 +488,67 @@ namespace Parser {
         }
 
         // Sentencia for: 'for' '(' initializer? ';' condition? ';' increment? ')' statement
-        if (pos < tokens.size() && tokens[pos].getType() == TokenType::FOR) {
-            pos++; // consumir 'for'
-            if (pos >= tokens.size() || tokens[pos].getType() != TokenType::L_PAREN) {
+        if (lexer.peek().getType() == TokenType::FOR) {
+            lexer.next(); // consumir 'for'
+            if (lexer.peek().getType() != TokenType::L_PAREN) {
                 throw Error(ErrorCodes::ParseError, "Error: Expect '(' after 'for'.\n");
             }
-            pos++; // consumir '('
+            lexer.next(); // consumir '('
             // Inicializador
-            std::unique_ptr<ASTNode> initializer;
-            if (tokens[pos].getType() == TokenType::VAR) {
-                initializer = parseStatement(tokens, pos);
-            } else if (tokens[pos].getType() != TokenType::SEMICOLON) {
-                auto initExpr = parseExpression(tokens, pos);
-                if (pos >= tokens.size() || tokens[pos].getType() != TokenType::SEMICOLON) {
+            NodePtr initializer;
+            if (lexer.peek().getType() == TokenType::VAR) {
+                initializer = parseStatement(lexer, ast);
+            } else if (lexer.peek().getType() != TokenType::SEMICOLON) {
+                auto initExpr = parseExpression(lexer, ast);
+                if (lexer.peek().getType() != TokenType::SEMICOLON) {
                     throw Error(ErrorCodes::ParseError, "Error: Expect ';' after loop initializer.\n");
                 }
-                pos++; // consumir ';'
+                lexer.next(); // consumir ';'
                 initializer = std::move(initExpr);
             } else {
-                pos++; // consumir ';'
+                lexer.next(); // consumir ';'
             }
             // Condición
-            std::unique_ptr<ASTNode> condition;
-            if (tokens[pos].getType() != TokenType::SEMICOLON) {
-                condition = parseExpression(tokens, pos);
+            NodePtr condition;
+            if (lexer.peek().getType() != TokenType::SEMICOLON) {
+                condition = parseExpression(lexer, ast);
             } else {
                 // falso por defecto
-                condition = std::make_unique<ASTNode>(ASTNode::Type::Boolean, "true");
+                condition = ast.make(ASTNode::Type::Boolean, "true", ASTNode::Literal(true));
             }
-            if (pos >= tokens.size() || tokens[pos].getType() != TokenType::SEMICOLON) {
+            if (lexer.peek().getType() != TokenType::SEMICOLON) {
                 throw Error(ErrorCodes::ParseError, "Error: Expect ';' after loop condition.\n");
             }
-            pos++; // consumir ';'
+            lexer.next(); // consumir ';'
             // Incremento
-            std::unique_ptr<ASTNode> increment;
-            if (tokens[pos].getType() != TokenType::R_PAREN) {
-                increment = parseExpression(tokens, pos);
+            NodePtr increment;
+            if (lexer.peek().getType() != TokenType::R_PAREN) {
+                increment = parseExpression(lexer, ast);
             }
-            if (pos >= tokens.size() || tokens[pos].getType() != TokenType::R_PAREN) {
+            if (lexer.peek().getType() != TokenType::R_PAREN) {
                 throw Error(ErrorCodes::ParseError, "Error: Expect ')' after for clauses.\n");
             }
-            pos++; // consumir ')'
+            lexer.next(); // consumir ')'
             // Cuerpo
-            auto body = parseStatement(tokens, pos);
+            auto body = parseStatement(lexer, ast);
             // El cuerpo de for no puede ser var declaration sin bloque
             if (body->getType() == ASTNode::Type::VarDecl) {
                 throw Error(ErrorCodes::ParseError, "Error: Expect block after for clauses.\n");
             }
             // Añadir incremento al final del cuerpo
             if (increment) {
-                auto block = std::make_unique<ASTNode>(ASTNode::Type::Program, "block");
+                auto block = ast.make(ASTNode::Type::Program, "block");
                 block->addChild(std::move(body));
                 block->addChild(std::move(increment));
                 body = std::move(block);
             }
             // Crear while
-            auto loop = std::make_unique<ASTNode>(ASTNode::Type::WhileStmt, "while");
+            auto loop = ast.make(ASTNode::Type::WhileStmt, "while");
             loop->addChild(std::move(condition));
             loop->addChild(std::move(body));
             // Si hay inicializador, envolver en bloque
             if (initializer) {
-                auto block = std::make_unique<ASTNode>(ASTNode::Type::Program, "block");
+                auto block = ast.make(ASTNode::Type::Program, "block");
                 block->addChild(std::move(initializer));
                 block->addChild(std::move(loop));
                 return block;
@@ -482,25 +557,25 @@ namespace Parser {
         }
 
         // Sentencia if: 'if' '(' expresion ')' statement
-        if (pos < tokens.size() && tokens[pos].getType() == TokenType::IF) {
-            pos++; // consumir 'if'
-            if (pos >= tokens.size() || tokens[pos].getType() != TokenType::L_PAREN) {
+        if (lexer.peek().getType() == TokenType::IF) {
+            lexer.next(); // consumir 'if'
+            if (lexer.peek().getType() != TokenType::L_PAREN) {
                 throw Error(ErrorCodes::ParseError, "Error: Expect '(' after 'if'.\n");
             }
-            pos++; // consumir '('
-            auto condition = parseExpression(tokens, pos);
-            if (pos >= tokens.size() || tokens[pos].getType() != TokenType::R_PAREN) {
+            lexer.next(); // consumir '('
+            auto condition = parseExpression(lexer, ast);
+            if (lexer.peek().getType() != TokenType::R_PAREN) {
                 throw Error(ErrorCodes::ParseError, "Error: Expect ')' after condition.\n");
             }
-            pos++; // consumir ')'
-            auto thenBranch = parseStatement(tokens, pos);
+            lexer.next(); // consumir ')'
+            auto thenBranch = parseStatement(lexer, ast);
             // Ramas else opcional
-            std::unique_ptr<ASTNode> elseBranch;
-            if (pos < tokens.size() && tokens[pos].getType() == TokenType::ELSE) {
-                pos++; // consumir 'else'
-                elseBranch = parseStatement(tokens, pos);
+            NodePtr elseBranch;
+            if (lexer.peek().getType() == TokenType::ELSE) {
+                lexer.next(); // consumir 'else'
+                elseBranch = parseStatement(lexer, ast);
             }
-            auto node = std::make_unique<ASTNode>(ASTNode::Type::IfStmt, "if");
+            auto node = ast.make(ASTNode::Type::IfStmt, "if");
             node->addChild(std::move(condition));
             node->addChild(std::move(thenBranch));
             if (elseBranch) node->addChild(std::move(elseBranch));
@@ -508,116 +583,118 @@ namespace Parser {
         }
 
         // Sentencia while: 'while' '(' expresion ')' statement
-        if (pos < tokens.size() && tokens[pos].getType() == TokenType::WHILE) {
-            pos++; // consumir 'while'
-            if (pos >= tokens.size() || tokens[pos].getType() != TokenType::L_PAREN) {
+        if (lexer.peek().getType() == TokenType::WHILE) {
+            lexer.next(); // consumir 'while'
+            if (lexer.peek().getType() != TokenType::L_PAREN) {
                 throw Error(ErrorCodes::ParseError, "Error: Expect '(' after 'while'.\n");
             }
-            pos++; // consumir '('
-            auto condition = parseExpression(tokens, pos);
-            if (pos >= tokens.size() || tokens[pos].getType() != TokenType::R_PAREN) {
+            lexer.next(); // consumir '('
+            auto condition = parseExpression(lexer, ast);
+            if (lexer.peek().getType() != TokenType::R_PAREN) {
                 throw Error(ErrorCodes::ParseError, "Error: Expect ')' after condition.\n");
             }
-            pos++; // consumir ')'
-            auto body = parseStatement(tokens, pos);
-            auto node = std::make_unique<ASTNode>(ASTNode::Type::WhileStmt, "while");
+            lexer.next(); // consumir ')'
+            auto body = parseStatement(lexer, ast);
+            auto node = ast.make(ASTNode::Type::WhileStmt, "while");
             node->addChild(std::move(condition));
             node->addChild(std::move(body));
             return node;
         }
 
         // Bloque: '{' statements '}'
-        if (pos < tokens.size() && tokens[pos].getType() == TokenType::L_BRACE) {
-            pos++; // consumir '{'
-            auto block = std::make_unique<ASTNode>(ASTNode::Type::Program, "block");
-            while (pos < tokens.size() && tokens[pos].getType() != TokenType::R_BRACE) {
-                block->addChild(parseStatement(tokens, pos));
+        if (lexer.peek().getType() == TokenType::L_BRACE) {
+            lexer.next(); // consumir '{'
+            auto block = ast.make(ASTNode::Type::Program, "block");
+            while (lexer.peek().getType() != TokenType::R_BRACE) {
+                block->addChild(parseStatement(lexer, ast));
             }
-            if (pos >= tokens.size() || tokens[pos].getType() != TokenType::R_BRACE) {
+            if (lexer.peek().getType() != TokenType::R_BRACE) {
                 throw Error(ErrorCodes::ParseError, "Error at end: Expect '}'\n");
             }
-            pos++; // consumir '}'
+            lexer.next(); // consumir '}'
             return block;
         }
 
-        if (pos < tokens.size() && tokens[pos].getType() == TokenType::VAR) {
-            pos++; // consumir 'var'
-            if (pos >= tokens.size() || tokens[pos].getType() != TokenType::IDENTIFIER) {
+        if (lexer.peek().getType() == TokenType::VAR) {
+            lexer.next(); // consumir 'var'
+            if (lexer.peek().getType() != TokenType::IDENTIFIER) {
                 throw Error(ErrorCodes::ParseError, "Error: Expect variable name after 'var'.\n");
             }
-            std::string varName = tokens[pos].getLexeme();
-            pos++; // consumir nombre
-            std::unique_ptr<ASTNode> initExpr;
-            if (pos < tokens.size() && tokens[pos].getType() == TokenType::EQUAL) {
-                pos++; // consumir '='
-                initExpr = parseExpression(tokens, pos);
+            std::string_view varName = lexer.peek().getLexeme();
+            lexer.next(); // consumir nombre
+            NodePtr initExpr;
+            if (lexer.peek().getType() == TokenType::EQUAL) {
+                lexer.next(); // consumir '='
+                initExpr = parseExpression(lexer, ast);
             }
             
 
-            if (pos >= tokens.size() || tokens[pos].getType() != TokenType::SEMICOLON) {
+            if (lexer.peek().getType() != TokenType::SEMICOLON) {
                 throw Error(ErrorCodes::ParseError, "Error: Expect ';' after variable declaration.\n");
             }
-            pos++; // consumir ';'
-            auto node = std::make_unique<ASTNode>(ASTNode::Type::VarDecl, varName);
+            lexer.next(); // consumir ';'
+            auto node = ast.make(ASTNode::Type::VarDecl, varName);
             if (initExpr) node->addChild(std::move(initExpr));
             return node;
         }
-        if (pos < tokens.size() && tokens[pos].getType() == TokenType::PRINT) {
-            pos++; // consumir 'print'
-            auto expr = parseExpression(tokens, pos);
-            if (pos >= tokens.size() || tokens[pos].getType() != TokenType::SEMICOLON) {
+        if (lexer.peek().getType() == TokenType::PRINT) {
+            lexer.next(); // consumir 'print'
+            auto expr = parseExpression(lexer, ast);
+            if (lexer.peek().getType() != TokenType::SEMICOLON) {
                 throw Error(ErrorCodes::ParseError, "Error: Expect ';' after value.\n");
             }
-            pos++; // consumir ';'
-            auto node = std::make_unique<ASTNode>(ASTNode::Type::PrintStmt, "print");
+            lexer.next(); // consumir ';'
+            auto node = ast.make(ASTNode::Type::PrintStmt, "print");
             node->addChild(std::move(expr));
             return node;
         }
 
         // Handle return statement
-        if (pos < tokens.size() && tokens[pos].getType() == TokenType::RETURN) {
-            pos++; // consumir 'return'
-            std::unique_ptr<ASTNode> value;
+        if (lexer.peek().getType() == TokenType::RETURN) {
+            lexer.next(); // consumir 'return'
+            NodePtr value;
             // Expresión opcional antes de ';'
-            if (pos < tokens.size() && tokens[pos].getType() != TokenType::SEMICOLON) {
-                value = parseExpression(tokens, pos);
+            if (lexer.peek().getType() != TokenType::SEMICOLON) {
+                value = parseExpression(lexer, ast);
             }
-            if (pos >= tokens.size() || tokens[pos].getType() != TokenType::SEMICOLON) {
+            if (lexer.peek().getType() != TokenType::SEMICOLON) {
                 throw Error(ErrorCodes::ParseError, "Error: Expect ';' after return value.\n");
             }
-            pos++; // consumir ';'
-            auto node = std::make_unique<ASTNode>(ASTNode::Type::ReturnStmt, "return");
+            lexer.next(); // consumir ';'
+            auto node = ast.make(ASTNode::Type::ReturnStmt, "return");
             if (value) node->addChild(std::move(value));
             return node;
         }
 
         // Si no es print ni var, puede ser expresión o identificador
-        auto expr = parseExpression(tokens, pos);
-        if (pos < tokens.size() && tokens[pos].getType() == TokenType::SEMICOLON) {
-            pos++; // consumir ';'
+        auto expr = parseExpression(lexer, ast);
+        if (lexer.peek().getType() == TokenType::SEMICOLON) {
+            lexer.next(); // consumir ';'
         }
         return expr;
     }
 
     /**
      * @brief Analiza un programa completo (secuencia de declaraciones)
-     * @param tokens Vector de tokens
-     * @param pos Posición actual (modificada por referencia)
-     * @return std::unique_ptr<ASTNode> Nodo raíz del AST
+     * @param lexer Fuente de tokens (se consumen los del nodo)
+     * @param ast Árbol en construcción (reserva los nodos)
+     * @return NodePtr Nodo raíz del AST
      */
-    static std::unique_ptr<ASTNode> parseProgram(const std::pmr::vector<Token>& tokens, size_t& pos) {
-        auto root = std::make_unique<ASTNode>(ASTNode::Type::Program, "program");
-        while (pos < tokens.size() && tokens[pos].getType() != TokenType::EOF_OF_FILE) {
-            root->addChild(parseStatement(tokens, pos));
+    static NodePtr parseProgram(Lexer& lexer, AST& ast) {
+        auto root = ast.make(ASTNode::Type::Program, "program");
+        while (lexer.peek().getType() != TokenType::EOF_OF_FILE) {
+            root->addChild(parseStatement(lexer, ast));
         }
         return root;
     }
 
     // Modificar parse y parseAST para usar parseProgram
-    int parse(const std::pmr::vector<Token>& tokens) {
+    int parse(Lexer& lexer) {
         try {
-            size_t pos = 0;
-            auto root = parseProgram(tokens, pos);
+            auto ast = parseAST(lexer);
+            // Los errores léxicos tienen prioridad sobre cualquier otro
+            if (int code = lexer.finish()) return code;
+            const ASTNode* root = ast->root();
             // Si solo hay un hijo, imprime ese hijo directamente
             if (root->getChildren().size() == 1) {
                 std::cout << root->getChildren()[0]->toString() << std::endl;
@@ -626,13 +703,68 @@ namespace Parser {
             }
             return 0;
         } catch (const Error& e) {
+            if (int code = lexer.finish()) return code;
             std::cerr << e.message;
             return e.type.code;
         }
     }
 
-    std::unique_ptr<ASTNode> parseAST(const std::pmr::vector<Token>& tokens) {
-        size_t pos = 0;
-        return parseProgram(tokens, pos);
+    std::unique_ptr<AST> parseAST(Lexer& lexer) {
+        // Del orden de un nodo por cada pocos caracteres: reservarlo de entrada evita crecer la arena
+        auto ast = std::make_unique<AST>(lexer.getSource().size() / 4 * sizeof(ASTNode));
+        ast->setRoot(parseProgram(lexer, *ast));
+        return ast;
+    }
+
+    Unit parseUnit(std::string_view source) {
+        Unit unit;
+        std::ostringstream errors;
+        // Cadenas propias de este hilo: la tabla del intérprete no admite accesos concurrentes
+        StringTable strings;
+        StringTable* previous = StringTable::install(&strings);
+        Lexer lexer(source, errors);
+        try {
+            auto ast = parseAST(lexer);
+            unit.code = lexer.finish();
+            if (unit.code == 0) unit.ast = std::move(ast);
+        } catch (const Error& e) {
+            unit.code = lexer.finish();
+            if (unit.code == 0) {
+                errors << e.message << std::endl;
+                unit.code = e.type.code;
+            }
+        }
+        StringTable::install(previous);
+        unit.errors = errors.str();
+        return unit;
+    }
+
+    std::vector<Unit> parseAll(const std::vector<std::string_view>& sources, unsigned threads) {
+        std::vector<Unit> units(sources.size());
+        auto order = largestFirst(sources.size(), [&](size_t i) { return sources[i].size(); });
+        parallelFor(order.size(), threads, [&](size_t i) { units[order[i]] = parseUnit(sources[order[i]]); });
+        return units;
+    }
+
+    int parse(const std::vector<std::string_view>& sources, const std::vector<std::string>& names,
+              unsigned threads) {
+        auto units = parseAll(sources, threads);
+        int code = 0;
+        for (size_t i = 0; i < units.size(); ++i) {
+            if (units[i].code == 0) continue;
+            std::cerr << "In " << names[i] << ":" << std::endl << units[i].errors;
+            if (code == 0) code = units[i].code;
+        }
+        if (code) return code;
+
+        auto ast = std::move(units.front().ast);
+        for (size_t i = 1; i < units.size(); ++i) ast->append(std::move(units[i].ast));
+        const ASTNode* root = ast->root();
+        if (root->getChildren().size() == 1) {
+            std::cout << root->getChildren()[0]->toString() << std::endl;
+        } else {
+            std::cout << root->toString() << std::endl;
+        }
+        return 0;
     }
 } // namespace Parser
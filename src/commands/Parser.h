@@ -12,7 +12,11 @@
 #ifndef PARSER_H
 #define PARSER_H
 
-#include <memory_resource>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "Tokenizer.h"
 #include "../def/Tokens.h"
 #include "../def/ASTNode.h"
 #include "../def/ErrorCode.h"
@@ -29,22 +33,24 @@ using Error = TokenTree::Error;
  * del lenguaje Setker.
  */
 namespace Parser {
+    using Tokenizer::Lexer;
+
     /**
      * @brief Analiza tokens y muestra el AST resultante
-     * @param tokens Vector de tokens a analizar
-     * @return int Código de salida (0 = éxito, 65 = error sintáctico)
+     * @param lexer Fuente de los tokens a analizar
+     * @return int Código de salida (0 = éxito, 65 = error léxico o sintáctico)
      * 
      * Realiza el análisis sintáctico completo de los tokens proporcionados,
      * construye el AST y lo imprime en la salida estándar.
      * 
      * Esta función es utilizada por el comando 'parse' del intérprete.
      */
-    int parse(const std::pmr::vector<Token>& tokens);
+    int parse(Lexer& lexer);
     
     /**
      * @brief Construye el AST sin imprimir
-     * @param tokens Vector de tokens a analizar
-     * @return std::unique_ptr<ASTNode> Puntero al nodo raíz del AST
+     * @param lexer Fuente de los tokens a analizar (se consumen bajo demanda)
+     * @return std::unique_ptr<AST> Árbol completo (la raíz está en AST::root)
      * @throws Error Si encuentra errores sintácticos
      * 
      * Realiza el análisis sintáctico de los tokens y devuelve el AST
@@ -53,8 +59,58 @@ namespace Parser {
      * 
      * Implementa un parser recursivo descendente que respeta la
      * precedencia y asociatividad de operadores del lenguaje.
+     *
+     * El parser solo pide al Lexer los tokens que necesita, así que los
+     * errores léxicos posteriores al último token leído siguen sin
+     * informar: antes de usar el AST (o de informar de un Error) hay que
+     * llamar a Lexer::finish.
+     */
+    std::unique_ptr<AST> parseAST(Lexer& lexer);
+
+    /**
+     * @struct Unit
+     * @brief Resultado del análisis de uno de varios archivos (parseAll)
+     */
+    struct Unit {
+        std::unique_ptr<AST> ast; ///< Árbol del archivo (nulo si hubo errores)
+        int code = 0;             ///< 0, o el código de su primer error léxico o sintáctico
+        std::string errors;       ///< Mensajes de error, en el mismo formato que run
+    };
+
+    /**
+     * @brief Tokeniza y parsea un fuente de forma independiente
+     * @param source Código fuente completo
+     * @return Unit Árbol o errores del fuente
+     *
+     * Puede llamarse a la vez desde varios hilos: los errores se guardan en
+     * el resultado y los literales de cadena se crean en una tabla de
+     * cadenas propia de la llamada (que deja de existir al terminar, así
+     * que no quedan internados).
+     */
+    Unit parseUnit(std::string_view source);
+
+    /**
+     * @brief Parsea varios fuentes en paralelo
+     * @param sources Código fuente de cada archivo
+     * @param threads Hilos como máximo (0 = uno por núcleo)
+     * @return std::vector<Unit> Resultado de cada fuente, en el mismo orden
+     */
+    std::vector<Unit> parseAll(const std::vector<std::string_view>& sources, unsigned threads = 0);
+
+    /**
+     * @brief Comando parse con varios archivos
+     * @param sources Código fuente de cada archivo
+     * @param names Nombre de cada archivo, para los mensajes de error
+     * @param threads Hilos como máximo (0 = uno por núcleo)
+     * @return int Código de salida (0, o el del primer archivo con errores)
+     *
+     * Muestra el AST del programa formado por todos los archivos en orden,
+     * igual que si se hubieran concatenado. Si alguno tiene errores, se
+     * informa de los de cada archivo (tras una línea "In <nombre>:") y no
+     * se muestra nada más.
      */
-    std::unique_ptr<ASTNode> parseAST(const std::pmr::vector<Token>& tokens);
+    int parse(const std::vector<std::string_view>& sources, const std::vector<std::string>& names,
+              unsigned threads = 0);
 }
 
 #endif // PARSER_H
@@ -0,0 +1,148 @@
+/**
+ * @file Profiler.cpp
+ * @brief Implementación del perfilador del evaluador
+ * @author Javier
+ * @date 2025
+ */
+
+#include "Profiler.h"
+
+#include <algorithm>
+#include <iomanip>
+
+using namespace TokenTree;
+
+namespace Profiler {
+    constinit thread_local Session* active = nullptr;
+
+    namespace {
+        /// Nodos que se muestran en el informe
+        constexpr size_t NODES_IN_REPORT = 20;
+
+        double milliseconds(Clock::duration duration) {
+            return std::chrono::duration<double, std::milli>(duration).count();
+        }
+
+        /**
+         * @brief Describe un nodo en una línea: tipo y texto
+         * @param node Nodo a describir
+         * @return std::string Por ejemplo "Call fib" o "BinaryOp +"
+         */
+        std::string describe(const ASTNode& node) {
+            std::string text = ASTNode::typeName(node.getType());
+            std::string_view value = node.getValue();
+            // Los bloques llevan "block" como texto y las sentencias no tienen
+            if (!value.empty() && node.getType() != ASTNode::Type::Program) {
+                text += ' ';
+                if (value.size() > 24) {
+                    text += value.substr(0, 21);
+                    text += "...";
+                } else {
+                    text += value;
+                }
+            }
+            return text;
+        }
+    }
+
+    Session::Session() {
+        static const char scriptKey = 0;
+        FunctionStats& script = functions[&scriptKey];
+        script.name = "<script>";
+        script.calls = 1;
+        script.depth = 1;
+        stacks.push_back({&script, {}, {}});
+        frames.push_back({0, Clock::now(), {}});
+    }
+
+    void Session::hit(const ASTNode* node) {
+        NodeStats& stats = nodes[node];
+        if (stats.hits++ == 0) {
+            stats.function = stacks[frames.back().stackNode].function;
+            stats.description = describe(*node);
+        }
+    }
+
+    void Session::enter(const void* key, const std::string& name) {
+        FunctionStats& function = functions[key];
+        if (function.calls++ == 0) function.name = name;
+        ++function.depth;
+
+        size_t parent = frames.back().stackNode;
+        auto [it, inserted] = stacks[parent].children.try_emplace(key, stacks.size());
+        if (inserted) stacks.push_back({&function, {}, {}});
+        frames.push_back({it->second, Clock::now(), {}});
+    }
+
+    void Session::leave() {
+        Frame frame = frames.back();
+        frames.pop_back();
+        Clock::duration elapsed = Clock::now() - frame.start;
+        Clock::duration exclusive = elapsed - frame.children;
+
+        StackNode& stack = stacks[frame.stackNode];
+        FunctionStats& function = *stack.function;
+        stack.exclusive += exclusive;
+        function.exclusive += exclusive;
+        if (--function.depth == 0) function.inclusive += elapsed;
+        if (!frames.empty()) frames.back().children += elapsed;
+    }
+
+    void Session::finish() {
+        while (!frames.empty()) leave();
+    }
+
+    void Session::report(std::ostream& out) const {
+        std::vector<const FunctionStats*> byTime;
+        Clock::duration total{};
+        for (const auto& [key, function] : functions) {
+            byTime.push_back(&function);
+            total += function.exclusive;
+        }
+        std::sort(byTime.begin(), byTime.end(), [](const FunctionStats* a, const FunctionStats* b) {
+            return a->exclusive > b->exclusive;
+        });
+
+        auto flags = out.flags();
+        out << std::fixed << std::setprecision(3);
+        out << "Profile: " << milliseconds(total) << " ms\n\n";
+        out << "Functions (by exclusive time):\n";
+        out << std::setw(12) << "calls" << std::setw(14) << "incl ms" << std::setw(14) << "excl ms"
+            << std::setw(8) << "excl%" << "  function\n";
+        for (const FunctionStats* function : byTime) {
+            double share = total.count() ? 100.0 * function->exclusive.count() / total.count() : 0.0;
+            out << std::setw(12) << function->calls << std::setw(14) << milliseconds(function->inclusive)
+                << std::setw(14) << milliseconds(function->exclusive) << std::setw(7) << std::setprecision(1)
+                << share << '%' << std::setprecision(3) << "  " << function->name << '\n';
+        }
+
+        std::vector<const NodeStats*> byHits;
+        for (const auto& [node, stats] : nodes) byHits.push_back(&stats);
+        size_t shown = std::min(byHits.size(), NODES_IN_REPORT);
+        std::partial_sort(byHits.begin(), byHits.begin() + shown, byHits.end(), [](const NodeStats* a, const NodeStats* b) {
+            return a->hits > b->hits;
+        });
+        out << "\nHottest nodes:\n";
+        out << std::setw(12) << "hits" << "  function: node\n";
+        for (size_t i = 0; i < shown; ++i) {
+            const NodeStats* stats = byHits[i];
+            out << std::setw(12) << stats->hits << "  " << stats->function->name << ": " << stats->description << '\n';
+        }
+        out.flags(flags);
+    }
+
+    void Session::writeFolded(std::ostream& out) const {
+        // Recorrido en profundidad del árbol de pilas, con la pila de nombres actual
+        std::vector<std::pair<size_t, std::string>> pending{{0, stacks[0].function->name}};
+        while (!pending.empty()) {
+            auto [index, path] = std::move(pending.back());
+            pending.pop_back();
+            const StackNode& node = stacks[index];
+            auto micros = std::chrono::duration_cast<std::chrono::microseconds>(node.exclusive).count();
+            if (micros > 0) out << path << ' ' << micros << '\n';
+            for (const auto& [key, child] : node.children) {
+                pending.emplace_back(child, path + ';' + stacks[child].function->name);
+            }
+        }
+    }
+}
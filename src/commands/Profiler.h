@@ -0,0 +1,163 @@
+/**
+ * @file Profiler.h
+ * @brief Perfilador del evaluador (comando profile)
+ * @author Javier
+ * @date 2025
+ *
+ * Este archivo define la sesión de perfilado que el evaluador alimenta
+ * mientras ejecuta un programa con 'profile': cuántas veces se llama cada
+ * función y cuánto tiempo pasa en ella (incluyendo o no a las funciones
+ * que llama), cuántas veces se evalúa cada nodo del AST y las pilas de
+ * llamadas en formato "folded" para generar flamegraphs.
+ */
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "../def/ASTNode.h"
+
+/**
+ * @namespace Profiler
+ * @brief Espacio de nombres para el perfilado de programas
+ */
+namespace Profiler {
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * @class Session
+     * @brief Datos recogidos durante una ejecución perfilada
+     *
+     * Las funciones se identifican por su declaración (una closure creada
+     * varias veces cuenta como la misma función). El tiempo inclusivo de
+     * una función recursiva solo se suma en la llamada más externa, para
+     * no contarlo varias veces.
+     */
+    class Session {
+    public:
+        Session();
+
+        /**
+         * @brief Cuenta una evaluación de un nodo
+         * @param node Nodo evaluado
+         */
+        void hit(const TokenTree::ASTNode* node);
+
+        /**
+         * @brief Registra la entrada en una función
+         * @param key Identidad de la función (su cuerpo, o el objeto de una nativa)
+         * @param name Nombre con el que se muestra
+         */
+        void enter(const void* key, const std::string& name);
+
+        /**
+         * @brief Registra la salida de la función en curso
+         */
+        void leave();
+
+        /**
+         * @brief Da por terminada la sesión (cierra las llamadas abiertas)
+         */
+        void finish();
+
+        /**
+         * @brief Escribe el informe: funciones por tiempo exclusivo y nodos más evaluados
+         * @param out Flujo de salida
+         */
+        void report(std::ostream& out) const;
+
+        /**
+         * @brief Escribe las pilas de llamadas en formato folded (flamegraph.pl)
+         * @param out Flujo de salida
+         *
+         * Una línea por pila: nombres separados por ';' y microsegundos de
+         * tiempo exclusivo.
+         */
+        void writeFolded(std::ostream& out) const;
+
+    private:
+        /**
+         * @struct FunctionStats
+         * @brief Acumulados de una función
+         */
+        struct FunctionStats {
+            std::string name;
+            uint64_t calls = 0;
+            Clock::duration inclusive{};
+            Clock::duration exclusive{};
+            uint32_t depth = 0; ///< Llamadas abiertas (recursión)
+        };
+
+        /**
+         * @struct StackNode
+         * @brief Nodo del árbol de pilas de llamadas
+         */
+        struct StackNode {
+            FunctionStats* function;
+            std::unordered_map<const void*, size_t> children; ///< Por función llamada
+            Clock::duration exclusive{};
+        };
+
+        /**
+         * @struct Frame
+         * @brief Llamada en curso
+         */
+        struct Frame {
+            size_t stackNode;          ///< Posición en stacks
+            Clock::time_point start;   ///< Momento de entrada
+            Clock::duration children{}; ///< Tiempo pasado en las funciones llamadas
+        };
+
+        /**
+         * @struct NodeStats
+         * @brief Evaluaciones de un nodo
+         */
+        struct NodeStats {
+            uint64_t hits = 0;
+            const FunctionStats* function = nullptr; ///< Función en la que está el nodo
+            std::string description;                 ///< Tipo y texto (el AST ya no existe al informar)
+        };
+
+        std::unordered_map<const void*, FunctionStats> functions;
+        std::unordered_map<const TokenTree::ASTNode*, NodeStats> nodes; ///< Solo como clave, sin desreferenciar al informar
+        std::vector<StackNode> stacks; ///< stacks[0] es el programa (<script>)
+        std::vector<Frame> frames;     ///< Llamadas abiertas, con el programa en la base
+    };
+
+    /**
+     * @brief Sesión en curso, o nullptr si no se está perfilando
+     *
+     * El evaluador solo comprueba este puntero: sin perfilar, el coste es
+     * una comparación por nodo. Es propio de cada hilo, como el Context.
+     */
+    extern constinit thread_local Session* active;
+
+    /**
+     * @class Scope
+     * @brief Entrada y salida RAII de una función en la sesión activa
+     *
+     * También registra la salida si la función termina con un error.
+     */
+    class Scope {
+    public:
+        Scope(const void* key, const std::string& name) : session(active) {
+            if (session) session->enter(key, name);
+        }
+        ~Scope() {
+            if (session) session->leave();
+        }
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        Session* session;
+    };
+}
+
+#endif // PROFILER_H
@@ -0,0 +1,152 @@
+/**
+ * @file Resolver.cpp
+ * @brief Implementación de la resolución estática de variables
+ * @author Javier
+ * @date 2025
+ *
+ * Este archivo recorre el AST una vez antes de evaluarlo y asigna a cada
+ * bloque y a cada lista de parámetros un entorno con ranuras numeradas.
+ * La estructura de ámbitos reproduce exactamente la del evaluador: cada
+ * bloque crea un entorno, y cada llamada crea uno para los parámetros
+ * (hijo del closure) más el del bloque que forma el cuerpo.
+ *
+ * También marca qué entornos puede capturar una closure (ASTNode::isCaptured);
+ * el evaluador reserva los demás en su arena sin pasar por el heap.
+ */
+
+#include "Resolver.h"
+
+
+using namespace TokenTree;
+
+namespace Resolver {
+    void collectDeclarations(const ASTNode* node, std::vector<std::string_view>& names) {
+        const auto& children = node->getChildren();
+        switch (node->getType()) {
+            case ASTNode::Type::VarDecl:
+            case ASTNode::Type::Function:
+                names.push_back(node->getValue());
+                break;
+            case ASTNode::Type::IfStmt:
+                for (size_t i = 1; i < children.size(); ++i) collectDeclarations(children[i].get(), names);
+                break;
+            case ASTNode::Type::WhileStmt:
+                collectDeclarations(children[1].get(), names);
+                break;
+            default:
+                break;
+        }
+    }
+
+    namespace {
+        using Type = ASTNode::Type;
+
+        /**
+         * @class ScopeResolver
+         * @brief Estado de la resolución: pila de ámbitos locales abiertos
+         *
+         * La pila vacía representa el nivel global, cuyas variables no
+         * tienen ranura y se buscan por nombre.
+         */
+        class ScopeResolver {
+        public:
+            void program(ASTNode* node) {
+                for (const auto& child : node->getChildren()) visit(child.get());
+            }
+
+        private:
+            /**
+             * @struct Scope
+             * @brief Ámbito local abierto y el nodo que lo crea
+             */
+            struct Scope {
+                ASTNode* owner;                                  ///< Bloque o función del ámbito
+                NameMap<uint32_t> slots;                         ///< Ranura de cada nombre
+            };
+
+            std::vector<Scope> scopes; ///< Ámbitos abiertos, del más exterior al más interior
+
+            uint32_t slotFor(Scope& scope, std::string_view name) {
+                // Un nombre repetido reutiliza su ranura, igual que Environment::define
+                auto it = scope.slots.find(name);
+                if (it == scope.slots.end()) it = scope.slots.emplace(name, static_cast<uint32_t>(scope.slots.size())).first;
+                return it->second;
+            }
+
+            std::vector<LocalSlot> lookup(std::string_view name) const {
+                std::vector<LocalSlot> chain;
+                for (size_t i = scopes.size(); i-- > 0;) {
+                    auto found = scopes[i].slots.find(name);
+                    if (found != scopes[i].slots.end()) {
+                        chain.push_back({static_cast<uint32_t>(scopes.size() - 1 - i), found->second});
+                    }
+                }
+                return chain;
+            }
+
+            void declare(ASTNode* node) {
+                if (scopes.empty()) return; // global: se define por nombre
+                node->setSlots({{0, scopes.back().slots.find(node->getValue())->second}});
+            }
+
+            void block(ASTNode* node) {
+                const auto& children = node->getChildren();
+                std::vector<std::string_view> names;
+                for (const auto& child : children) collectDeclarations(child.get(), names);
+                Scope scope{node, {}};
+                for (const auto& name : names) slotFor(scope, name);
+                scopes.push_back(std::move(scope));
+                for (const auto& child : children) visit(child.get());
+                node->setScopeSize(static_cast<uint32_t>(scopes.back().slots.size()));
+                scopes.pop_back();
+            }
+
+            void function(ASTNode* node) {
+                declare(node);
+                // La closure captura el entorno de la declaración y, con él, todos sus ancestros
+                for (auto& scope : scopes) scope.owner->setCaptured();
+                const auto& children = node->getChildren();
+                // Último hijo es el cuerpo, los anteriores son parámetros
+                Scope params{node, {}};
+                for (size_t i = 0; i + 1 < children.size(); ++i) {
+                    ASTNode* param = children[i].get();
+                    param->setSlots({{0, slotFor(params, param->getValue())}});
+                }
+                node->setScopeSize(static_cast<uint32_t>(params.slots.size()));
+                scopes.push_back(std::move(params));
+                block(children.back().get());
+                scopes.pop_back();
+            }
+
+            void visit(ASTNode* node) {
+                const auto& children = node->getChildren();
+                switch (node->getType()) {
+                    case Type::Program:
+                        block(node);
+                        return;
+                    case Type::Function:
+                        function(node);
+                        return;
+                    case Type::VarDecl:
+                        // El inicializador se resuelve antes de que la variable exista
+                        for (const auto& child : children) visit(child.get());
+                        declare(node);
+                        return;
+                    case Type::Identifier:
+                    case Type::Call:
+                        node->setSlots(lookup(node->getValue()));
+                        for (const auto& child : children) visit(child.get());
+                        return;
+                    default:
+                        for (const auto& child : children) visit(child.get());
+                        return;
+                }
+            }
+        };
+    }
+
+    void resolve(ASTNode* program) {
+        ScopeResolver resolver;
+        resolver.program(program);
+    }
+}
@@ -0,0 +1,51 @@
+/**
+ * @file Resolver.h
+ * @brief Resolución estática de variables para el evaluador
+ * @author Javier
+ * @date 2025
+ *
+ * Este archivo define la pasada que se ejecuta entre Parser::parseAST y la
+ * evaluación. Calcula en qué entorno y en qué ranura vive cada variable
+ * local, de modo que el evaluador accede a ellas por índice en lugar de
+ * buscarlas por nombre en cada nivel de la cadena de entornos.
+ */
+
+#ifndef RESOLVER_H
+#define RESOLVER_H
+
+#include <string_view>
+#include <vector>
+
+#include "../def/ASTNode.h"
+
+/**
+ * @namespace Resolver
+ * @brief Espacio de nombres para la resolución de variables
+ */
+namespace Resolver {
+    /**
+     * @brief Reúne los nombres que una sentencia define en el ámbito actual
+     * @param node Sentencia a inspeccionar
+     * @param names Lista de nombres (se amplía)
+     *
+     * Una declaración que es cuerpo directo de un if/while (sin llaves)
+     * define en el ámbito que la contiene, así que también se recorre.
+     */
+    void collectDeclarations(const TokenTree::ASTNode* node, std::vector<std::string_view>& names);
+
+    /**
+     * @brief Anota el AST con las ubicaciones de las variables locales
+     * @param program Nodo raíz del AST (tipo Program)
+     *
+     * Cada bloque y cada lista de parámetros recibe un tamaño de entorno
+     * (ASTNode::getScopeSize) y cada referencia la lista de ranuras donde
+     * puede vivir (ASTNode::getSlots). Las declaraciones de un bloque se
+     * reservan al entrar en él, pero una ranura solo se usa una vez
+     * definida: hasta entonces la búsqueda continúa en los entornos
+     * exteriores, igual que Environment::get. Las variables de nivel
+     * superior siguen siendo globales y se buscan por nombre.
+     */
+    void resolve(TokenTree::ASTNode* program);
+}
+
+#endif // RESOLVER_H
@@ -12,56 +12,308 @@
  * - Análisis sintáctico (parsing) de tokens a AST
  * - Evaluación del AST resultante
  * - Manejo de errores y códigos de salida
+ * - Intérpretes independientes (Interpreter), cada uno con su Context
  */
 
 #include "Run.h"
 #include "Parser.h"
+#include "Profiler.h"
 #include "Evaluator.h"
+#include "Optimizer.h"
+#include "Resolver.h"
+#include "Stats.h"
+#include "VM.h"
+#include "../def/ASTCache.h"
 #include "../def/ErrorCode.h"
+#include "../def/Context.h"
+#include "../def/Parallel.h"
 #include <iostream>
-#include <memory_resource>
+
+using TokenTree::ASTNode;
 
 namespace Run {
+    Interpreter::Interpreter(std::FILE* output, std::ostream& errors)
+        : owned(std::make_unique<TokenTree::Context>(output)), context(owned.get()), errors(&errors) {}
+
+    Interpreter::Interpreter(TokenTree::Context& context, std::ostream& errors)
+        : context(&context), errors(&errors) {}
+
+    Interpreter::~Interpreter() {
+        // La máquina guarda valores con cadenas de la tabla del Context
+        TokenTree::Context::Scope scope(*context);
+        machine.reset();
+    }
+
+    Interpreter& Interpreter::process() {
+        // Nunca se destruye, como el Context del proceso
+        static auto* interpreter = new Interpreter(TokenTree::Context::process(), std::cerr);
+        return *interpreter;
+    }
+
+    TokenTree::Output& Interpreter::output() {
+        return context->output;
+    }
+
+    TokenTree::Heap& Interpreter::heap() {
+        return context->heap;
+    }
+
+    TokenTree::StringTable& Interpreter::strings() {
+        return context->strings;
+    }
+
+    void Interpreter::reset() {
+        TokenTree::Context::Scope scope(*context);
+        context->resetGlobals();
+        if (machine) machine->reset();
+        // Ya ninguna función global apunta a estos árboles
+        retained.clear();
+    }
+
+    /**
+     * @brief Optimiza y resuelve (o compila) un AST recién parseado
+     * @param ast Programa parseado (sin resolver)
+     * @param options Motor de ejecución y optimizaciones
+     * @return std::unique_ptr<Program> Programa listo para execute()
+     * @throws Error Si el programa excede los límites del bytecode
+     */
+    std::unique_ptr<Program> Interpreter::compile(std::unique_ptr<TokenTree::AST> ast, const Options& options) {
+        auto program = std::make_unique<Program>();
+        program->options = options;
+        program->ast = std::move(ast);
+        ASTNode* root = program->ast->root();
+        // Plegar constantes antes de resolver: el resolver ve el árbol definitivo
+        if (options.optimize) Optimizer::optimize(*program->ast);
+        if (options.backend == Backend::VM && !options.profiler && !options.stats) {
+            // Compilar a bytecode para la máquina virtual (sus globales persisten)
+            if (!machine) machine = std::make_unique<VM::Machine>();
+            program->script = machine->compile(root);
+        } else {
+            // Resolver las variables locales a ranuras
+            Resolver::resolve(root);
+        }
+        return program;
+    }
+
+    /**
+     * @brief Ejecuta un programa ya preparado con el motor indicado
+     * @param program Programa de compile()
+     * @throws Evaluator::Error Si el programa falla en tiempo de ejecución
+     *
+     * Al terminar, también por un error, vacía la salida de print: así lo
+     * impreso aparece antes que el mensaje de error que se escriba después.
+     *
+     * Sin options.stats, los límites de options.budget se comprueban con
+     * una sesión propia: en el evaluador como con --max-*, y en la máquina
+     * virtual en cada vuelta de bucle y cada llamada.
+     */
+    void Interpreter::execute(const Program& program) {
+        Stats::Session limits(program.options.budget);
+        Stats::Session* session = program.options.stats;
+        if (!session && program.options.budget.limited()) session = &limits;
+        if (session) session->start(context->heap);
+        try {
+            if (program.script) {
+                machine->run(program.script, session);
+            } else {
+                Profiler::active = program.options.profiler;
+                Stats::active = session;
+                // Perfilar o medir parallel_map exige ejecutar sus llamadas en este hilo
+                context->workers = Profiler::active || Stats::active ? 1 : program.options.threads;
+                Evaluator::evalNode(program.ast->root());
+            }
+        } catch (...) {
+            Profiler::active = nullptr;
+            Stats::active = nullptr;
+            context->output.flush();
+            throw;
+        }
+        Profiler::active = nullptr;
+        Stats::active = nullptr;
+        context->output.flush();
+    }
+
+    /**
+     * @brief Parsea y prepara un programa, guardando opcionalmente su AST
+     * @param lexer Fuente de los tokens del programa
+     * @param options Motor de ejecución y optimizaciones
+     * @param cachePath Archivo donde guardar el AST (nullptr para no guardarlo)
+     * @param program Recibe el programa preparado
+     * @return int 0, o el código de error ya informado
+     */
+    int Interpreter::parse(Tokenizer::Lexer& lexer, const Options& options, const std::string* cachePath,
+                           std::unique_ptr<Program>& program) {
+        try {
+            // Usar el AST del parser - Convierte tokens a estructura de árbol
+            auto ast = Parser::parseAST(lexer);
+            // Los errores léxicos tienen prioridad y cancelan la ejecución
+            if (int code = lexer.finish()) return code;
+            // Solo se guardan programas sin errores de compilación, antes de
+            // prepararlos (el resolver anota el árbol, pero eso no se serializa)
+            if (cachePath) TokenTree::ASTCache::store(*cachePath, lexer.getSource(), *ast);
+
+            program = compile(std::move(ast), options);
+            return 0;
+        } catch (const Evaluator::Error& e) {
+            if (int code = lexer.finish()) return code;
+            // Error específico del evaluador - reportar mensaje y código
+            *errors << e.message << std::endl;
+            return e.type.code;
+        } catch (const std::exception& e) {
+            // Error general del sistema - reportar mensaje genérico
+            *errors << e.what() << std::endl;
+            return 1; // Código de error genérico
+        }
+    }
+
+    int Interpreter::prepare(std::string_view source, const Options& options, std::unique_ptr<Program>& program) {
+        TokenTree::Context::Scope scope(*context);
+        Tokenizer::Lexer lexer(source, *errors);
+        return parse(lexer, options, nullptr, program);
+    }
+
+    int Interpreter::run(const Program& program) {
+        TokenTree::Context::Scope scope(*context);
+        try {
+            execute(program);
+            return 0; // Ejecución exitosa
+        } catch (const Evaluator::Error& e) {
+            *errors << e.message << std::endl;
+            return e.type.code;
+        } catch (const std::exception& e) {
+            *errors << e.what() << std::endl;
+            return 1;
+        }
+    }
+
+    /**
+     * @brief Ejecuta un programa de un solo uso y conserva su AST si hace falta
+     * @param program Programa preparado (se consume)
+     * @return int Código de salida del programa
+     */
+    int Interpreter::runOnce(std::unique_ptr<Program> program) {
+        int code = run(*program);
+        // Las funciones del evaluador apuntan a su cuerpo dentro del AST
+        if (!program->script) retained.push_back(std::move(program->ast));
+        return code;
+    }
+
+    int Interpreter::run(std::string_view source, const Options& options) {
+        TokenTree::Context::Scope scope(*context);
+        Tokenizer::Lexer lexer(source, *errors);
+        return run(lexer, options);
+    }
+
+    int Interpreter::run(Tokenizer::Lexer& lexer, const Options& options) {
+        TokenTree::Context::Scope scope(*context);
+        std::unique_ptr<Program> program;
+        if (int code = parse(lexer, options, nullptr, program)) return code;
+        return runOnce(std::move(program));
+    }
+
+    int Interpreter::run(std::string_view source, const std::string& cachePath, const Options& options) {
+        TokenTree::Context::Scope scope(*context);
+        std::unique_ptr<Program> program;
+        auto ast = TokenTree::ASTCache::load(cachePath, source);
+        if (!ast) {
+            // Sin caché válida: camino normal, dejando el AST guardado para la próxima vez
+            Tokenizer::Lexer lexer(source, *errors);
+            if (int code = parse(lexer, options, &cachePath, program)) return code;
+            return runOnce(std::move(program));
+        }
+        // Un programa en caché nunca tuvo errores léxicos ni sintácticos
+        return runAST(std::move(ast), options);
+    }
+
+    /**
+     * @brief Prepara y ejecuta un AST sin errores de compilación
+     * @param ast Programa parseado (sin resolver)
+     * @param options Motor de ejecución y optimizaciones
+     * @return int Código de salida del programa
+     */
+    int Interpreter::runAST(std::unique_ptr<TokenTree::AST> ast, const Options& options) {
+        std::unique_ptr<Program> program;
+        try {
+            program = compile(std::move(ast), options);
+        } catch (const Evaluator::Error& e) {
+            *errors << e.message << std::endl;
+            return e.type.code;
+        } catch (const std::exception& e) {
+            *errors << e.what() << std::endl;
+            return 1;
+        }
+        return runOnce(std::move(program));
+    }
+
+    int Interpreter::run(const std::vector<Source>& sources, const Options& options) {
+        TokenTree::Context::Scope scope(*context);
+        if (sources.empty()) return 0;
+
+        // Front end en paralelo: cada archivo con su caché o su propio Lexer
+        std::vector<Parser::Unit> units(sources.size());
+        auto order = TokenTree::largestFirst(sources.size(), [&](size_t i) { return sources[i].text.size(); });
+        TokenTree::parallelFor(order.size(), options.threads, [&](size_t i) {
+            const Source& source = sources[order[i]];
+            Parser::Unit& unit = units[order[i]];
+            if (!source.cachePath.empty()) {
+                TokenTree::StringTable strings;
+                TokenTree::StringTable* previous = TokenTree::StringTable::install(&strings);
+                unit.ast = TokenTree::ASTCache::load(source.cachePath, source.text);
+                TokenTree::StringTable::install(previous);
+                if (unit.ast) return;
+            }
+            unit = Parser::parseUnit(source.text);
+            if (unit.ast && !source.cachePath.empty()) TokenTree::ASTCache::store(source.cachePath, source.text, *unit.ast);
+        });
+
+        int code = 0;
+        for (size_t i = 0; i < units.size(); ++i) {
+            if (units[i].code == 0) continue;
+            // Los números de línea son los de cada archivo
+            *errors << "In " << sources[i].name << ":" << std::endl << units[i].errors;
+            if (code == 0) code = units[i].code;
+        }
+        if (code) return code;
+
+        // Un único programa con las sentencias de todos los archivos, en orden
+        auto ast = std::move(units.front().ast);
+        for (size_t i = 1; i < units.size(); ++i) ast->append(std::move(units[i].ast));
+        return runAST(std::move(ast), options);
+    }
+
     /**
      * @brief Ejecuta un programa Setker a partir de su secuencia de tokens
      * 
      * Esta función implementa el pipeline completo de ejecución:
      * 1. Convierte los tokens en un Árbol de Sintaxis Abstracta (AST)
-     * 2. Evalúa el AST para ejecutar el programa
+     * 2. Evalúa el AST para ejecutar el programa (o lo compila a bytecode
+     *    y lo ejecuta en la máquina virtual si options.backend es Backend::VM)
      * 3. Maneja errores y retorna códigos de salida apropiados
      * 
-     * @param tokens Vector de tokens que representa el programa a ejecutar
+     * @param lexer Fuente de los tokens que representan el programa
+     * @param options Motor de ejecución y optimizaciones
      * @return int Código de salida del programa:
      *         - 0: Ejecución exitosa
      *         - Código específico de error: Según el tipo de error encontrado
      *         - 1: Error general o excepción no controlada
      * 
-     * @throws std::exception Para errores inesperados del sistema
-     * 
      * Flujo de ejecución:
      * - Parser::parseAST() convierte tokens en AST
-     * - Evaluator::evalNode() ejecuta el programa
+     * - Optimizer::optimize() pliega constantes (solo con options.optimize)
+     * - Resolver::resolve() calcula las ranuras de las variables locales
+     * - Evaluator::evalNode() o VM::Machine::interpret() ejecuta el programa
      * - Los errores de evaluación se capturan y reportan con código específico
      * - Las excepciones no controladas se reportan con código genérico
      */
-    int run(const std::pmr::vector<Token>& tokens) {
-        try {
-            // Usar el AST del parser - Convierte tokens a estructura de árbol
-            auto ast = Parser::parseAST(tokens);
-            
-            // Evaluar el AST - Ejecuta el programa representado por el árbol
-            // Soporta declaraciones print, expresiones aritméticas y lógicas
-            Evaluator::evalNode(ast.get());
-            
-            return 0; // Ejecución exitosa
-        } catch (const Evaluator::Error& e) {
-            // Error específico del evaluador - reportar mensaje y código
-            std::cerr << e.message << std::endl;
-            return e.type.code;
-        } catch (const std::exception& e) {
-            // Error general del sistema - reportar mensaje genérico
-            std::cerr << e.what() << std::endl;
-            return 1; // Código de error genérico
-        }
+    int run(Tokenizer::Lexer& lexer, const Options& options) {
+        return Interpreter::process().run(lexer, options);
+    }
+
+    int run(std::string_view source, const std::string& cachePath, const Options& options) {
+        return Interpreter::process().run(source, cachePath, options);
+    }
+
+    int run(const std::vector<Source>& sources, const Options& options) {
+        return Interpreter::process().run(sources, options);
     }
 }
@@ -12,9 +12,31 @@
 #pragma once
 #include <vector>
 #include <string>
+#include <string_view>
 #include <memory>
+#include <cstdio>
+#include <iostream>
+#include "Stats.h"
+#include "Tokenizer.h"
+#include "../def/ASTNode.h"
 #include "../def/Tokens.h"
 
+namespace Profiler {
+    class Session;
+}
+
+namespace VM {
+    class Machine;
+}
+
+namespace TokenTree {
+    class Context;
+    struct FunctionProto;
+    class Heap;
+    class Output;
+    class StringTable;
+}
+
 /**
  * @namespace Run
  * @brief Espacio de nombres para la ejecución completa de programas
@@ -25,16 +47,169 @@
  * y estructuras de control.
  */
 namespace Run {
+    /**
+     * @enum Backend
+     * @brief Motor de ejecución utilizado por run()
+     */
+    enum class Backend {
+        TreeWalker, ///< Evaluador recursivo sobre el AST (Evaluator::evalNode)
+        VM          ///< Compilación a bytecode y máquina virtual (VM::Machine)
+    };
+
+    /**
+     * @struct Options
+     * @brief Opciones de ejecución del comando run
+     */
+    struct Options {
+        Backend backend = Backend::TreeWalker; ///< Motor de ejecución
+        bool optimize = false;                 ///< Aplicar Optimizer::optimize antes de ejecutar (-O)
+        Profiler::Session* profiler = nullptr; ///< Sesión a alimentar (comando profile; fuerza TreeWalker)
+        Stats::Session* stats = nullptr;       ///< Estadísticas y límites (--stats, --max-*; fuerza TreeWalker)
+        Stats::Budget budget;                  ///< Límites si no hay stats (también con Backend::VM; serve)
+        unsigned threads = 0;                  ///< Hilos del front end y de parallel_map (0 = uno por núcleo, -j)
+    };
+
+    /**
+     * @struct Source
+     * @brief Uno de los archivos de un programa de varios archivos
+     */
+    struct Source {
+        std::string name;       ///< Nombre del archivo, para los mensajes de error
+        std::string_view text;  ///< Código fuente completo
+        std::string cachePath;  ///< Caché de su AST (vacío = no usarla)
+    };
+
+    /**
+     * @struct Program
+     * @brief Programa listo para ejecutarse (ver Interpreter::prepare)
+     *
+     * Contiene el AST ya optimizado y resuelto o, con Backend::VM, también
+     * su bytecode. Puede ejecutarse muchas veces, pero solo en el
+     * Interpreter que lo preparó.
+     */
+    struct Program {
+        Options options;                                  ///< Opciones con las que se preparó
+        std::unique_ptr<TokenTree::AST> ast;              ///< Árbol del programa
+        std::shared_ptr<TokenTree::FunctionProto> script; ///< Bytecode (solo con Backend::VM)
+    };
+
+    /**
+     * @class Interpreter
+     * @brief Intérprete reutilizable con su propio estado
+     *
+     * Cada Interpreter tiene un TokenTree::Context propio (tabla de cadenas,
+     * marcos, salida de print y globales) y, si se usa la máquina virtual,
+     * su propia VM::Machine. Los globales persisten entre llamadas a run()
+     * hasta reset(), como en una sesión interactiva.
+     *
+     * Varios Interpreter pueden ejecutarse a la vez en hilos distintos, pero
+     * cada uno solo en un hilo a la vez, y sin compartir valores ni árboles
+     * entre ellos: los nodos guardan en caché la dirección del global que
+     * nombran (ASTNode::getGlobalCache).
+     */
+    class Interpreter {
+    public:
+        /**
+         * @brief Crea un intérprete con un Context nuevo
+         * @param output Archivo donde escribe print
+         * @param errors Flujo de los mensajes de error (léxicos, sintácticos y de ejecución)
+         */
+        explicit Interpreter(std::FILE* output = stdout, std::ostream& errors = std::cerr);
+        ~Interpreter();
+
+        Interpreter(const Interpreter&) = delete;
+        Interpreter& operator=(const Interpreter&) = delete;
+
+        /**
+         * @brief Intérprete del proceso, sobre TokenTree::Context::process()
+         * @return Interpreter& El que usan las funciones libres run()
+         */
+        static Interpreter& process();
+
+        /**
+         * @brief Ejecuta un programa desde su código fuente
+         * @param source Código fuente completo
+         * @param options Motor de ejecución y optimizaciones
+         * @return int Código de salida (0 = éxito, >0 = error)
+         */
+        int run(std::string_view source, const Options& options = {});
+
+        /// @brief Como Run::run(Tokenizer::Lexer&, const Options&), en este intérprete
+        int run(Tokenizer::Lexer& lexer, const Options& options = {});
+
+        /// @brief Como Run::run(std::string_view, const std::string&, const Options&), en este intérprete
+        int run(std::string_view source, const std::string& cachePath, const Options& options = {});
+
+        /// @brief Como Run::run(const std::vector<Source>&, const Options&), en este intérprete
+        int run(const std::vector<Source>& sources, const Options& options = {});
+
+        /**
+         * @brief Parsea un programa y lo deja listo para run(const Program&)
+         * @param source Código fuente completo
+         * @param options Motor de ejecución y optimizaciones
+         * @param program Recibe el programa preparado si no hay errores
+         * @return int 0, o el código del error léxico, sintáctico o de
+         *         compilación (ya informado en el flujo de errores)
+         */
+        int prepare(std::string_view source, const Options& options, std::unique_ptr<Program>& program);
+
+        /**
+         * @brief Ejecuta un programa preparado por este intérprete
+         * @param program Programa de prepare()
+         * @return int Código de salida (0 = éxito, >0 = error)
+         *
+         * Las funciones que defina apuntan a su AST: el programa debe
+         * seguir vivo mientras no se llame a reset().
+         */
+        int run(const Program& program);
+
+        /**
+         * @brief Olvida los globales definidos por los programas anteriores
+         *
+         * Deja solo las funciones nativas, en los dos motores. Los programas
+         * preparados siguen siendo válidos.
+         */
+        void reset();
+
+        /// @brief Salida de print de este intérprete (capacidad, archivo)
+        TokenTree::Output& output();
+
+        /// @brief Recolector de ciclos de este intérprete (umbrales, estadísticas)
+        TokenTree::Heap& heap();
+
+        /// @brief Cadenas internadas de este intérprete
+        TokenTree::StringTable& strings();
+
+    private:
+        Interpreter(TokenTree::Context& context, std::ostream& errors);
+
+        std::unique_ptr<Program> compile(std::unique_ptr<TokenTree::AST> ast, const Options& options);
+        void execute(const Program& program);
+        int runOnce(std::unique_ptr<Program> program);
+        int runAST(std::unique_ptr<TokenTree::AST> ast, const Options& options);
+        int parse(Tokenizer::Lexer& lexer, const Options& options, const std::string* cachePath,
+                  std::unique_ptr<Program>& program);
+
+        std::unique_ptr<TokenTree::Context> owned; ///< Context propio (nulo en el del proceso)
+        TokenTree::Context* context;               ///< Context sobre el que se ejecuta
+        std::ostream* errors;                      ///< Destino de los mensajes de error
+        std::unique_ptr<VM::Machine> machine;      ///< Se crea en la primera ejecución con Backend::VM
+        std::vector<std::unique_ptr<TokenTree::AST>> retained; ///< ASTs de los que dependen las funciones globales (hasta reset)
+    };
+
     /**
      * @brief Ejecuta un programa completo desde tokens
-     * @param tokens Vector de tokens que representa el programa
+     * @param lexer Fuente de los tokens que representan el programa
+     * @param options Motor de ejecución y optimizaciones
      * @return int Código de salida (0 = éxito, >0 = error)
      * 
-     * Toma una secuencia de tokens previamente generada por el tokenizer
-     * y ejecuta el programa completo:
-     * 1. Construye el AST usando el parser
-     * 2. Evalúa el programa completo usando el evaluador
-     * 3. Maneja errores y devuelve códigos de salida apropiados
+     * Consume los tokens que produce el Lexer y ejecuta el programa
+     * completo:
+     * 1. Construye el AST usando el parser (los errores léxicos tienen
+     *    prioridad sobre los sintácticos y cancelan la ejecución)
+     * 2. Lo simplifica con Optimizer::optimize si options.optimize
+     * 3. Evalúa el programa completo usando el evaluador
+     * 4. Maneja errores y devuelve códigos de salida apropiados
      * 
      * Esta función es utilizada por el comando 'run' del intérprete
      * y representa la funcionalidad principal para ejecutar programas
@@ -44,6 +219,40 @@ namespace Run {
      * de expresiones, 'run' ejecuta programas completos incluyendo
      * efectos secundarios como instrucciones print, modificación de
      * variables y ejecución de funciones.
+     *
+     * Se ejecuta en Interpreter::process().
+     */
+    int run(Tokenizer::Lexer& lexer, const Options& options = {});
+
+    /**
+     * @brief Ejecuta un programa reutilizando su AST en caché si es posible
+     * @param source Código fuente completo del programa
+     * @param cachePath Archivo de caché del programa (TokenTree::ASTCache::pathFor)
+     * @param options Motor de ejecución y optimizaciones
+     * @return int Código de salida (0 = éxito, >0 = error)
+     *
+     * Si cachePath contiene el AST de exactamente este fuente, se ejecuta
+     * directamente sin tokenizar ni parsear. Si no, se hace lo mismo que en
+     * run(Lexer&, const Options&) y, si el programa no tiene errores léxicos
+     * ni sintácticos, su AST se guarda en cachePath antes de ejecutarlo. La
+     * caché contiene siempre el AST sin optimizar.
+     */
+    int run(std::string_view source, const std::string& cachePath, const Options& options = {});
+
+    /**
+     * @brief Ejecuta un programa repartido en varios archivos
+     * @param sources Archivos del programa, en el orden en que se ejecutan
+     * @param options Motor de ejecución, optimizaciones e hilos del front end
+     * @return int Código de salida (0 = éxito, >0 = error)
+     *
+     * Cada archivo se tokeniza y parsea (o se lee de su caché) en paralelo,
+     * en options.threads hilos. Si alguno tiene errores léxicos o
+     * sintácticos se informa de los de cada archivo, en orden y tras una
+     * línea "In <nombre>:", y no se ejecuta nada. Si no, las sentencias de
+     * todos se ejecutan en orden como un único programa, con un solo
+     * entorno global: el resultado es el mismo que el de concatenar los
+     * archivos, incluidos los números [line N] de los errores. Se ejecuta
+     * en Interpreter::process().
      */
-    int run(const std::pmr::vector<Token>& tokens);
+    int run(const std::vector<Source>& sources, const Options& options = {});
 }
@@ -0,0 +1,274 @@
+/**
+ * @file Scan.cpp
+ * @brief Implementación de las búsquedas vectorizadas del tokenizer
+ * @author Javier
+ * @date 2025
+ *
+ * Cada conjunto de instrucciones procesa bloques completos del ancho de
+ * su registro y deja el resto (menos de un bloque, al final del código)
+ * a la versión escalar, de modo que nunca se lee fuera del texto.
+ */
+
+#include "Scan.h"
+
+#include <bit>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#include <immintrin.h>
+#define SETKER_SCAN_SSE2 1
+#if defined(__GNUC__) || defined(__clang__)
+#define SETKER_SCAN_AVX2 1
+#define SETKER_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define SETKER_SCAN_NEON 1
+#endif
+
+namespace Tokenizer::Scan {
+    // --- Escalar -------------------------------------------------------
+
+    static const char* scalarFind(const char* begin, const char* end, char c) {
+        const void* found = std::memchr(begin, c, static_cast<size_t>(end - begin));
+        return found ? static_cast<const char*>(found) : end;
+    }
+
+    static size_t scalarCount(const char* begin, const char* end, char c) {
+        size_t n = 0;
+        for (; begin < end; ++begin) n += *begin == c;
+        return n;
+    }
+
+    static const char* scalarSkip(const char* begin, const char* end, uint8_t classes) {
+        while (begin < end && is(*begin, classes)) ++begin;
+        return begin;
+    }
+
+    static const char* scalarSkipIdentifier(const char* begin, const char* end) {
+        return scalarSkip(begin, end, Letter | Digit);
+    }
+
+    static const char* scalarSkipBlanks(const char* begin, const char* end) {
+        return scalarSkip(begin, end, Blank);
+    }
+
+#ifdef SETKER_SCAN_SSE2
+    // --- SSE2 (siempre disponible en x86-64) ---------------------------
+
+    static inline __m128i sse2Load(const char* p) {
+        return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    }
+
+    /// Bytes de v en [lo, hi]: min(v - lo, hi - lo) == v - lo sin signo
+    static inline __m128i sse2InRange(__m128i v, char lo, char hi) {
+        __m128i offset = _mm_sub_epi8(v, _mm_set1_epi8(lo));
+        return _mm_cmpeq_epi8(_mm_min_epu8(offset, _mm_set1_epi8(static_cast<char>(hi - lo))), offset);
+    }
+
+    static inline uint32_t sse2Eq(__m128i v, char c) {
+        return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8(c))));
+    }
+
+    static inline uint32_t sse2Identifier(__m128i v) {
+        // v | 0x20 lleva 'A'-'Z' a 'a'-'z' sin meter ningún otro byte en el rango
+        __m128i letter = sse2InRange(_mm_or_si128(v, _mm_set1_epi8(0x20)), 'a', 'z');
+        __m128i digit = sse2InRange(v, '0', '9');
+        __m128i underscore = _mm_cmpeq_epi8(v, _mm_set1_epi8('_'));
+        return static_cast<uint32_t>(_mm_movemask_epi8(_mm_or_si128(_mm_or_si128(letter, digit), underscore)));
+    }
+
+    static const char* sse2Find(const char* begin, const char* end, char c) {
+        for (; end - begin >= 16; begin += 16) {
+            if (uint32_t mask = sse2Eq(sse2Load(begin), c)) return begin + std::countr_zero(mask);
+        }
+        return scalarFind(begin, end, c);
+    }
+
+    static size_t sse2Count(const char* begin, const char* end, char c) {
+        size_t n = 0;
+        for (; end - begin >= 16; begin += 16) n += std::popcount(sse2Eq(sse2Load(begin), c));
+        return n + scalarCount(begin, end, c);
+    }
+
+    static const char* sse2SkipIdentifier(const char* begin, const char* end) {
+        for (; end - begin >= 16; begin += 16) {
+            if (uint32_t mask = ~sse2Identifier(sse2Load(begin)) & 0xFFFF) return begin + std::countr_zero(mask);
+        }
+        return scalarSkipIdentifier(begin, end);
+    }
+
+    static const char* sse2SkipBlanks(const char* begin, const char* end) {
+        for (; end - begin >= 16; begin += 16) {
+            __m128i v = sse2Load(begin);
+            if (uint32_t mask = ~(sse2Eq(v, ' ') | sse2Eq(v, '\t')) & 0xFFFF) return begin + std::countr_zero(mask);
+        }
+        return scalarSkipBlanks(begin, end);
+    }
+#endif
+
+#ifdef SETKER_SCAN_AVX2
+    // --- AVX2 (se comprueba en tiempo de ejecución) --------------------
+
+    SETKER_TARGET_AVX2 static inline __m256i avx2Load(const char* p) {
+        return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+    }
+
+    SETKER_TARGET_AVX2 static inline __m256i avx2InRange(__m256i v, char lo, char hi) {
+        __m256i offset = _mm256_sub_epi8(v, _mm256_set1_epi8(lo));
+        return _mm256_cmpeq_epi8(_mm256_min_epu8(offset, _mm256_set1_epi8(static_cast<char>(hi - lo))), offset);
+    }
+
+    SETKER_TARGET_AVX2 static inline uint32_t avx2Eq(__m256i v, char c) {
+        return static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(c))));
+    }
+
+    SETKER_TARGET_AVX2 static inline uint32_t avx2Identifier(__m256i v) {
+        __m256i letter = avx2InRange(_mm256_or_si256(v, _mm256_set1_epi8(0x20)), 'a', 'z');
+        __m256i digit = avx2InRange(v, '0', '9');
+        __m256i underscore = _mm256_cmpeq_epi8(v, _mm256_set1_epi8('_'));
+        return static_cast<uint32_t>(
+            _mm256_movemask_epi8(_mm256_or_si256(_mm256_or_si256(letter, digit), underscore)));
+    }
+
+    SETKER_TARGET_AVX2 static const char* avx2Find(const char* begin, const char* end, char c) {
+        for (; end - begin >= 32; begin += 32) {
+            if (uint32_t mask = avx2Eq(avx2Load(begin), c)) return begin + std::countr_zero(mask);
+        }
+        return sse2Find(begin, end, c);
+    }
+
+    SETKER_TARGET_AVX2 static size_t avx2Count(const char* begin, const char* end, char c) {
+        size_t n = 0;
+        for (; end - begin >= 32; begin += 32) n += std::popcount(avx2Eq(avx2Load(begin), c));
+        return n + sse2Count(begin, end, c);
+    }
+
+    SETKER_TARGET_AVX2 static const char* avx2SkipIdentifier(const char* begin, const char* end) {
+        for (; end - begin >= 32; begin += 32) {
+            if (uint32_t mask = ~avx2Identifier(avx2Load(begin))) return begin + std::countr_zero(mask);
+        }
+        return sse2SkipIdentifier(begin, end);
+    }
+
+    SETKER_TARGET_AVX2 static const char* avx2SkipBlanks(const char* begin, const char* end) {
+        for (; end - begin >= 32; begin += 32) {
+            __m256i v = avx2Load(begin);
+            if (uint32_t mask = ~(avx2Eq(v, ' ') | avx2Eq(v, '\t'))) return begin + std::countr_zero(mask);
+        }
+        return sse2SkipBlanks(begin, end);
+    }
+#endif
+
+#ifdef SETKER_SCAN_NEON
+    // --- NEON (siempre disponible en AArch64) --------------------------
+
+    static inline uint8x16_t neonLoad(const char* p) {
+        return vld1q_u8(reinterpret_cast<const uint8_t*>(p));
+    }
+
+    /// NEON no tiene movemask: cada byte de la comparación se reduce a 4 bits
+    static inline uint64_t neonMask(uint8x16_t matches) {
+        return vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(matches), 4)), 0);
+    }
+
+    static inline uint8x16_t neonInRange(uint8x16_t v, uint8_t lo, uint8_t hi) {
+        return vcleq_u8(vsubq_u8(v, vdupq_n_u8(lo)), vdupq_n_u8(static_cast<uint8_t>(hi - lo)));
+    }
+
+    static inline uint8x16_t neonIdentifier(uint8x16_t v) {
+        uint8x16_t letter = neonInRange(vorrq_u8(v, vdupq_n_u8(0x20)), 'a', 'z');
+        uint8x16_t digit = neonInRange(v, '0', '9');
+        uint8x16_t underscore = vceqq_u8(v, vdupq_n_u8('_'));
+        return vorrq_u8(vorrq_u8(letter, digit), underscore);
+    }
+
+    static const char* neonFind(const char* begin, const char* end, char c) {
+        for (; end - begin >= 16; begin += 16) {
+            uint8x16_t matches = vceqq_u8(neonLoad(begin), vdupq_n_u8(static_cast<uint8_t>(c)));
+            if (uint64_t mask = neonMask(matches)) return begin + std::countr_zero(mask) / 4;
+        }
+        return scalarFind(begin, end, c);
+    }
+
+    static size_t neonCount(const char* begin, const char* end, char c) {
+        size_t n = 0;
+        for (; end - begin >= 16; begin += 16) {
+            uint8x16_t matches = vceqq_u8(neonLoad(begin), vdupq_n_u8(static_cast<uint8_t>(c)));
+            n += std::popcount(neonMask(matches)) / 4;
+        }
+        return n + scalarCount(begin, end, c);
+    }
+
+    static const char* neonSkipIdentifier(const char* begin, const char* end) {
+        for (; end - begin >= 16; begin += 16) {
+            if (uint64_t mask = ~neonMask(neonIdentifier(neonLoad(begin)))) return begin + std::countr_zero(mask) / 4;
+        }
+        return scalarSkipIdentifier(begin, end);
+    }
+
+    static const char* neonSkipBlanks(const char* begin, const char* end) {
+        for (; end - begin >= 16; begin += 16) {
+            uint8x16_t v = neonLoad(begin);
+            uint8x16_t blank = vorrq_u8(vceqq_u8(v, vdupq_n_u8(' ')), vceqq_u8(v, vdupq_n_u8('\t')));
+            if (uint64_t mask = ~neonMask(blank)) return begin + std::countr_zero(mask) / 4;
+        }
+        return scalarSkipBlanks(begin, end);
+    }
+#endif
+
+    // --- Selección -----------------------------------------------------
+
+    /**
+     * @struct Kernels
+     * @brief Implementación de las primitivas para un conjunto de instrucciones
+     */
+    struct Kernels {
+        const char* name;
+        const char* (*find)(const char*, const char*, char);
+        size_t (*count)(const char*, const char*, char);
+        const char* (*skipIdentifier)(const char*, const char*);
+        const char* (*skipBlanks)(const char*, const char*);
+    };
+
+    static Kernels select() {
+#ifdef SETKER_SCAN_AVX2
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) {
+            return {"avx2", avx2Find, avx2Count, avx2SkipIdentifier, avx2SkipBlanks};
+        }
+#endif
+#if defined(SETKER_SCAN_SSE2)
+        return {"sse2", sse2Find, sse2Count, sse2SkipIdentifier, sse2SkipBlanks};
+#elif defined(SETKER_SCAN_NEON)
+        return {"neon", neonFind, neonCount, neonSkipIdentifier, neonSkipBlanks};
+#else
+        return {"scalar", scalarFind, scalarCount, scalarSkipIdentifier, scalarSkipBlanks};
+#endif
+    }
+
+    static const Kernels& kernels() {
+        static const Kernels selected = select();
+        return selected;
+    }
+
+    const char* find(const char* begin, const char* end, char c) {
+        return kernels().find(begin, end, c);
+    }
+
+    size_t count(const char* begin, const char* end, char c) {
+        return kernels().count(begin, end, c);
+    }
+
+    const char* skipIdentifier(const char* begin, const char* end) {
+        return kernels().skipIdentifier(begin, end);
+    }
+
+    const char* skipBlanks(const char* begin, const char* end) {
+        return kernels().skipBlanks(begin, end);
+    }
+
+    const char* implementation() {
+        return kernels().name;
+    }
+}
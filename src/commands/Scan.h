@@ -0,0 +1,95 @@
+/**
+ * @file Scan.h
+ * @brief Búsquedas vectorizadas para los bucles internos del tokenizer
+ * @author Javier
+ * @date 2025
+ *
+ * Este archivo define la tabla de clases de caracteres del lenguaje y las
+ * primitivas con las que el Lexer salta comentarios, cadenas, espacios e
+ * identificadores. Cada primitiva tiene versiones SSE2 y AVX2 (x86-64) y
+ * NEON (AArch64), además de una escalar; la implementación se elige una
+ * vez al arrancar según lo que soporte el procesador.
+ */
+
+#ifndef SCAN_H
+#define SCAN_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace Tokenizer::Scan {
+    /**
+     * @enum CharClass
+     * @brief Bits de clase de un carácter en CHAR_CLASS
+     */
+    enum CharClass : uint8_t {
+        Letter = 1 << 0,  ///< a-z, A-Z y '_'
+        Digit  = 1 << 1,  ///< 0-9
+        Blank  = 1 << 2   ///< ' ' y '\t' (el salto de línea se trata aparte)
+    };
+
+    /// Clase de cada uno de los 256 valores de un byte
+    inline constexpr std::array<uint8_t, 256> CHAR_CLASS = [] {
+        std::array<uint8_t, 256> table{};
+        for (int c = 'a'; c <= 'z'; ++c) table[c] |= Letter;
+        for (int c = 'A'; c <= 'Z'; ++c) table[c] |= Letter;
+        table['_'] |= Letter;
+        for (int c = '0'; c <= '9'; ++c) table[c] |= Digit;
+        table[' '] |= Blank;
+        table['\t'] |= Blank;
+        return table;
+    }();
+
+    /**
+     * @brief Comprueba si un carácter pertenece a alguna de las clases
+     * @param c Carácter
+     * @param classes Máscara de CharClass
+     * @return bool true si c tiene alguno de los bits
+     */
+    inline bool is(char c, uint8_t classes) {
+        return (CHAR_CLASS[static_cast<unsigned char>(c)] & classes) != 0;
+    }
+
+    /**
+     * @brief Busca la primera aparición de un byte
+     * @param begin Inicio del rango
+     * @param end Fin del rango
+     * @param c Byte buscado
+     * @return const char* Posición del byte, o end si no aparece
+     */
+    const char* find(const char* begin, const char* end, char c);
+
+    /**
+     * @brief Cuenta las apariciones de un byte
+     * @param begin Inicio del rango
+     * @param end Fin del rango
+     * @param c Byte contado
+     * @return size_t Número de apariciones
+     */
+    size_t count(const char* begin, const char* end, char c);
+
+    /**
+     * @brief Salta una secuencia de letras, dígitos y '_'
+     * @param begin Inicio del rango
+     * @param end Fin del rango
+     * @return const char* Primer carácter que no es alfanumérico, o end
+     */
+    const char* skipIdentifier(const char* begin, const char* end);
+
+    /**
+     * @brief Salta una secuencia de espacios y tabuladores
+     * @param begin Inicio del rango
+     * @param end Fin del rango
+     * @return const char* Primer carácter que no es Blank, o end
+     */
+    const char* skipBlanks(const char* begin, const char* end);
+
+    /**
+     * @brief Nombre de la implementación elegida
+     * @return const char* "avx2", "sse2", "neon" o "scalar"
+     */
+    const char* implementation();
+}
+
+#endif // SCAN_H
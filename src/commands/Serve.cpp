@@ -0,0 +1,299 @@
+/**
+ * @file Serve.cpp
+ * @brief Implementación del modo servidor
+ * @author Javier
+ * @date 2025
+ */
+
+#include "Serve.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+
+#include "../def/ASTCache.h"
+#include "../def/Heap.h"
+#include "../def/Output.h"
+#include "../def/SourceFile.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#define SETKER_UNIX_SOCKETS 1
+#endif
+
+namespace Serve {
+    namespace {
+        /**
+         * @brief Lee una línea sin el salto final
+         * @param in Flujo de entrada
+         * @param line Recibe la línea
+         * @return bool false al final de la entrada
+         */
+        bool readLine(std::FILE* in, std::string& line) {
+            line.clear();
+            char chunk[256];
+            while (std::fgets(chunk, sizeof(chunk), in)) {
+                line.append(chunk);
+                if (line.back() == '\n') {
+                    line.pop_back();
+                    if (!line.empty() && line.back() == '\r') line.pop_back();
+                    return true;
+                }
+            }
+            return !line.empty();
+        }
+
+        /**
+         * @brief Separa la primera palabra de un texto
+         * @param text Texto restante (avanza tras la palabra y sus espacios)
+         * @return std::string_view Palabra (vacía si no quedan)
+         */
+        std::string_view nextWord(std::string_view& text) {
+            size_t end = text.find(' ');
+            std::string_view word = text.substr(0, end);
+            text.remove_prefix(end == std::string_view::npos ? text.size() : end);
+            while (!text.empty() && text.front() == ' ') text.remove_prefix(1);
+            return word;
+        }
+
+        /**
+         * @brief Lee las opciones de ejecución al principio de una petición
+         * @param text Resto de la petición (avanza tras las opciones)
+         * @param budget Límites del servidor
+         * @return Run::Options Opciones indicadas
+         */
+        Run::Options parseOptions(std::string_view& text, const Stats::Budget& budget) {
+            Run::Options options;
+            options.budget = budget;
+            while (true) {
+                std::string_view rest = text;
+                std::string_view word = nextWord(rest);
+                if (word == "--vm") {
+                    options.backend = Run::Backend::VM;
+                } else if (word == "-O") {
+                    options.optimize = true;
+                } else {
+                    return options;
+                }
+                text = rest;
+            }
+        }
+
+        /**
+         * @brief Escribe en out una respuesta de error del protocolo
+         */
+        void fail(std::FILE* out, std::string_view message) {
+            std::fprintf(out, "fail %.*s\n", static_cast<int>(message.size()), message.data());
+            std::fflush(out);
+        }
+
+#ifdef SETKER_UNIX_SOCKETS
+        /**
+         * @brief Borra el socket que haya en una ruta
+         * @param path Ruta del socket
+         * @return bool false si en la ruta hay algo que no es un socket (no se toca)
+         */
+        bool removeSocket(const std::string& path) {
+            struct stat info;
+            if (lstat(path.c_str(), &info) != 0) return errno == ENOENT;
+            if (!S_ISSOCK(info.st_mode)) return false;
+            unlink(path.c_str());
+            return true;
+        }
+#endif
+    }
+
+    Server::Server(size_t cacheCapacity, const Stats::Budget& budget)
+        : interpreter(nullptr, errors), capacity(cacheCapacity > 0 ? cacheCapacity : 1), budget(budget) {}
+
+    Server::~Server() = default;
+
+    /**
+     * @brief Busca el programa preparado de un fuente o lo prepara
+     * @param source Código fuente del trabajo
+     * @param options Motor de ejecución y optimizaciones
+     * @param hit Recibe true si el programa ya estaba en la caché
+     * @param code Recibe el código del error si no se pudo preparar
+     * @return const Run::Program* Programa, o nullptr si tiene errores (no se guarda)
+     */
+    const Run::Program* Server::lookup(std::string_view source, const Run::Options& options, bool& hit, int& code) {
+        // Cada combinación de opciones necesita su propio programa preparado
+        uint64_t mode = (options.backend == Run::Backend::VM ? 1 : 0) | (options.optimize ? 2 : 0);
+        uint64_t key = TokenTree::ASTCache::hash(source) ^ (mode * 0x9E3779B97F4A7C15ULL);
+
+        hit = false;
+        auto found = index.find(key);
+        if (found != index.end()) {
+            auto entry = found->second;
+            const Run::Options& cached = entry->program->options;
+            if (entry->source == source && cached.backend == options.backend && cached.optimize == options.optimize) {
+                entries.splice(entries.begin(), entries, entry);
+                hit = true;
+                return entry->program.get();
+            }
+            // Colisión del hash: el programa nuevo ocupa su lugar
+            entries.erase(entry);
+            index.erase(found);
+        }
+
+        std::unique_ptr<Run::Program> program;
+        code = interpreter.prepare(source, options, program);
+        if (code) return nullptr;
+        if (entries.size() >= capacity) {
+            index.erase(entries.back().key);
+            entries.pop_back();
+        }
+        entries.push_front({key, std::string(source), std::move(program)});
+        index[key] = entries.begin();
+        return entries.front().program.get();
+    }
+
+    /**
+     * @brief Ejecuta un trabajo y escribe su respuesta
+     * @param source Código fuente del trabajo
+     * @param options Motor de ejecución y optimizaciones
+     * @param out Flujo de las respuestas
+     */
+    void Server::job(std::string_view source, const Run::Options& options, std::FILE* out) {
+        auto start = std::chrono::steady_clock::now();
+        // Cada trabajo empieza con un entorno global nuevo (y así ninguna
+        // función global apunta a un programa que la caché pueda descartar)
+        interpreter.reset();
+        bool hit = false;
+        int code = 0;
+        if (const Run::Program* program = lookup(source, options, hit, code)) code = interpreter.run(*program);
+        auto micros = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+
+        ++jobs;
+        if (hit) ++hits;
+        std::string printed = interpreter.output().take();
+        std::string messages = errors.str();
+        errors.str({});
+        errors.clear();
+
+        std::fprintf(out, "done code=%d out=%zu err=%zu time_us=%lld cache=%s\n", code, printed.size(),
+                     messages.size(), static_cast<long long>(micros.count()), hit ? "hit" : "miss");
+        std::fwrite(printed.data(), 1, printed.size(), out);
+        std::fwrite(messages.data(), 1, messages.size(), out);
+        std::fflush(out);
+    }
+
+    bool Server::handle(std::FILE* in, std::FILE* out) {
+        std::string line;
+        while (readLine(in, line)) {
+            std::string_view request = line;
+            std::string_view command = nextWord(request);
+            if (command.empty()) continue;
+
+            if (command == "run") {
+                Run::Options options = parseOptions(request, budget);
+                if (request.empty()) {
+                    fail(out, "Usage: run [--vm] [-O] <filename>");
+                    continue;
+                }
+                TokenTree::SourceFile file{std::string(request)};
+                if (!file.isOpen()) {
+                    fail(out, "Error reading file: " + std::string(request));
+                    continue;
+                }
+                job(file.contents(), options, out);
+            } else if (command == "source") {
+                Run::Options options = parseOptions(request, budget);
+                char* end;
+                std::string size(request);
+                unsigned long long bytes = std::strtoull(size.c_str(), &end, 10);
+                if (size.empty() || *end != '\0' || size.front() == '-') {
+                    fail(out, "Usage: source [--vm] [-O] <bytes>");
+                    continue;
+                }
+                if (bytes > MAX_SOURCE_BYTES) {
+                    // Los bytes del programa no se leen: el resto de la entrada no se puede interpretar
+                    fail(out, "Source too large (limit is " + std::to_string(MAX_SOURCE_BYTES) + " bytes)");
+                    return false;
+                }
+                std::string source(static_cast<size_t>(bytes), '\0');
+                if (std::fread(source.data(), 1, source.size(), in) != source.size()) {
+                    fail(out, "Unexpected end of input");
+                    return false;
+                }
+                job(source, options, out);
+            } else if (command == "stats") {
+                const TokenTree::HeapStats& heap = interpreter.heap().stats();
+                size_t live = 0;
+                for (size_t count : heap.live) live += count;
+                std::fprintf(out, "stats jobs=%llu hits=%llu misses=%llu programs=%zu heap=%zu collected=%llu\n",
+                             static_cast<unsigned long long>(jobs), static_cast<unsigned long long>(hits),
+                             static_cast<unsigned long long>(jobs - hits), entries.size(), live,
+                             static_cast<unsigned long long>(heap.collected));
+                std::fflush(out);
+            } else if (command == "quit") {
+                return true;
+            } else {
+                fail(out, "Unknown request: " + std::string(command));
+            }
+        }
+        return false;
+    }
+
+    int serve(const Options& options) {
+        Server server(options.cacheCapacity, options.budget);
+        if (options.socketPath.empty()) {
+            server.handle(stdin, stdout);
+            return 0;
+        }
+#ifdef SETKER_UNIX_SOCKETS
+        sockaddr_un address{};
+        if (options.socketPath.size() >= sizeof(address.sun_path)) {
+            std::cerr << "Socket path too long: " << options.socketPath << std::endl;
+            return 1;
+        }
+        address.sun_family = AF_UNIX;
+        std::memcpy(address.sun_path, options.socketPath.data(), options.socketPath.size());
+
+        // Un socket de una ejecución anterior impediría el bind; cualquier
+        // otro archivo en esa ruta se deja como está
+        if (!removeSocket(options.socketPath)) {
+            std::cerr << "Not a socket: " << options.socketPath << std::endl;
+            return 1;
+        }
+        int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (listener < 0 || bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+            listen(listener, 16) != 0) {
+            std::cerr << "Error listening on socket: " << options.socketPath << std::endl;
+            if (listener >= 0) close(listener);
+            return 1;
+        }
+        // Un cliente que se va sin leer su respuesta no debe terminar el servidor
+        std::signal(SIGPIPE, SIG_IGN);
+
+        // Las conexiones se atienden de una en una, cada una hasta que se cierra
+        bool quit = false;
+        while (!quit) {
+            int connection = accept(listener, nullptr, nullptr);
+            if (connection < 0) {
+                if (errno == EINTR) continue;
+                break;
+            }
+            // Lectura y escritura con FILE distintos, cada uno con su descriptor
+            int copy = dup(connection);
+            std::FILE* in = fdopen(connection, "r");
+            std::FILE* out = copy >= 0 ? fdopen(copy, "w") : nullptr;
+            if (in && out) quit = server.handle(in, out);
+            if (in) std::fclose(in); else close(connection);
+            if (out) std::fclose(out); else if (copy >= 0) close(copy);
+        }
+        close(listener);
+        removeSocket(options.socketPath);
+        return quit ? 0 : 1;
+#else
+        std::cerr << "serve --socket is not supported on this platform" << std::endl;
+        return 1;
+#endif
+    }
+}
@@ -0,0 +1,136 @@
+/**
+ * @file Serve.h
+ * @brief Modo servidor: muchos programas en un mismo proceso
+ * @author Javier
+ * @date 2025
+ *
+ * Este archivo define el comando serve, que mantiene un intérprete vivo y
+ * ejecuta los trabajos que recibe por la entrada estándar o por un socket
+ * Unix. Cada programa se parsea una sola vez: los siguientes trabajos con
+ * el mismo contenido reutilizan el programa ya preparado, de modo que un
+ * script pequeño y repetido se ejecuta en microsegundos en lugar de pagar
+ * en cada trabajo el arranque del proceso, la lectura, el análisis léxico
+ * y el sintáctico.
+ *
+ * Protocolo (una petición por línea):
+ * - `run [--vm] [-O] <ruta>`: ejecuta el archivo (la ruta llega hasta el
+ *   final de la línea)
+ * - `source [--vm] [-O] <bytes>`: ejecuta el programa formado por los
+ *   <bytes> bytes que siguen a la línea (como mucho
+ *   Server::MAX_SOURCE_BYTES; si pide más se responde fail y se cierra la
+ *   conexión, porque ya no se puede saber dónde empieza la siguiente
+ *   petición)
+ * - `stats`: informa del uso de la caché de programas y de los objetos
+ *   vivos en el heap del intérprete
+ * - `quit`: termina el servidor
+ *
+ * Cada trabajo se responde con la línea
+ * `done code=<código> out=<bytes> err=<bytes> time_us=<µs> cache=<hit|miss>`
+ * seguida de lo que el programa imprimió y de sus mensajes de error. Un
+ * trabajo que supera los límites del servidor (10 s por defecto) termina
+ * con el código 75. Una
+ * petición inválida se responde con `fail <mensaje>`.
+ */
+
+#ifndef SERVE_H
+#define SERVE_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <list>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include "Run.h"
+#include "Stats.h"
+
+/**
+ * @namespace Serve
+ * @brief Espacio de nombres del comando serve
+ */
+namespace Serve {
+    /**
+     * @struct Options
+     * @brief Opciones del comando serve
+     */
+    struct Options {
+        std::string socketPath;     ///< Socket Unix donde escuchar (vacío = stdin/stdout)
+        size_t cacheCapacity = 256; ///< Programas preparados que se conservan
+        Stats::Budget budget{0, std::chrono::seconds(10)}; ///< Límites de cada trabajo (--max-steps, --max-time)
+    };
+
+    /**
+     * @class Server
+     * @brief Intérprete persistente con caché de programas preparados
+     *
+     * Los programas se identifican por el hash de su contenido y por las
+     * opciones con que se preparan; cuando la caché se llena se descarta el
+     * usado hace más tiempo. Antes de cada trabajo se vacía el entorno
+     * global, así que ningún trabajo ve las variables de otro.
+     *
+     * Cada trabajo se ejecuta con los límites de Run::Options::budget: uno
+     * que no termina falla con BudgetExceeded y el servidor sigue atendiendo
+     * a los siguientes.
+     */
+    class Server {
+    public:
+        /// Tamaño máximo del programa de una petición source (64 MiB)
+        static constexpr size_t MAX_SOURCE_BYTES = size_t{64} << 20;
+
+        /**
+         * @brief Constructor de Server
+         * @param cacheCapacity Programas preparados que se conservan (al menos 1)
+         * @param budget Límites de cada trabajo
+         */
+        explicit Server(size_t cacheCapacity = Options{}.cacheCapacity, const Stats::Budget& budget = Options{}.budget);
+        ~Server();
+
+        Server(const Server&) = delete;
+        Server& operator=(const Server&) = delete;
+
+        /**
+         * @brief Atiende peticiones hasta el final de la entrada o quit
+         * @param in Flujo de las peticiones
+         * @param out Flujo de las respuestas
+         * @return bool true si se recibió quit
+         */
+        bool handle(std::FILE* in, std::FILE* out);
+
+    private:
+        /**
+         * @struct Entry
+         * @brief Programa de la caché
+         */
+        struct Entry {
+            uint64_t key;                         ///< Clave en index
+            std::string source;                   ///< Contenido (para descartar colisiones del hash)
+            std::unique_ptr<Run::Program> program; ///< Programa preparado
+        };
+
+        std::ostringstream errors;      ///< Mensajes de error del trabajo en curso
+        Run::Interpreter interpreter;   ///< Intérprete de todos los trabajos (salida en memoria)
+        std::list<Entry> entries;       ///< Programas, del usado más recientemente al que menos
+        std::unordered_map<uint64_t, std::list<Entry>::iterator> index; ///< Programa por clave
+        size_t capacity;                ///< Máximo de elementos en entries
+        Stats::Budget budget;           ///< Límites de cada trabajo
+        uint64_t jobs = 0;              ///< Trabajos ejecutados
+        uint64_t hits = 0;              ///< Trabajos que reutilizaron su programa
+
+        void job(std::string_view source, const Run::Options& options, std::FILE* out);
+        const Run::Program* lookup(std::string_view source, const Run::Options& options, bool& hit, int& code);
+    };
+
+    /**
+     * @brief Ejecuta el comando serve
+     * @param options Transporte y tamaño de la caché
+     * @return int Código de salida (0 = terminó con quit o al acabar la entrada)
+     */
+    int serve(const Options& options);
+}
+
+#endif // SERVE_H
@@ -0,0 +1,118 @@
+/**
+ * @file Stats.cpp
+ * @brief Implementación de las estadísticas y límites de ejecución
+ * @author Javier
+ * @date 2025
+ */
+
+#include "Stats.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "../def/ErrorCode.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#define SETKER_RUSAGE 1
+#endif
+
+using namespace TokenTree;
+
+namespace Stats {
+    constinit thread_local Session* active = nullptr;
+
+    namespace {
+        /**
+         * @brief Memoria residente máxima del proceso hasta ahora
+         * @return size_t Bytes (0 si la plataforma no la informa)
+         */
+        size_t peakResidentBytes() {
+#ifdef SETKER_RUSAGE
+            rusage usage{};
+            if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+#ifdef __APPLE__
+            return static_cast<size_t>(usage.ru_maxrss);
+#else
+            return static_cast<size_t>(usage.ru_maxrss) * 1024;
+#endif
+#else
+            return 0;
+#endif
+        }
+    }
+
+    Session::Session(const Budget& budget) : budget(budget), started(Clock::now()) {}
+
+    void Session::start(const Heap& heap) {
+        this->heap = &heap;
+        started = Clock::now();
+        checked = 0;
+        countdown = budget.steps ? static_cast<uint32_t>(std::min<uint64_t>(CHECK_INTERVAL, budget.steps + 1))
+                                 : CHECK_INTERVAL;
+        interval = countdown;
+    }
+
+    void Session::finish() {
+        elapsed = Clock::now() - started;
+    }
+
+    void Session::openEnvironment(bool onHeap) {
+        ++environments;
+        if (onHeap) ++heapEnvironments;
+        else ++openFrames;
+        size_t live = openFrames;
+        if (heap) live += heap->stats().live[static_cast<size_t>(Collectable::Type::Environment)];
+        peakEnvironments = std::max(peakEnvironments, live);
+    }
+
+    void Session::checkpoint() {
+        checked += interval;
+        if (budget.steps && checked > budget.steps) {
+            throw Error(ErrorCodes::BudgetExceeded, "Step budget of " + std::to_string(budget.steps) + " exceeded.");
+        }
+        if (budget.time.count() && Clock::now() - started > budget.time) {
+            throw Error(ErrorCodes::BudgetExceeded, "Time budget of " + std::to_string(budget.time.count()) +
+                        " ms exceeded.");
+        }
+        if (budget.memory && peakResidentBytes() > budget.memory) {
+            throw Error(ErrorCodes::BudgetExceeded, "Memory budget of " +
+                        std::to_string(budget.memory / (1024 * 1024)) + " MB exceeded.");
+        }
+        // La última vuelta antes del límite de pasos se acorta para detenerse justo en él
+        uint64_t next = CHECK_INTERVAL;
+        if (budget.steps) next = std::min<uint64_t>(next, budget.steps + 1 - checked);
+        countdown = interval = static_cast<uint32_t>(next);
+    }
+
+    void Session::report(std::ostream& out) const {
+        uint64_t nodes = 0;
+        std::vector<std::pair<uint64_t, ASTNode::Type>> byType;
+        for (size_t i = 0; i < visits.size(); ++i) {
+            nodes += visits[i];
+            if (visits[i]) byType.emplace_back(visits[i], static_cast<ASTNode::Type>(i));
+        }
+        std::sort(byType.begin(), byType.end(), [](const auto& a, const auto& b) { return a.first > b.first; });
+
+        char milliseconds[32];
+        std::snprintf(milliseconds, sizeof(milliseconds), "%.3f",
+                      std::chrono::duration<double, std::milli>(elapsed).count());
+        out << "Stats: " << nodes << " nodes in " << milliseconds << " ms, " << calls + nativeCalls << " calls ("
+            << nativeCalls << " native), " << stringBytes << " string bytes\n";
+        out << "  Nodes:";
+        for (size_t i = 0; i < byType.size(); ++i) {
+            out << (i ? ", " : " ") << byType[i].first << ' ' << ASTNode::typeName(byType[i].second);
+        }
+        out << "\n  Environments: " << environments << " created (" << heapEnvironments << " on the heap), peak "
+            << peakEnvironments << " live\n";
+        out << "  Lookups:";
+        for (size_t depth = 0; depth < DEPTHS; ++depth) {
+            if (!lookups[depth]) continue;
+            out << ' ' << lookups[depth] << " at depth " << depth << (depth + 1 == DEPTHS ? "+" : "") << ',';
+        }
+        out << ' ' << globals << " global\n";
+    }
+}
@@ -0,0 +1,191 @@
+/**
+ * @file Stats.h
+ * @brief Estadísticas y límites de ejecución del evaluador (run --stats, --max-*)
+ * @author Javier
+ * @date 2025
+ *
+ * Este archivo define la sesión que el evaluador alimenta mientras ejecuta
+ * un programa con --stats o con algún límite: nodos evaluados por tipo,
+ * entornos creados y el máximo vivo a la vez, búsquedas de variables por
+ * profundidad en la cadena de entornos, llamadas y bytes de las cadenas
+ * creadas. La misma cuenta de nodos sirve para detener un programa que
+ * supera el número de pasos, el tiempo o la memoria permitidos.
+ */
+
+#ifndef STATS_H
+#define STATS_H
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+#include "../def/ASTNode.h"
+#include "../def/Heap.h"
+
+/**
+ * @namespace Stats
+ * @brief Espacio de nombres de las estadísticas y límites de ejecución
+ */
+namespace Stats {
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * @struct Budget
+     * @brief Límites de una ejecución (0 = sin límite)
+     */
+    struct Budget {
+        uint64_t steps = 0;               ///< Nodos evaluados (--max-steps)
+        std::chrono::milliseconds time{}; ///< Tiempo de ejecución (--max-time)
+        size_t memory = 0;                ///< Memoria residente máxima del proceso, en bytes (--max-memory)
+
+        /// @brief true si hay algún límite
+        bool limited() const { return steps || time.count() || memory; }
+    };
+
+    /**
+     * @class Session
+     * @brief Contadores de una ejecución y comprobación de sus límites
+     *
+     * Cada evaluación de un nodo solo incrementa dos contadores; los
+     * límites se comprueban cada CHECK_INTERVAL nodos, así que un programa
+     * se detiene como mucho ese número de nodos después de superarlos.
+     */
+    class Session {
+    public:
+        /// Nodos evaluados entre dos comprobaciones de los límites
+        static constexpr uint32_t CHECK_INTERVAL = 4096;
+        /// Profundidades que se cuentan por separado (las mayores van juntas en la última)
+        static constexpr size_t DEPTHS = 8;
+
+        /**
+         * @brief Constructor de Session
+         * @param budget Límites de la ejecución
+         */
+        explicit Session(const Budget& budget = {});
+
+        /**
+         * @brief Empieza a medir: el límite de tiempo cuenta desde aquí
+         * @param heap Heap del intérprete, para contar sus entornos vivos
+         */
+        void start(const TokenTree::Heap& heap);
+
+        /**
+         * @brief Deja de medir el tiempo (también si el programa terminó con error)
+         */
+        void finish();
+
+        /**
+         * @brief Cuenta la evaluación de un nodo
+         * @param node Nodo evaluado
+         * @throws Error BudgetExceeded si se ha superado algún límite
+         */
+        void visit(const TokenTree::ASTNode* node) {
+            ++visits[static_cast<size_t>(node->getType())];
+            if (--countdown == 0) checkpoint();
+        }
+
+        /**
+         * @brief Cuenta un paso de la máquina virtual (una vuelta de bucle o una llamada)
+         * @throws Error BudgetExceeded si se ha superado algún límite
+         */
+        void step() {
+            if (--countdown == 0) checkpoint();
+        }
+
+        /**
+         * @brief Cuenta un entorno local recién creado (bloque o llamada)
+         * @param onHeap true si vive en el heap (lo cuenta el Heap mientras viva)
+         */
+        void openEnvironment(bool onHeap);
+
+        /**
+         * @brief Cuenta el fin de un entorno de la arena
+         */
+        void closeEnvironment() { --openFrames; }
+
+        /**
+         * @brief Cuenta una búsqueda de variable
+         * @param depth Entornos recorridos hasta encontrarla
+         */
+        void lookup(size_t depth) { ++lookups[depth < DEPTHS ? depth : DEPTHS - 1]; }
+
+        /// Cuenta una búsqueda que acabó en el entorno global
+        void globalLookup() { ++globals; }
+
+        /// Cuenta una llamada a una función definida por el usuario
+        void call() { ++calls; }
+
+        /// Cuenta una llamada a una función nativa
+        void nativeCall() { ++nativeCalls; }
+
+        /**
+         * @brief Cuenta una cadena creada durante la ejecución
+         * @param bytes Longitud de la cadena
+         */
+        void string(size_t bytes) { stringBytes += bytes; }
+
+        /**
+         * @brief Escribe el informe de la ejecución
+         * @param out Flujo de salida
+         */
+        void report(std::ostream& out) const;
+
+    private:
+        Budget budget;
+        Clock::time_point started;
+        const TokenTree::Heap* heap = nullptr;
+        Clock::duration elapsed{};
+        uint32_t interval = CHECK_INTERVAL;   ///< Nodos entre la comprobación anterior y la próxima
+        uint32_t countdown = CHECK_INTERVAL;  ///< Nodos hasta la próxima comprobación
+        uint64_t checked = 0;                 ///< Nodos contados en comprobaciones anteriores
+
+        std::array<uint64_t, TokenTree::ASTNode::TYPE_COUNT> visits{};
+        uint64_t environments = 0;      ///< Entornos locales creados
+        uint64_t heapEnvironments = 0;  ///< De ellos, los que viven en el heap
+        size_t openFrames = 0;          ///< Entornos de la arena abiertos ahora
+        size_t peakEnvironments = 0;    ///< Máximo de entornos vivos a la vez (arena y heap)
+        std::array<uint64_t, DEPTHS> lookups{};
+        uint64_t globals = 0;
+        uint64_t calls = 0;
+        uint64_t nativeCalls = 0;
+        uint64_t stringBytes = 0;
+
+        /**
+         * @brief Comprueba los límites
+         * @throws Error BudgetExceeded si se ha superado alguno
+         */
+        void checkpoint();
+    };
+
+    /**
+     * @brief Sesión en curso, o nullptr si no se mide la ejecución
+     *
+     * Como Profiler::active: sin --stats ni límites, el evaluador solo
+     * compara este puntero. Es propio de cada hilo.
+     */
+    extern constinit thread_local Session* active;
+
+    /**
+     * @class EnvironmentScope
+     * @brief Registra en la sesión activa un entorno local mientras está abierto
+     */
+    class EnvironmentScope {
+    public:
+        explicit EnvironmentScope(bool onHeap) : session(active), onHeap(onHeap) {
+            if (session) session->openEnvironment(onHeap);
+        }
+        ~EnvironmentScope() {
+            if (session && !onHeap) session->closeEnvironment();
+        }
+        EnvironmentScope(const EnvironmentScope&) = delete;
+        EnvironmentScope& operator=(const EnvironmentScope&) = delete;
+
+    private:
+        Session* session;
+        bool onHeap;
+    };
+}
+
+#endif // STATS_H
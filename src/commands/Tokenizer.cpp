@@ -10,266 +10,192 @@
  */
 
 #include "Tokenizer.h"
-#include "Parser.h"
 
 #include <iostream>
-#include <sstream>
 #include <vector>
 
 #include "../def/Tokens.h"
 #include "../def/Keywords.h"
+#include "Scan.h"
 
 namespace Tokenizer {
-    // Variables globales del tokenizer
-    auto tokens = std::pmr::vector<Token>();  ///< Vector de tokens identificados
-    int line = 1;                             ///< Número de línea actual
-    int exitCode = 0;                         ///< Código de salida del proceso
+    Lexer::Lexer(std::string_view source, std::ostream& errors) : source(source), errors(&errors) {}
 
-    /**
-     * @brief Verifica si un carácter es una letra o guión bajo
-     * @param c Carácter a verificar
-     * @return bool true si es letra o '_', false en caso contrario
-     */
-    bool isLetter(char c) {
-        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+    const Token& Lexer::peek() {
+        if (!buffered) {
+            lookahead = scanToken();
+            buffered = true;
+        }
+        return lookahead;
     }
 
-    /**
-     * @brief Verifica si un carácter es alfanumérico
-     * @param c Carácter a verificar
-     * @return bool true si es letra, dígito o '_', false en caso contrario
-     */
-    bool isAlphaNumeric(char c) {
-        return isLetter(c) || isdigit(c);
+    Token Lexer::next() {
+        if (buffered) {
+            buffered = false;
+            return lookahead;
+        }
+        return scanToken();
     }
 
-    /**
-     * @brief Verifica si un carácter es un dígito
-     * @param c Carácter a verificar
-     * @return bool true si es dígito, false en caso contrario
-     */
-    bool isDigit(char c) {
-        return c >= '0' && c <= '9';
+    int Lexer::finish() {
+        while (next().getType() != TokenType::EOF_OF_FILE) {}
+        return exitCode;
     }
 
-    /**
-     * @brief Procesa comentarios multi-línea delimitados por <| y |>
-     * @param file_contents Contenido del archivo
-     * @param i Índice actual en el archivo (se modifica por referencia)
-     */
-    void valorateWhitespaces(const std::string &file_contents, int &i) {
-        for (int j = i + 1; j < file_contents.size(); j++) {
-            if (file_contents[j] == '|' && file_contents[j + 1] == '>') {
-                i = j + 1;
-                break;
+    void Lexer::skipBlockComment(size_t start) {
+        const char* end = source.data() + source.size();
+        for (const char* bar = source.data() + start + 1; (bar = Scan::find(bar, end, '|')) != end; ++bar) {
+            if (bar + 1 < end && bar[1] == '>') {
+                current = static_cast<size_t>(bar - source.data()) + 2;
+                return;
             }
         }
+        // Sin cierre: solo se descarta el '<'
     }
 
-    /**
-     * @brief Procesa identificadores y palabras clave
-     * @param file_contents Contenido del archivo
-     * @param i Índice actual en el archivo (se modifica por referencia)
-     */
-    void valorateString(const std::string &file_contents, int &i) {
-        for (int j = i + 1; j <= file_contents.size(); j++) {
-            if (j == file_contents.size() || file_contents[j] == ' ' || file_contents[j] == '\n' || file_contents[j] == '\t' || !isAlphaNumeric(file_contents[j])) {
-                auto keyword = file_contents.substr(i, j - i);
-                tokens.emplace_back(Keywords::valorateKeyword(keyword), keyword);
-                i = j - 1;
-                break;
-            }
-        }
+    Token Lexer::identifier(size_t start) {
+        const char* data = source.data();
+        size_t end = static_cast<size_t>(Scan::skipIdentifier(data + start + 1, data + source.size()) - data);
+        current = end;
+        auto keyword = source.substr(start, end - start);
+        return {Keywords::valorateKeyword(keyword), keyword};
     }
 
-    /**
-     * @brief Procesa literales numéricos (enteros y decimales)
-     * @param file_contents Contenido del archivo
-     * @param i Índice actual en el archivo (se modifica por referencia)
-     */
-    void valorateNumber(const std::string &file_contents, int &i) {
-        for (int j = i + 1; j <= file_contents.size(); j++) {
-            if (j == file_contents.size() || file_contents[j] == ' ' || file_contents[j] == '\n' || file_contents[j] == '\t' || !isDigit(file_contents[j])) {
-                if (file_contents[j] == '.') continue;
-                std::string lexeme = file_contents.substr(i, j - i); // Toma el número tal cual del texto
-                auto number = std::stod(lexeme); // El literal sigue siendo double
-                tokens.emplace_back(TokenType::NUMBER, lexeme, number);
-                i = j - 1;
-                break;
-            }
-        }
+    Token Lexer::number(size_t start) {
+        // Toma el número tal cual del texto (los puntos forman parte de él);
+        // su valor se decodifica al parsear
+        size_t end = start + 1;
+        while (end < source.size() && (Scan::is(source[end], Scan::Digit) || source[end] == '.')) end++;
+        current = end;
+        return {TokenType::NUMBER, source.substr(start, end - start)};
     }
 
-    /**
-     * @brief Imprime todos los tokens identificados
-     */
-    void printTokens() {
-        for (auto &token : tokens) {
-            std::cout << token.print() << std::endl;
-        }
-    }
-
-    /**
-     * @brief Función principal de tokenización
-     * @param file_contents Contenido del archivo a tokenizar
-     * 
-     * Recorre carácter por carácter el contenido del archivo,
-     * identificando y clasificando tokens según las reglas
-     * léxicas del lenguaje Setker.
-     */
-    void valorateTokens(const std::string& file_contents) {
-        for (int i = 0; i < file_contents.size(); i++) {
-            switch (file_contents[i]) {
+    Token Lexer::scanToken() {
+        while (current < source.size()) {
+            size_t start = current;
+            char c = source[current++];
+            switch (c) {
                 case '+':
-                    tokens.emplace_back(TokenType::PLUS, "+");
-                    break;
+                    return {TokenType::PLUS, "+"};
                 case '-':
-                    tokens.emplace_back(TokenType::MINUS, "-");
-                    break;
+                    return {TokenType::MINUS, "-"};
                 case '*':
-                    tokens.emplace_back(TokenType::MULT, "*");
-                    break;
+                    return {TokenType::MULT, "*"};
                 case '/':
-                    if (file_contents[i + 1] == '/') {
-                        for (int j = i + 1; j <= file_contents.size(); j++) {
-                            if (file_contents[j] == '\n' || j == file_contents.size()) {
-                                if (file_contents[j] == '\n') line += 1;
-                                i = j;
-                                break;
-                            }
+                    if (charAt(current) == '/') {
+                        // Comentario de línea: se descarta hasta el salto de línea incluido
+                        const char* data = source.data();
+                        current = static_cast<size_t>(Scan::find(data + current, data + source.size(), '\n') - data);
+                        if (current < source.size()) {
+                            line += 1;
+                            current++;
                         }
-                    } else tokens.emplace_back(TokenType::SLASH, "/");
-                    break;
+                        break;
+                    }
+                    return {TokenType::SLASH, "/"};
                 case '%':
-                    tokens.emplace_back(TokenType::MOD, "%");
-                    break;
+                    return {TokenType::MOD, "%"};
                 case '=':
-                    if (file_contents[i + 1] == '=') {
-                        tokens.emplace_back(TokenType::EQUAL_EQUAL, "==");
-                        i++;
-                    } else {
-                        tokens.emplace_back(TokenType::EQUAL, "=");
+                    if (charAt(current) == '=') {
+                        current++;
+                        return {TokenType::EQUAL_EQUAL, "=="};
                     }
-                    break;
+                    return {TokenType::EQUAL, "="};
                 case '"': {
-                    int j = i + 1;
-                    std::string str;
-                    for (; j < file_contents.size(); ++j) {
-                        if (file_contents[j] == '"') {
-                            break;
-                        }
-                        if (file_contents[j] == '\n') {
-                            line += 1;
-                        }
-                        str += file_contents[j];
-                    }
-                    if (j >= file_contents.size()) {
-                        std::cerr << "[line " << line << "] Error: Unterminated string." << std::endl;
+                    const char* data = source.data();
+                    size_t j = static_cast<size_t>(Scan::find(data + current, data + source.size(), '"') - data);
+                    line += static_cast<int>(Scan::count(data + current, data + j, '\n'));
+                    if (j >= source.size()) {
+                        *errors << "[line " << line << "] Error: Unterminated string." << std::endl;
                         exitCode = 65;
-                        i = j;
+                        current = j;
                         break;
                     }
-                    tokens.emplace_back(TokenType::STRING, str, str);
-                    i = j;
-                    break;
+                    current = j + 1;
+                    // El lexema es el contenido entre comillas, sin copiarlo
+                    return {TokenType::STRING, source.substr(start + 1, j - start - 1)};
                 }
                 case ';':
-                    tokens.emplace_back(TokenType::SEMICOLON, ";");
-                    break;
+                    return {TokenType::SEMICOLON, ";"};
                 case ',':
-                    tokens.emplace_back(TokenType::COMMA, ",");
-                    break;
+                    return {TokenType::COMMA, ","};
                 case '.':
-                    tokens.emplace_back(TokenType::DOT, ".");
-                    break;
+                    return {TokenType::DOT, "."};
                 case ':':
-                    tokens.emplace_back(TokenType::COLON, ":");
-                    break;
+                    return {TokenType::COLON, ":"};
                 case '(':
-                    tokens.emplace_back(TokenType::L_PAREN, "(");
-                    break;
+                    return {TokenType::L_PAREN, "("};
                 case ')':
-                    tokens.emplace_back(TokenType::R_PAREN, ")");
-                    break;
+                    return {TokenType::R_PAREN, ")"};
                 case '{':
-                    tokens.emplace_back(TokenType::L_BRACE, "{");
-                    break;
+                    return {TokenType::L_BRACE, "{"};
                 case '}':
-                    tokens.emplace_back(TokenType::R_BRACE, "}");
-                    break;
+                    return {TokenType::R_BRACE, "}"};
                 case '[':
-                    tokens.emplace_back(TokenType::L_BRACKET, "[");
-                    break;
+                    return {TokenType::L_BRACKET, "["};
                 case ']':
-                    tokens.emplace_back(TokenType::R_BRACKET, "]");
-                    break;
+                    return {TokenType::R_BRACKET, "]"};
                 case '!':
-                    if (file_contents[i + 1] == '=') {
-                        tokens.emplace_back(TokenType::BANG_EQUAL, "!=");
-                        i++;
-                    } else {
-                        tokens.emplace_back(TokenType::BANG, "!");
+                    if (charAt(current) == '=') {
+                        current++;
+                        return {TokenType::BANG_EQUAL, "!="};
                     }
-                    break;
+                    return {TokenType::BANG, "!"};
                 case '>':
-                    if (file_contents[i + 1] == '=') {
-                        tokens.emplace_back(TokenType::GREATER_EQUAL, ">=");
-                        i++;
-                    } else if (file_contents[i + 1] == '|'){
-
-
-                    } else {
-                        tokens.emplace_back(TokenType::GREATER, ">");
+                    if (charAt(current) == '=') {
+                        current++;
+                        return {TokenType::GREATER_EQUAL, ">="};
                     }
-                    break;
+                    if (charAt(current) == '|') {
+                        break;
+                    }
+                    return {TokenType::GREATER, ">"};
                 case '<':
-                    if (file_contents[i + 1] == '=') {
-                        tokens.emplace_back(TokenType::LESS_EQUAL, "<=");
-                        i++;
-                    } else if (file_contents[i + 1] == '|') {
-                        valorateWhitespaces(file_contents, i);
-                    } else {
-                        tokens.emplace_back(TokenType::LESS, "<");
+                    if (charAt(current) == '=') {
+                        current++;
+                        return {TokenType::LESS_EQUAL, "<="};
                     }
-                    break;
+                    if (charAt(current) == '|') {
+                        skipBlockComment(start);
+                        break;
+                    }
+                    return {TokenType::LESS, "<"};
                 case '\n':
                     line += 1;
                     break;
                 case ' ':
                 case '\t':
+                    // Sangrías y alineaciones: se salta toda la racha de golpe
+                    if (Scan::is(charAt(current), Scan::Blank)) {
+                        const char* data = source.data();
+                        current = static_cast<size_t>(Scan::skipBlanks(data + current, data + source.size()) - data);
+                    }
                     break;
                 default:
-                    if (isLetter(file_contents[i])) {
-                        valorateString(file_contents, i);
-                    } else if (isDigit(file_contents[i])) {
-                        valorateNumber(file_contents, i);
-                    } else {
-                        std::cerr << "[line " << line << "] Error: Unexpected character: " << file_contents[i] << std::endl;
-                        exitCode = 65;
+                    if (Scan::is(c, Scan::Letter)) {
+                        return identifier(start);
                     }
-
+                    if (Scan::is(c, Scan::Digit)) {
+                        return number(start);
+                    }
+                    *errors << "[line " << line << "] Error: Unexpected character: " << c << std::endl;
+                    exitCode = 65;
             }
         }
-        tokens.emplace_back(TokenType::EOF_OF_FILE, "");
-    }
-
-    int tokenize(const std::string& file_contents) {
-        valorateTokens(file_contents);
-
-        printTokens();
-
-        return exitCode;
+        return {TokenType::EOF_OF_FILE, ""};
     }
 
-    void parse(const std::pmr::vector<Token>& tokens) {
-        Parser::parse(tokens);
-    }
-
-    Result getTokens(const std::string& file_contents) {
-        // Reiniciar estado
-        tokens.clear();
-        exitCode = 0;
-        valorateTokens(file_contents);
-        return { tokens, exitCode };
+    int tokenize(std::string_view file_contents) {
+        // Se leen todos los tokens antes de imprimir para que los errores
+        // léxicos aparezcan antes que la lista, como en el resto de comandos
+        Lexer lexer(file_contents);
+        std::vector<Token> tokens;
+        do {
+            tokens.push_back(lexer.next());
+        } while (tokens.back().getType() != TokenType::EOF_OF_FILE);
+        for (const auto& token : tokens) {
+            std::cout << token.print() << std::endl;
+        }
+        return lexer.finish();
     }
-}
\ No newline at end of file
+}
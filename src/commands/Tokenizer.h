@@ -12,9 +12,9 @@
 #ifndef TOKENIZER_H
 #define TOKENIZER_H
 
-#include <string>
-#include <vector>
-#include <memory_resource>
+#include <cstddef>
+#include <iostream>
+#include <string_view>
 
 #include "../def/Tokens.h"
 
@@ -27,16 +27,99 @@
  */
 namespace Tokenizer {
     /**
-     * @struct Result
-     * @brief Resultado del proceso de tokenización
-     * 
-     * Estructura que encapsula el resultado del análisis léxico,
-     * incluyendo la lista de tokens generados y el código de salida
-     * que indica si hubo errores durante el proceso.
+     * @class Lexer
+     * @brief Analizador léxico incremental sobre un buffer de código fuente
+     *
+     * Produce los tokens bajo demanda: el parser pide el siguiente con
+     * next() o lo consulta sin consumirlo con peek(), de modo que el
+     * análisis léxico y el sintáctico avanzan a la par sin materializar
+     * la lista completa de tokens. Todo el estado (posición, línea,
+     * errores) vive en el objeto, así que pueden usarse varios Lexer a la
+     * vez, por ejemplo uno por hilo.
+     *
+     * Los errores léxicos se informan al encontrarlos (en std::cerr, o en
+     * el flujo que se indique al construirlo) y el
+     * carácter problemático se descarta. Los lexemas de los tokens
+     * apuntan al buffer, que debe sobrevivir al Lexer y a sus tokens.
      */
-    struct Result {
-        std::pmr::vector<Token> tokens;  ///< Vector de tokens identificados
-        int exitCode;                    ///< Código de salida (0 = éxito, >0 = error)
+    class Lexer {
+    public:
+        /**
+         * @brief Constructor de Lexer
+         * @param source Código fuente completo (no se copia)
+         * @param errors Flujo en el que se informan los errores léxicos
+         */
+        explicit Lexer(std::string_view source, std::ostream& errors = std::cerr);
+
+        /**
+         * @brief Consulta el siguiente token sin consumirlo
+         * @return const Token& Token actual (válido hasta la próxima llamada a next)
+         */
+        const Token& peek();
+
+        /**
+         * @brief Consume y devuelve el siguiente token
+         * @return Token Token leído; al final del código siempre EOF_OF_FILE
+         */
+        Token next();
+
+        /**
+         * @brief Lee el resto del código para informar de todos los errores léxicos
+         * @return int Código de salida del análisis léxico (0 = éxito, 65 = error léxico)
+         *
+         * Los errores léxicos tienen prioridad sobre los sintácticos y los
+         * de ejecución: quien use el Lexer debe llamarlo antes de informar
+         * de un error posterior o de ejecutar el programa.
+         */
+        int finish();
+
+        /**
+         * @brief Obtiene el código fuente completo
+         * @return std::string_view Buffer que se está analizando
+         */
+        std::string_view getSource() const { return source; }
+
+    private:
+        std::string_view source;                        ///< Código fuente
+        std::ostream* errors;                           ///< Destino de los errores léxicos
+        size_t current = 0;                             ///< Siguiente carácter por leer
+        int line = 1;                                   ///< Número de línea actual
+        int exitCode = 0;                               ///< Código de salida del análisis
+        Token lookahead{TokenType::EOF_OF_FILE, ""};    ///< Token leído por peek
+        bool buffered = false;                          ///< true si lookahead está pendiente
+
+        /**
+         * @brief Reconoce el siguiente token del código
+         * @return Token Token reconocido (EOF_OF_FILE al final)
+         */
+        Token scanToken();
+
+        /**
+         * @brief Carácter en una posición, o '\0' fuera del buffer
+         * @param i Posición en el código
+         * @return char Carácter leído
+         */
+        char charAt(size_t i) const { return i < source.size() ? source[i] : '\0'; }
+
+        /**
+         * @brief Procesa comentarios multi-línea delimitados por <| y |>
+         * @param start Posición del '<' que abre el comentario
+         */
+        void skipBlockComment(size_t start);
+
+        /**
+         * @brief Procesa identificadores y palabras clave
+         * @param start Posición del primer carácter
+         * @return Token Identificador o palabra clave
+         */
+        Token identifier(size_t start);
+
+        /**
+         * @brief Procesa literales numéricos (enteros y decimales)
+         * @param start Posición del primer dígito
+         * @return Token Token NUMBER
+         */
+        Token number(size_t start);
     };
 
     /**
@@ -50,19 +133,7 @@ namespace Tokenizer {
      * 
      * Esta función es utilizada por el comando 'tokenize' del intérprete.
      */
-    int tokenize(const std::string& file_contents);
-    
-    /**
-     * @brief Tokeniza contenido y devuelve tokens sin imprimir
-     * @param file_contents Contenido del archivo a tokenizar
-     * @return Result Estructura con tokens y código de salida
-     * 
-     * Realiza el análisis léxico del contenido proporcionado y devuelve
-     * los tokens en una estructura Result junto con el código de salida.
-     * No imprime los tokens, permitiendo su uso en otras fases del
-     * procesamiento como parsing y evaluación.
-     */
-    Result getTokens(const std::string& file_contents);
+    int tokenize(std::string_view file_contents);
 }
 
-#endif // TOKENIZER_H
\ No newline at end of file
+#endif // TOKENIZER_H
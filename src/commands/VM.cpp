@@ -0,0 +1,524 @@
+/**
+ * @file VM.cpp
+ * @brief Implementación de la máquina virtual de bytecode
+ * @author Javier
+ * @date 2025
+ *
+ * Este archivo contiene el bucle de despacho de la máquina virtual.
+ * Con GCC y Clang cada instrucción salta directamente a la siguiente
+ * mediante una tabla de etiquetas (computed goto); en el resto de
+ * compiladores se usa un switch equivalente.
+ *
+ * Los operadores reutilizan las reglas del evaluador (Evaluator::isTruthy,
+ * Evaluator::addValues, ...) para que ambos backends produzcan la misma
+ * salida y los mismos errores.
+ */
+
+#include "VM.h"
+#include "Compiler.h"
+#include "Evaluator.h"
+#include "Stats.h"
+#include "../def/Array.h"
+#include "../def/Context.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__GNUC__) || defined(__clang__)
+#define SETKER_COMPUTED_GOTO 1
+#endif
+
+using namespace TokenTree;
+
+namespace VM {
+    namespace {
+        /// Profundidad máxima de llamadas antes de abortar con "Stack overflow."
+        constexpr size_t MAX_FRAMES = 1 << 16;
+        /// Marcos iguales seguidos que trace() escribe uno a uno antes de resumirlos
+        constexpr size_t MAX_REPEATED_FRAMES = 16;
+    }
+
+    Machine::Machine() {
+        reset();
+    }
+
+    void Machine::reset() {
+        std::fill(globals.begin(), globals.end(), Value(Undefined{}));
+        for (auto& native : makeNatives()) {
+            uint16_t index = globalNames.intern(native->name);
+            if (globals.size() <= index) globals.resize(index + 1, Undefined{});
+            globals[index] = native;
+        }
+    }
+
+    void Machine::interpret(const ASTNode* program) {
+        run(compile(program));
+    }
+
+    std::shared_ptr<FunctionProto> Machine::compile(const ASTNode* program) {
+        return Compiler::compile(program, globalNames);
+    }
+
+    void Machine::run(const std::shared_ptr<FunctionProto>& script, Stats::Session* limits) {
+        globals.resize(globalNames.names.size(), Undefined{});
+        this->limits = limits;
+
+        auto closure = makeRef<Closure>(script);
+        stack.clear();
+        frames.clear();
+        tailCalls.clear();
+        openUpvalues.clear();
+        stack.push_back(closure);
+        frames.push_back({closure.get(), script->chunk.code.data(), 0, 0, 0});
+        execute();
+    }
+
+    UpvaluePtr Machine::captureUpvalue(size_t slot) {
+        // Reutilizar el upvalue si otra closure ya capturó la misma ranura
+        auto it = openUpvalues.end();
+        while (it != openUpvalues.begin() && (*std::prev(it))->slot >= slot) {
+            --it;
+            if ((*it)->slot == slot) return *it;
+        }
+        return *openUpvalues.insert(it, std::make_shared<Upvalue>(slot));
+    }
+
+    void Machine::closeUpvalues(size_t from) {
+        while (!openUpvalues.empty() && openUpvalues.back()->slot >= from) {
+            Upvalue& upvalue = *openUpvalues.back();
+            upvalue.closed = std::move(stack[upvalue.slot]);
+            upvalue.open = false;
+            openUpvalues.pop_back();
+        }
+    }
+
+    Value& Machine::fallback(const CallFrame& frame, const uint8_t* instruction) {
+        const Chunk& chunk = frame.closure->proto->chunk;
+        const auto* chain = chunk.fallbackAt(instruction - chunk.code.data());
+        // La última ligadura de la cadena siempre es la global con el mismo nombre
+        for (const auto& binding : *chain) {
+            Value* value = nullptr;
+            switch (binding.kind) {
+                case Binding::Kind::Local:
+                    value = &stack[frame.base + binding.index];
+                    break;
+                case Binding::Kind::Upvalue: {
+                    Upvalue& upvalue = *frame.closure->upvalues[binding.index];
+                    value = upvalue.open ? &stack[upvalue.slot] : &upvalue.closed;
+                    break;
+                }
+                case Binding::Kind::Global:
+                    value = &globals[binding.index];
+                    if (value->isUndefined()) {
+                        throw Error(ErrorCodes::RuntimeError, "Undefined variable '" + globalNames.names[binding.index] + "'.");
+                    }
+                    break;
+            }
+            if (!value->isUndefined()) return *value;
+        }
+        throw Error(ErrorCodes::RuntimeError, "Undefined variable.");
+    }
+
+    /**
+     * @brief Anota una llamada de cola eliminada en el marco que la hizo
+     * @param frame Marco en curso (el último de frames)
+     * @param path Ruta de sentencias de la llamada
+     */
+    void Machine::addTailCall(CallFrame& frame, const std::vector<uint32_t>& path) {
+        if (tailCalls.size() > frame.tail && *tailCalls.back().path == path) {
+            ++tailCalls.back().count;
+            return;
+        }
+        if (tailCalls.size() - frame.tail == 2 * TailCalls::KEPT_RUNS) {
+            // Descartar la más antigua de las últimas entradas
+            auto oldest = tailCalls.begin() + static_cast<std::ptrdiff_t>(frame.tail + TailCalls::KEPT_RUNS);
+            frame.elided += oldest->count;
+            tailCalls.erase(oldest);
+        }
+        tailCalls.push_back({&path, 1});
+    }
+
+    std::string Machine::trace() const {
+        // Mismo formato que el evaluador: una línea por bloque, del interior al
+        // exterior, con las llamadas de cola de cada marco tras el propio marco
+        std::vector<TailRun> runs;
+        auto add = [&runs](const std::vector<uint32_t>* path, size_t count) {
+            // Sin ruta: marcos descartados, que nunca se juntan con otros
+            if (path && !runs.empty() && runs.back().path && *runs.back().path == *path) runs.back().count += count;
+            else runs.push_back({path, count});
+        };
+        for (size_t i = frames.size(); i-- > 0;) {
+            const CallFrame& frame = frames[i];
+            const Chunk& chunk = frame.closure->proto->chunk;
+            add(&chunk.pathAt(frame.ip - chunk.code.data() - 1), 1);
+            size_t end = i + 1 < frames.size() ? frames[i + 1].tail : tailCalls.size();
+            for (size_t run = end; run-- > frame.tail;) {
+                if (frame.elided && run + 1 == frame.tail + TailCalls::KEPT_RUNS) add(nullptr, frame.elided);
+                add(tailCalls[run].path, tailCalls[run].count);
+            }
+        }
+
+        // Una recursión profunda (más de MAX_REPEATED_FRAMES marcos iguales
+        // seguidos) escribe su marco una sola vez, con las repeticiones
+        std::string out;
+        for (const TailRun& run : runs) {
+            if (!run.path) {
+                out += "\n[... " + std::to_string(run.count) + " more frames]";
+                continue;
+            }
+            size_t written = run.count > MAX_REPEATED_FRAMES ? 1 : run.count;
+            for (size_t i = 0; i < written; ++i) {
+                for (auto index = run.path->rbegin(); index != run.path->rend(); ++index) {
+                    out += "\n[line " + std::to_string(*index + 1) + "]";
+                }
+            }
+            if (written < run.count) out += "\n[previous frame repeated " + std::to_string(run.count - 1) + " more times]";
+        }
+        return out;
+    }
+
+    void Machine::execute() {
+        CallFrame* frame = &frames.back();
+        const uint8_t* ip = frame->ip;
+        const Chunk* chunk = &frame->closure->proto->chunk;
+        size_t base = frame->base;
+        TokenTree::Heap& heap = TokenTree::Heap::current();
+
+#define READ_BYTE() (*ip++)
+#define READ_U16() (ip += 2, static_cast<uint16_t>((ip[-2] << 8) | ip[-1]))
+#define LOAD_FRAME()                               \
+    do {                                           \
+        frame = &frames.back();                    \
+        ip = frame->ip;                            \
+        chunk = &frame->closure->proto->chunk;     \
+        base = frame->base;                        \
+    } while (false)
+#define NUMERIC_OPERANDS(a, b)                                                           \
+    Value& right = stack.back();                                                         \
+    Value& left = stack[stack.size() - 2];                                               \
+    if (!left.isNumber() || !right.isNumber())                                           \
+        throw Error(ErrorCodes::OperandsMustBeNumbers, "Operands must be numbers.");     \
+    double a = left.asNumber();                                                          \
+    double b = right.asNumber()
+#define BINARY_RESULT(expr)  \
+    do {                     \
+        Value result = expr; \
+        stack.pop_back();    \
+        stack.back() = std::move(result); \
+    } while (false)
+
+#ifdef SETKER_COMPUTED_GOTO
+#define VM_CASE(name) op_##name:
+#define VM_DISPATCH() goto *dispatchTable[READ_BYTE()]
+        static void* const dispatchTable[] = {
+#define SETKER_OPCODE_LABEL(name) &&op_##name,
+            SETKER_OPCODES(SETKER_OPCODE_LABEL)
+#undef SETKER_OPCODE_LABEL
+        };
+#else
+#define VM_CASE(name) case OpCode::name:
+#define VM_DISPATCH() continue
+#endif
+
+        try {
+#ifdef SETKER_COMPUTED_GOTO
+            VM_DISPATCH();
+#else
+            for (;;) switch (static_cast<OpCode>(READ_BYTE())) {
+#endif
+            VM_CASE(Constant) {
+                stack.push_back(chunk->constants[READ_U16()]);
+                VM_DISPATCH();
+            }
+            VM_CASE(Nil) {
+                stack.emplace_back();
+                VM_DISPATCH();
+            }
+            VM_CASE(True) {
+                stack.emplace_back(true);
+                VM_DISPATCH();
+            }
+            VM_CASE(False) {
+                stack.emplace_back(false);
+                VM_DISPATCH();
+            }
+            VM_CASE(Pop) {
+                stack.pop_back();
+                VM_DISPATCH();
+            }
+            VM_CASE(Reserve) {
+                stack.resize(stack.size() + READ_U16(), Undefined{});
+                VM_DISPATCH();
+            }
+            VM_CASE(PopScope) {
+                size_t count = READ_U16();
+                closeUpvalues(stack.size() - count);
+                stack.resize(stack.size() - count);
+                VM_DISPATCH();
+            }
+            VM_CASE(GetLocal) {
+                Value value = stack[base + READ_U16()];
+                if (value.isUndefined()) value = fallback(*frame, ip - 3);
+                stack.push_back(std::move(value));
+                VM_DISPATCH();
+            }
+            VM_CASE(SetLocal) {
+                Value* slot = &stack[base + READ_U16()];
+                if (slot->isUndefined()) slot = &fallback(*frame, ip - 3);
+                *slot = stack.back();
+                VM_DISPATCH();
+            }
+            VM_CASE(DefineLocal) {
+                stack[base + READ_U16()] = std::move(stack.back());
+                stack.pop_back();
+                VM_DISPATCH();
+            }
+            VM_CASE(GetUpvalue) {
+                Upvalue& upvalue = *frame->closure->upvalues[READ_U16()];
+                Value value = upvalue.open ? stack[upvalue.slot] : upvalue.closed;
+                if (value.isUndefined()) value = fallback(*frame, ip - 3);
+                stack.push_back(std::move(value));
+                VM_DISPATCH();
+            }
+            VM_CASE(SetUpvalue) {
+                Upvalue& upvalue = *frame->closure->upvalues[READ_U16()];
+                Value* slot = upvalue.open ? &stack[upvalue.slot] : &upvalue.closed;
+                if (slot->isUndefined()) slot = &fallback(*frame, ip - 3);
+                *slot = stack.back();
+                VM_DISPATCH();
+            }
+            VM_CASE(GetGlobal) {
+                uint16_t index = READ_U16();
+                if (globals[index].isUndefined()) {
+                    throw Error(ErrorCodes::RuntimeError, "Undefined variable '" + globalNames.names[index] + "'.");
+                }
+                stack.push_back(globals[index]);
+                VM_DISPATCH();
+            }
+            VM_CASE(SetGlobal) {
+                uint16_t index = READ_U16();
+                if (globals[index].isUndefined()) {
+                    throw Error(ErrorCodes::RuntimeError, "Undefined variable '" + globalNames.names[index] + "'.");
+                }
+                globals[index] = stack.back();
+                VM_DISPATCH();
+            }
+            VM_CASE(DefineGlobal) {
+                globals[READ_U16()] = std::move(stack.back());
+                stack.pop_back();
+                VM_DISPATCH();
+            }
+            VM_CASE(Equal) {
+                BINARY_RESULT(Evaluator::valuesEqual(stack[stack.size() - 2], stack.back()));
+                VM_DISPATCH();
+            }
+            VM_CASE(NotEqual) {
+                BINARY_RESULT(!Evaluator::valuesEqual(stack[stack.size() - 2], stack.back()));
+                VM_DISPATCH();
+            }
+            VM_CASE(Greater) {
+                NUMERIC_OPERANDS(a, b);
+                BINARY_RESULT(a > b);
+                VM_DISPATCH();
+            }
+            VM_CASE(GreaterEqual) {
+                NUMERIC_OPERANDS(a, b);
+                BINARY_RESULT(a >= b);
+                VM_DISPATCH();
+            }
+            VM_CASE(Less) {
+                NUMERIC_OPERANDS(a, b);
+                BINARY_RESULT(a < b);
+                VM_DISPATCH();
+            }
+            VM_CASE(LessEqual) {
+                NUMERIC_OPERANDS(a, b);
+                BINARY_RESULT(a <= b);
+                VM_DISPATCH();
+            }
+            VM_CASE(Add) {
+                Value& right = stack.back();
+                Value& left = stack[stack.size() - 2];
+                if (left.isNumber() && right.isNumber()) BINARY_RESULT(left.asNumber() + right.asNumber());
+                else BINARY_RESULT(Evaluator::addValues(left, right));
+                VM_DISPATCH();
+            }
+            VM_CASE(Subtract) {
+                NUMERIC_OPERANDS(a, b);
+                BINARY_RESULT(a - b);
+                VM_DISPATCH();
+            }
+            VM_CASE(Multiply) {
+                NUMERIC_OPERANDS(a, b);
+                BINARY_RESULT(a * b);
+                VM_DISPATCH();
+            }
+            VM_CASE(Divide) {
+                NUMERIC_OPERANDS(a, b);
+                BINARY_RESULT(a / b);
+                VM_DISPATCH();
+            }
+            VM_CASE(Modulo) {
+                NUMERIC_OPERANDS(a, b);
+                BINARY_RESULT(std::fmod(a, b));
+                VM_DISPATCH();
+            }
+            VM_CASE(Not) {
+                stack.back() = !Evaluator::isTruthy(stack.back());
+                VM_DISPATCH();
+            }
+            VM_CASE(Negate) {
+                Value& operand = stack.back();
+                if (!operand.isNumber()) throw Error(ErrorCodes::OperandMustBeNumber, "Operand must be a number.");
+                operand = -operand.asNumber();
+                VM_DISPATCH();
+            }
+            VM_CASE(Print) {
+                Output& out = Context::current().output;
+                Evaluator::printValue(out, stack.back());
+                out.endLine();
+                stack.pop_back();
+                VM_DISPATCH();
+            }
+            VM_CASE(Jump) {
+                uint16_t offset = READ_U16();
+                ip += offset;
+                VM_DISPATCH();
+            }
+            VM_CASE(JumpIfFalse) {
+                uint16_t offset = READ_U16();
+                if (!Evaluator::isTruthy(stack.back())) ip += offset;
+                VM_DISPATCH();
+            }
+            VM_CASE(JumpIfTrue) {
+                uint16_t offset = READ_U16();
+                if (Evaluator::isTruthy(stack.back())) ip += offset;
+                VM_DISPATCH();
+            }
+            VM_CASE(Loop) {
+                uint16_t offset = READ_U16();
+                if (limits) limits->step();
+                ip -= offset;
+                VM_DISPATCH();
+            }
+            VM_CASE(CheckCall) {
+                uint8_t argCount = READ_BYTE();
+                uint16_t name = READ_U16();
+                const Value& callee = stack.back();
+                size_t arity;
+                if (callee.isObject(Object::Kind::Closure)) {
+                    arity = static_cast<size_t>(callee.as<Closure>()->proto->arity);
+                } else if (callee.isObject(Object::Kind::Native)) {
+                    arity = callee.as<NativeFunction>()->arity;
+                } else {
+                    throw Error(ErrorCodes::CallOnNonFunction, "Attempt to call non-function '" +
+                                chunk->constants[name].asString() + "'.");
+                }
+                if (argCount != arity) {
+                    throw Error(ErrorCodes::ArgumentCountMismatch, "Expected " + std::to_string(arity) +
+                                " args but got " + std::to_string(argCount) + ".");
+                }
+                VM_DISPATCH();
+            }
+            VM_CASE(Call) {
+                uint8_t argCount = READ_BYTE();
+                size_t calleeSlot = stack.size() - argCount - 1;
+                if (stack[calleeSlot].isObject(Object::Kind::Native)) {
+                    // Los argumentos ya están en la pila: se pasan sin crear marco
+                    Value result = stack[calleeSlot].as<NativeFunction>()->fn(&stack[calleeSlot + 1]);
+                    stack.resize(calleeSlot);
+                    stack.push_back(std::move(result));
+                    VM_DISPATCH();
+                }
+                const Closure* callee = stack[calleeSlot].as<Closure>();
+                if (limits) limits->step();
+                if (static_cast<OpCode>(*ip) == OpCode::Return && frames.size() > 1) {
+                    // Llamada de cola: anotar la sentencia para las trazas y
+                    // sustituir el marco en curso por el de la función llamada
+                    addTailCall(*frame, chunk->pathAt(ip - chunk->code.data() - 1));
+                    closeUpvalues(base);
+                    for (size_t i = 0; i <= argCount; ++i) stack[base + i] = std::move(stack[calleeSlot + i]);
+                    stack.resize(base + argCount + 1);
+                    frame->closure = callee;
+                    frame->ip = callee->proto->chunk.code.data();
+                    LOAD_FRAME();
+                    VM_DISPATCH();
+                }
+                if (frames.size() >= MAX_FRAMES) {
+                    throw Error(ErrorCodes::RuntimeError, "Stack overflow.");
+                }
+                frame->ip = ip;
+                frames.push_back({callee, callee->proto->chunk.code.data(), calleeSlot, tailCalls.size(), 0});
+                LOAD_FRAME();
+                VM_DISPATCH();
+            }
+            VM_CASE(Closure) {
+                {
+                    // El salto de VM_DISPATCH no ejecuta destructores: el Ref
+                    // tiene que soltarse antes, al cerrar este bloque
+                    const auto& proto = chunk->functions[READ_U16()];
+                    auto closure = makeRef<Closure>(proto);
+                    closure->upvalues.reserve(proto->upvalues.size());
+                    for (const auto& desc : proto->upvalues) {
+                        closure->upvalues.push_back(desc.isLocal ? captureUpvalue(base + desc.index)
+                                                                 : frame->closure->upvalues[desc.index]);
+                    }
+                    stack.emplace_back(std::move(closure));
+                }
+                // Punto seguro: la closure ya está en la pila y completa
+                heap.poll();
+                VM_DISPATCH();
+            }
+            VM_CASE(Array) {
+                {
+                    size_t count = READ_U16();
+                    size_t first = stack.size() - count;
+                    auto array = makeRef<ArrayObject>();
+                    array->reserve(count);
+                    for (size_t i = first; i < stack.size(); ++i) array->push(stack[i]);
+                    stack.resize(first);
+                    stack.emplace_back(std::move(array));
+                }
+                // Punto seguro: el array ya está en la pila y completo
+                heap.poll();
+                VM_DISPATCH();
+            }
+            VM_CASE(GetIndex) {
+                BINARY_RESULT(Evaluator::readElement(stack[stack.size() - 2], stack.back()));
+                VM_DISPATCH();
+            }
+            VM_CASE(SetIndex) {
+                size_t top = stack.size();
+                Evaluator::writeElement(stack[top - 3], stack[top - 2], stack[top - 1]);
+                stack[top - 3] = std::move(stack[top - 1]);
+                stack.resize(top - 2);
+                VM_DISPATCH();
+            }
+            VM_CASE(Return) {
+                Value result = std::move(stack.back());
+                closeUpvalues(base);
+                stack.resize(base);
+                tailCalls.resize(frame->tail);
+                frames.pop_back();
+                if (frames.empty()) return;
+                stack.push_back(std::move(result));
+                LOAD_FRAME();
+                VM_DISPATCH();
+            }
+#ifndef SETKER_COMPUTED_GOTO
+            }
+#endif
+        } catch (const Error& e) {
+            frames.back().ip = ip;
+            throw Error(e.type, e.message + trace());
+        }
+
+#undef READ_BYTE
+#undef READ_U16
+#undef LOAD_FRAME
+#undef NUMERIC_OPERANDS
+#undef BINARY_RESULT
+#undef VM_CASE
+#undef VM_DISPATCH
+    }
+}
@@ -0,0 +1,206 @@
+/**
+ * @file VM.h
+ * @brief Máquina virtual de pila para el bytecode de Setker
+ * @author Javier
+ * @date 2025
+ *
+ * Este archivo define la máquina virtual que ejecuta los programas
+ * compilados por Compiler::compile. Es el backend alternativo al
+ * evaluador de árbol y se activa con 'run --vm'.
+ */
+
+#ifndef VM_H
+#define VM_H
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../def/ASTNode.h"
+#include "../def/Chunk.h"
+#include "../def/Environment.h"
+#include "../def/ErrorCode.h"
+#include "../def/Heap.h"
+#include "../def/Native.h"
+
+namespace Stats {
+    class Session;
+}
+
+/**
+ * @namespace VM
+ * @brief Espacio de nombres para la máquina virtual de bytecode
+ */
+namespace VM {
+    using Error = TokenTree::Error;
+    using Value = TokenTree::Environment::Value;
+
+    /**
+     * @struct Upvalue
+     * @brief Variable capturada por una closure
+     *
+     * Mientras la variable sigue viva en la pila, el upvalue apunta a su
+     * ranura (por índice, ya que la pila puede crecer). Al salir la variable
+     * de ámbito, el valor se copia al propio upvalue ("cerrado"). Una
+     * closure guardada en su propio upvalue cerrado forma un ciclo, así que
+     * es un contenedor del Heap (debe crearse con std::make_shared).
+     */
+    struct Upvalue : std::enable_shared_from_this<Upvalue>, TokenTree::Collectable {
+        size_t slot;          ///< Posición en la pila mientras está abierto
+        Value closed;         ///< Valor propio una vez cerrado
+        bool open = true;     ///< true mientras la variable vive en la pila
+
+        explicit Upvalue(size_t slot) : slot(slot) { track(Type::Upvalue); }
+
+    protected:
+        size_t references() const override { return static_cast<size_t>(weak_from_this().use_count()); }
+        void traverse(Tracer& tracer) const override { tracer.visit(closed); }
+        void pin(Pins& pins) override { pins.shared.push_back(shared_from_this()); }
+        void clear() override { closed = Value(); }
+    };
+
+    /**
+     * @typedef UpvaluePtr
+     * @brief Puntero compartido a upvalue (varias closures pueden compartirlo)
+     */
+    using UpvaluePtr = std::shared_ptr<Upvalue>;
+
+    /**
+     * @struct Closure
+     * @brief Función compilada junto con las variables que captura
+     */
+    struct Closure : TokenTree::Object, TokenTree::Collectable {
+        std::shared_ptr<const TokenTree::FunctionProto> proto; ///< Código de la función
+        std::vector<UpvaluePtr> upvalues;                      ///< Variables capturadas
+
+        /**
+         * @brief Constructor de Closure
+         * @param proto Función compilada
+         */
+        explicit Closure(std::shared_ptr<const TokenTree::FunctionProto> proto)
+            : Object(Object::Kind::Closure), proto(std::move(proto)) {
+            track(Type::Closure);
+        }
+
+        TokenTree::Collectable* collectable() override { return this; }
+
+    protected:
+        size_t references() const override { return refCount; }
+        void traverse(Tracer& tracer) const override {
+            for (const auto& upvalue : upvalues) tracer.visit(upvalue.get());
+        }
+        void pin(Pins& pins) override { pins.objects.emplace_back(static_cast<Object*>(this)); }
+        void clear() override { upvalues.clear(); }
+    };
+
+    /**
+     * @typedef ClosurePtr
+     * @brief Referencia a una closure de la VM
+     */
+    using ClosurePtr = TokenTree::Ref<Closure>;
+
+    /**
+     * @class Machine
+     * @brief Máquina virtual de pila con despacho por computed goto
+     *
+     * Las variables locales viven en la pila de valores, las globales en
+     * una tabla indexada y cada llamada es un marco (CallFrame) sin
+     * recursión en C++. Una llamada seguida de Return dentro de una función
+     * reutiliza su marco, así que la recursión de cola no tiene límite. En
+     * compiladores sin etiquetas como valores (MSVC) el bucle de despacho
+     * recurre a un switch.
+     */
+    class Machine {
+    public:
+        /**
+         * @brief Constructor de Machine: define las funciones nativas como globales
+         */
+        Machine();
+
+        /**
+         * @brief Compila y ejecuta un programa
+         * @param program Nodo raíz del AST
+         * @throws Error Para errores de compilación o de tiempo de ejecución
+         *
+         * Las globales definidas se conservan entre llamadas sucesivas.
+         */
+        void interpret(const TokenTree::ASTNode* program);
+
+        /**
+         * @brief Compila un programa sin ejecutarlo
+         * @param program Nodo raíz del AST
+         * @return std::shared_ptr<TokenTree::FunctionProto> Función de nivel superior
+         * @throws Error Si el programa excede los límites del bytecode
+         *
+         * El resultado usa los índices de globales de esta máquina, así que
+         * solo puede ejecutarse en ella (run), tantas veces como se quiera.
+         */
+        std::shared_ptr<TokenTree::FunctionProto> compile(const TokenTree::ASTNode* program);
+
+        /**
+         * @brief Ejecuta un programa compilado con compile()
+         * @param script Función de nivel superior
+         * @param limits Sesión cuyos límites se comprueban (nullptr = sin límites)
+         * @throws Error Para errores de tiempo de ejecución, o BudgetExceeded
+         *
+         * Con limits, cada vuelta de un bucle y cada llamada cuentan como un
+         * paso de Stats::Session::step: el resto del código no puede
+         * ejecutarse indefinidamente.
+         */
+        void run(const std::shared_ptr<TokenTree::FunctionProto>& script, Stats::Session* limits = nullptr);
+
+        /**
+         * @brief Borra todas las globales salvo las funciones nativas
+         *
+         * Los nombres conservan su índice, de modo que lo compilado antes
+         * sigue siendo válido.
+         */
+        void reset();
+
+    private:
+        /**
+         * @struct CallFrame
+         * @brief Invocación en curso de una función
+         */
+        struct CallFrame {
+            const Closure* closure; ///< Función en ejecución (viva en la ranura base)
+            const uint8_t* ip;      ///< Siguiente instrucción al salir del marco
+            size_t base;            ///< Ranura 0 del marco dentro de la pila
+            size_t tail;            ///< Inicio de sus llamadas de cola en tailCalls
+            size_t elided = 0;      ///< Llamadas de cola descartadas de tailCalls (ver addTailCall)
+        };
+
+        /**
+         * @struct TailRun
+         * @brief Llamadas de cola seguidas desde la misma sentencia
+         *
+         * Una llamada seguida de Return reutiliza el marco en curso. Para que
+         * los errores muestren las mismas líneas que sin esa optimización (y
+         * que el evaluador), se guarda la ruta de cada llamada eliminada; las
+         * repetidas, como las de una función que se llama a sí misma, ocupan
+         * una sola entrada. Cada marco conserva como mucho
+         * TailCalls::KEPT_RUNS entradas al principio y otras tantas al final.
+         */
+        struct TailRun {
+            const std::vector<uint32_t>* path; ///< Ruta de sentencias de la llamada (Chunk::pathAt)
+            size_t count;                      ///< Llamadas seguidas con esa ruta
+        };
+
+        TokenTree::GlobalTable globalNames;     ///< Nombres de las globales
+        std::vector<Value> globals;             ///< Valores de las globales
+        std::vector<Value> stack;               ///< Pila de valores
+        std::vector<CallFrame> frames;          ///< Pila de llamadas
+        std::vector<TailRun> tailCalls;         ///< Llamadas de cola eliminadas, por marco (CallFrame::tail)
+        std::vector<UpvaluePtr> openUpvalues;   ///< Upvalues abiertos, ordenados por ranura
+        Stats::Session* limits = nullptr;       ///< Límites de la ejecución en curso
+
+        void execute();
+        UpvaluePtr captureUpvalue(size_t slot);
+        void closeUpvalues(size_t from);
+        Value& fallback(const CallFrame& frame, const uint8_t* instruction);
+        void addTailCall(CallFrame& frame, const std::vector<uint32_t>& path);
+        std::string trace() const;
+    };
+}
+
+#endif // VM_H
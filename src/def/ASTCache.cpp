@@ -0,0 +1,394 @@
+/**
+ * @file ASTCache.cpp
+ * @brief Implementación de la caché en disco del AST
+ * @author Javier
+ * @date 2025
+ */
+
+#include "ASTCache.h"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <random>
+
+#include "SourceFile.h"
+
+namespace TokenTree::ASTCache {
+    static constexpr char MAGIC[4] = {'S', 'T', 'K', 'A'};
+    static constexpr uint32_t VERSION = 2; ///< Cambiar al modificar el formato o ASTNode
+
+    /**
+     * @struct Header
+     * @brief Cabecera fija al principio del archivo de caché
+     */
+    struct Header {
+        char magic[4];        ///< MAGIC
+        uint32_t version;     ///< VERSION (en otro orden de bytes no coincide)
+        uint64_t sourceHash;  ///< hash() del fuente
+        uint64_t sourceSize;  ///< Longitud del fuente
+        uint64_t nodeCount;   ///< Nodos serializados
+        uint64_t payloadHash; ///< hash() de los nodos, para detectar archivos dañados
+    };
+
+    /**
+     * @enum LiteralTag
+     * @brief Codificación del literal de un nodo
+     */
+    enum class LiteralTag : uint8_t {
+        Nil,
+        False,
+        True,
+        Number,      ///< Seguido de los 8 bytes del double
+        String,      ///< Seguido del texto
+        SameString   ///< Cadena con el mismo texto que el nodo (el caso habitual)
+    };
+
+    static constexpr auto LAST_TYPE = ASTNode::Type::SetIndex;
+    static constexpr auto LAST_OPERATOR = Operator::Negate;
+
+    // --- Hash ------------------------------------------------------------
+
+    static uint64_t load64(const char* p) {
+        uint64_t word;
+        std::memcpy(&word, p, sizeof(word));
+        return word;
+    }
+
+    static uint64_t mix(uint64_t h, uint64_t word) {
+        h = (h ^ word) * 0xff51afd7ed558ccdULL;
+        return h ^ (h >> 29);
+    }
+
+    uint64_t hash(std::string_view data) {
+        const char* p = data.data();
+        size_t n = data.size();
+        // Cuatro acumuladores independientes para no esperar a cada multiplicación
+        uint64_t lanes[4] = {0x9E3779B97F4A7C15ULL, 0xBF58476D1CE4E5B9ULL, 0x94D049BB133111EBULL, 0x2545F4914F6CDD1DULL};
+        for (; n >= 32; p += 32, n -= 32) {
+            for (int i = 0; i < 4; ++i) lanes[i] = mix(lanes[i], load64(p + 8 * i));
+        }
+        uint64_t h = data.size();
+        for (uint64_t lane : lanes) h = mix(h, lane);
+        for (; n >= 8; p += 8, n -= 8) h = mix(h, load64(p));
+        if (n > 0) {
+            uint64_t tail = 0;
+            std::memcpy(&tail, p, n);
+            h = mix(h, tail);
+        }
+        h ^= h >> 33;
+        h *= 0xc4ceb9fe1a85ec53ULL;
+        return h ^ (h >> 33);
+    }
+
+    std::string pathFor(const std::string& sourcePath) {
+        // programa.stk -> programa.stkc; cualquier otro nombre recibe la extensión completa
+        std::string_view extension = ".stk";
+        if (sourcePath.size() >= extension.size() &&
+            sourcePath.compare(sourcePath.size() - extension.size(), extension.size(), extension) == 0) {
+            return sourcePath + "c";
+        }
+        return sourcePath + ".stkc";
+    }
+
+    // --- Escritura -------------------------------------------------------
+
+    /**
+     * @class Writer
+     * @brief Serializa nodos en preorden sobre un búfer
+     */
+    class Writer {
+    public:
+        std::string out;       ///< Bytes de los nodos
+        uint64_t nodeCount = 0;
+
+        void node(const ASTNode& node) {
+            ++nodeCount;
+            byte(static_cast<uint8_t>(node.getType()));
+            byte(static_cast<uint8_t>(node.getOperator()));
+            text(node.getValue());
+            literal(node.getLiteral(), node.getValue());
+            varint(node.getChildren().size());
+            for (const auto& child : node.getChildren()) this->node(*child);
+        }
+
+    private:
+        void byte(uint8_t value) { out.push_back(static_cast<char>(value)); }
+
+        void varint(uint64_t value) {
+            while (value >= 0x80) {
+                byte(static_cast<uint8_t>(value | 0x80));
+                value >>= 7;
+            }
+            byte(static_cast<uint8_t>(value));
+        }
+
+        void text(std::string_view chars) {
+            varint(chars.size());
+            out.append(chars);
+        }
+
+        void literal(const Value& value, std::string_view nodeText) {
+            if (value.isNumber()) {
+                byte(static_cast<uint8_t>(LiteralTag::Number));
+                char bits[sizeof(double)];
+                double number = value.asNumber();
+                std::memcpy(bits, &number, sizeof(bits));
+                out.append(bits, sizeof(bits));
+            } else if (value.isBool()) {
+                byte(static_cast<uint8_t>(value.asBool() ? LiteralTag::True : LiteralTag::False));
+            } else if (value.isString()) {
+                if (value.asString() == nodeText) {
+                    byte(static_cast<uint8_t>(LiteralTag::SameString));
+                } else {
+                    byte(static_cast<uint8_t>(LiteralTag::String));
+                    text(value.asString());
+                }
+            } else {
+                byte(static_cast<uint8_t>(LiteralTag::Nil));
+            }
+        }
+    };
+
+    bool store(const std::string& cachePath, std::string_view source, const AST& ast) {
+        if (!ast.root()) return false;
+        Writer writer;
+        writer.node(*ast.root());
+
+        Header header{};
+        std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+        header.version = VERSION;
+        header.sourceHash = hash(source);
+        header.sourceSize = source.size();
+        header.nodeCount = writer.nodeCount;
+        header.payloadHash = hash(writer.out);
+
+        // Nombre temporal único: otra ejecución puede estar escribiendo a la vez
+        std::string temporary = cachePath + ".tmp" + std::to_string(std::random_device{}());
+        {
+            std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+            if (!file) return false;
+            file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            file.write(writer.out.data(), static_cast<std::streamsize>(writer.out.size()));
+            if (!file.flush()) {
+                file.close();
+                std::error_code ignored;
+                std::filesystem::remove(temporary, ignored);
+                return false;
+            }
+        }
+        std::error_code error;
+        std::filesystem::rename(temporary, cachePath, error);
+        if (error) {
+            std::filesystem::remove(temporary, error);
+            return false;
+        }
+        return true;
+    }
+
+    // --- Lectura ---------------------------------------------------------
+
+    /**
+     * @brief Comprueba que un nodo leído tenga la forma que produce el parser
+     * @param node Nodo ya reconstruido, con sus hijos
+     * @return bool false si el evaluador o el compilador no podrían ejecutarlo
+     *
+     * El hash de los nodos solo detecta archivos dañados: uno escrito a
+     * propósito puede tener un hash correcto y, por ejemplo, un BinaryOp sin
+     * operandos, que se leería fuera del vector de hijos al ejecutarlo.
+     */
+    static bool wellFormed(const ASTNode& node) {
+        using Type = ASTNode::Type;
+        const auto& children = node.getChildren();
+        const size_t count = children.size();
+        const Operator op = node.getOperator();
+        const Value& literal = node.getLiteral();
+
+        // Solo BinaryOp y Unary llevan operador, y cada uno los suyos
+        if (node.getType() == Type::BinaryOp) {
+            if (op < Operator::Add || op > Operator::Or) return false;
+        } else if (node.getType() == Type::Unary) {
+            if (op != Operator::Not && op != Operator::Negate) return false;
+        } else if (op != Operator::None) {
+            return false;
+        }
+
+        switch (node.getType()) {
+            case Type::Number:
+                return count == 0 && literal.isNumber();
+            case Type::Boolean:
+                return count == 0 && literal.isBool();
+            case Type::String:
+                return count == 0 && literal.isString();
+            case Type::Nil:
+            case Type::Identifier:
+                return count == 0 && literal.isNil();
+            default:
+                break;
+        }
+        if (!literal.isNil()) return false;
+
+        switch (node.getType()) {
+            case Type::Unary:
+            case Type::Grouping:
+            case Type::PrintStmt:
+                return count == 1;
+            case Type::BinaryOp:
+            case Type::WhileStmt:
+            case Type::Index:
+                return count == 2;
+            case Type::SetIndex:
+                return count == 3;
+            case Type::Assign:
+                return count == 2 && children[0]->getType() == Type::Identifier;
+            case Type::IfStmt:
+                return count == 2 || count == 3;
+            case Type::ReturnStmt:
+            case Type::VarDecl:
+                return count <= 1;
+            case Type::Function:
+                // Parámetros (identificadores) y el bloque del cuerpo al final
+                if (count == 0 || children.back()->getType() != Type::Program) return false;
+                for (size_t i = 0; i + 1 < count; ++i) {
+                    if (children[i]->getType() != Type::Identifier) return false;
+                }
+                return true;
+            default:
+                return true; // Call, Program y Array admiten cualquier número de hijos
+        }
+    }
+
+    /**
+     * @class Reader
+     * @brief Reconstruye los nodos a partir de los bytes de la caché
+     *
+     * Cualquier dato fuera de rango, o un nodo con una forma que el parser
+     * no produce (ver wellFormed), marca la lectura como fallida en lugar
+     * de confiar en el archivo.
+     */
+    class Reader {
+    public:
+        Reader(std::string_view bytes, AST& ast, uint64_t nodeCount)
+            : p(bytes.data()), end(bytes.data() + bytes.size()), ast(ast), remaining(nodeCount) {}
+
+        bool failed = false;
+
+        NodePtr node() {
+            if (remaining == 0) return fail();
+            --remaining;
+            uint8_t type = byte();
+            uint8_t op = byte();
+            if (type > static_cast<uint8_t>(LAST_TYPE) || op > static_cast<uint8_t>(LAST_OPERATOR)) return fail();
+            std::string_view value = text();
+            Value literal = this->literal(value);
+            uint64_t childCount = varint();
+            if (failed || childCount > remaining) return fail();
+
+            auto kind = static_cast<ASTNode::Type>(type);
+            auto result = op != static_cast<uint8_t>(Operator::None)
+                              ? ast.make(kind, value, static_cast<Operator>(op))
+                              : ast.make(kind, value, std::move(literal));
+            result->reserveChildren(static_cast<size_t>(childCount));
+            for (uint64_t i = 0; i < childCount; ++i) {
+                auto child = node();
+                if (!child) return nullptr;
+                result->addChild(std::move(child));
+            }
+            if (!wellFormed(*result)) return fail();
+            return result;
+        }
+
+        bool atEnd() const { return p == end && remaining == 0; }
+
+    private:
+        const char* p;
+        const char* end;
+        AST& ast;
+        uint64_t remaining; ///< Nodos que quedan por leer según la cabecera
+
+        NodePtr fail() {
+            failed = true;
+            return nullptr;
+        }
+
+        uint8_t byte() {
+            if (p == end) {
+                failed = true;
+                return 0;
+            }
+            return static_cast<uint8_t>(*p++);
+        }
+
+        uint64_t varint() {
+            uint64_t value = 0;
+            for (int shift = 0; shift < 64; shift += 7) {
+                uint8_t b = byte();
+                value |= static_cast<uint64_t>(b & 0x7F) << shift;
+                if (!(b & 0x80)) return value;
+            }
+            failed = true;
+            return 0;
+        }
+
+        std::string_view text() {
+            uint64_t size = varint();
+            if (failed || size > static_cast<uint64_t>(end - p)) {
+                failed = true;
+                return {};
+            }
+            std::string_view chars(p, static_cast<size_t>(size));
+            p += size;
+            return chars;
+        }
+
+        Value literal(std::string_view nodeText) {
+            switch (static_cast<LiteralTag>(byte())) {
+                case LiteralTag::Nil:
+                    return {};
+                case LiteralTag::False:
+                    return false;
+                case LiteralTag::True:
+                    return true;
+                case LiteralTag::Number: {
+                    if (static_cast<size_t>(end - p) < sizeof(double)) break;
+                    double number;
+                    std::memcpy(&number, p, sizeof(number));
+                    p += sizeof(number);
+                    return number;
+                }
+                case LiteralTag::String: {
+                    std::string_view chars = text();
+                    if (failed) return {};
+                    return makeString(chars);
+                }
+                case LiteralTag::SameString:
+                    return makeString(nodeText);
+            }
+            failed = true;
+            return {};
+        }
+    };
+
+    std::unique_ptr<AST> load(const std::string& cachePath, std::string_view source) {
+        SourceFile file(cachePath);
+        if (!file.isOpen()) return nullptr;
+        std::string_view bytes = file.contents();
+
+        Header header;
+        if (bytes.size() < sizeof(header)) return nullptr;
+        std::memcpy(&header, bytes.data(), sizeof(header));
+        std::string_view payload = bytes.substr(sizeof(header));
+        if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != VERSION ||
+            header.sourceSize != source.size() || header.sourceHash != hash(source) ||
+            header.nodeCount > payload.size() || header.payloadHash != hash(payload)) {
+            return nullptr;
+        }
+
+        auto ast = std::make_unique<AST>(header.nodeCount * sizeof(ASTNode));
+        Reader reader(payload, *ast, header.nodeCount);
+        auto root = reader.node();
+        if (!root || reader.failed || !reader.atEnd() || root->getType() != ASTNode::Type::Program) return nullptr;
+        ast->setRoot(std::move(root));
+        return ast;
+    }
+}
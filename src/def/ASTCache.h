@@ -0,0 +1,77 @@
+/**
+ * @file ASTCache.h
+ * @brief Caché en disco del AST parseado de un archivo fuente
+ * @author Javier
+ * @date 2025
+ *
+ * Este archivo define la serialización binaria del AST que usa el comando
+ * run para no volver a tokenizar ni parsear un programa que no ha
+ * cambiado. La caché se guarda junto al fuente (archivo.stk -> archivo.stkc)
+ * con el hash de su contenido; si el hash no coincide, o el archivo de
+ * caché está dañado o es de otra versión, simplemente se ignora.
+ */
+
+#ifndef ASTCACHE_H
+#define ASTCACHE_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+
+#include "ASTNode.h"
+
+/**
+ * @namespace TokenTree::ASTCache
+ * @brief Lectura y escritura de la caché de AST
+ *
+ * Formato (en el orden de bytes de la máquina que lo escribió):
+ * - Cabecera: "STKA", versión, hash y longitud del fuente, número de
+ *   nodos y hash del resto del archivo
+ * - Nodos en preorden: tipo, operador, texto, literal y número de hijos,
+ *   con las longitudes codificadas como enteros variables (LEB128)
+ *
+ * Solo se guarda lo que produce el parser; las ranuras del resolver se
+ * recalculan tras cargar, así que la misma caché sirve a los dos motores.
+ */
+namespace TokenTree::ASTCache {
+    /**
+     * @brief Calcula el hash con el que se identifica un fuente
+     * @param data Bytes a resumir
+     * @return uint64_t Hash de 64 bits, estable entre ejecuciones y compilaciones
+     */
+    uint64_t hash(std::string_view data);
+
+    /**
+     * @brief Obtiene la ruta del archivo de caché de un fuente
+     * @param sourcePath Ruta del archivo fuente
+     * @return std::string Ruta de la caché (junto al fuente): archivo.stk
+     *         pasa a archivo.stkc y cualquier otro nombre recibe ".stkc"
+     */
+    std::string pathFor(const std::string& sourcePath);
+
+    /**
+     * @brief Carga el AST guardado para un fuente
+     * @param cachePath Ruta de la caché
+     * @param source Contenido actual del fuente
+     * @return std::unique_ptr<AST> AST reconstruido, o nullptr si no hay una
+     *         caché válida para exactamente ese contenido
+     */
+    std::unique_ptr<AST> load(const std::string& cachePath, std::string_view source);
+
+    /**
+     * @brief Guarda el AST de un fuente
+     * @param cachePath Ruta de la caché
+     * @param source Contenido del fuente del que se obtuvo el AST
+     * @param ast AST tal como lo dejó el parser
+     * @return bool true si la caché quedó escrita
+     *
+     * Se escribe en un archivo temporal que después se renombra, de modo
+     * que varias ejecuciones simultáneas nunca leen una caché a medias.
+     * Los fallos (directorio de solo lectura, disco lleno) no son errores
+     * del programa: solo hacen que la próxima ejecución vuelva a parsear.
+     */
+    bool store(const std::string& cachePath, std::string_view source, const AST& ast);
+}
+
+#endif // ASTCACHE_H
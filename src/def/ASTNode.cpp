@@ -13,20 +13,83 @@
 #include <sstream>
 #include <stdexcept>
 #include <cmath>
+#include <algorithm>
+#include <memory>
 
 namespace TokenTree {
 
-ASTNode::ASTNode(Type type, std::string value)
-    : type(type), value(std::move(value)) {}
+namespace {
+    /**
+     * @brief Copia un rango a la memoria del árbol
+     * @param items Elementos a copiar
+     * @param allocator Asignador de la arena del AST
+     * @return T* Copia (la arena la libera con el resto del árbol)
+     */
+    template <class T>
+    T* arenaCopy(std::span<const T> items, ASTNode::allocator_type allocator) {
+        if (items.empty()) return nullptr;
+        T* copy = allocator.allocate_object<T>(items.size());
+        std::uninitialized_copy(items.begin(), items.end(), copy);
+        return copy;
+    }
+}
+
+ASTNode::ASTNode(Type type, std::string_view value, const allocator_type& allocator)
+    : type(type), value(arenaCopy<char>(value, allocator), value.size()), children(allocator) {}
+
+ASTNode::ASTNode(Type type, std::string_view value, Operator op, const allocator_type& allocator)
+    : type(type), op(op), value(arenaCopy<char>(value, allocator), value.size()), children(allocator) {}
+
+ASTNode::ASTNode(Type type, std::string_view value, Literal literal, const allocator_type& allocator)
+    : type(type), value(arenaCopy<char>(value, allocator), value.size()), literal(std::move(literal)),
+      children(allocator) {}
 
-void ASTNode::addChild(std::unique_ptr<ASTNode> child) {
+void ASTNode::addChild(NodePtr child) {
     children.emplace_back(std::move(child));
 }
 
+void ASTNode::reserveChildren(size_t count) {
+    children.reserve(count);
+}
+
+NodePtr ASTNode::takeChild(size_t index) {
+    return std::move(children[index]);
+}
+
+void ASTNode::setChild(size_t index, NodePtr child) {
+    children[index] = std::move(child);
+}
+
+const char* ASTNode::typeName(Type type) {
+    switch (type) {
+        case Type::Number:     return "Number";
+        case Type::BinaryOp:   return "BinaryOp";
+        case Type::Unary:      return "Unary";
+        case Type::Grouping:   return "Grouping";
+        case Type::Assign:     return "Assign";
+        case Type::String:     return "String";
+        case Type::Boolean:    return "Boolean";
+        case Type::Nil:        return "Nil";
+        case Type::PrintStmt:  return "PrintStmt";
+        case Type::IfStmt:     return "IfStmt";
+        case Type::WhileStmt:  return "WhileStmt";
+        case Type::ReturnStmt: return "ReturnStmt";
+        case Type::Function:   return "Function";
+        case Type::Call:       return "Call";
+        case Type::Program:    return "Program";
+        case Type::VarDecl:    return "VarDecl";
+        case Type::Identifier: return "Identifier";
+        case Type::Array:      return "Array";
+        case Type::Index:      return "Index";
+        case Type::SetIndex:   return "SetIndex";
+    }
+    return "?";
+}
+
 std::string ASTNode::toString() const {
     switch (type) {
         case Type::Number: {
-            std::string s = value;
+            std::string s(value);
             if (s == "true" || s == "false") return s;
             try {
                 std::stod(s);
@@ -42,15 +105,20 @@ std::string ASTNode::toString() const {
         case Type::Boolean:
         case Type::String:
         case Type::Nil:
-            return value;
-        case Type::BinaryOp: {
-            std::string res = "(" + value;
+            return std::string(value);
+        case Type::BinaryOp:
+        case Type::Unary:
+        case Type::Assign: {
+            std::string res = "(";
+            res += value;
             for (const auto& child : children) {
                 res += " " + child->toString();
             }
             res += ")";
             return res;
         }
+        case Type::Grouping:
+            return "(group " + (children.empty() ? "" : children[0]->toString()) + ")";
         case Type::PrintStmt:
             return "(print " + (children.empty() ? "" : children[0]->toString()) + ")";
         case Type::Program: {
@@ -63,13 +131,27 @@ std::string ASTNode::toString() const {
         }
         case Type::VarDecl: {
             // value = nombre variable, children[0] = expresión inicial
-            std::string res = "(var " + value;
+            std::string res = "(var ";
+            res += value;
             if (!children.empty()) res += " = " + children[0]->toString();
             res += ")";
             return res;
         }
         case Type::Identifier:
-            return value;
+            return std::string(value);
+        case Type::Array: {
+            std::string res = "(array";
+            for (const auto& child : children) {
+                res += " " + child->toString();
+            }
+            res += ")";
+            return res;
+        }
+        case Type::Index:
+            return "(index " + children[0]->toString() + " " + children[1]->toString() + ")";
+        case Type::SetIndex:
+            return "(= (index " + children[0]->toString() + " " + children[1]->toString() + ") " +
+                   children[2]->toString() + ")";
         default:
             return "";
     }
@@ -79,13 +161,55 @@ ASTNode::Type ASTNode::getType() const {
     return type;
 }
 
-const std::string& ASTNode::getValue() const {
+std::string_view ASTNode::getValue() const {
     return value;
 
 }
 
-const std::vector<std::unique_ptr<ASTNode>>& ASTNode::getChildren() const {
+Operator ASTNode::getOperator() const {
+    return op;
+}
+
+const ASTNode::Literal& ASTNode::getLiteral() const {
+    return literal;
+}
+
+std::span<const LocalSlot> ASTNode::getSlots() const {
+    return slots;
+}
+
+void ASTNode::setSlots(const std::vector<LocalSlot>& resolved) {
+    slots = {arenaCopy<LocalSlot>(resolved, children.get_allocator()), resolved.size()};
+}
+
+uint32_t ASTNode::getScopeSize() const {
+    return scopeSize;
+}
+
+void ASTNode::setScopeSize(uint32_t size) {
+    scopeSize = size;
+}
+
+bool ASTNode::isCaptured() const {
+    return captured;
+}
+
+void ASTNode::setCaptured() {
+    captured = true;
+}
+
+const std::pmr::vector<NodePtr>& ASTNode::getChildren() const {
     return children;
 }
 
+AST::AST(size_t sizeHint)
+    : arena(std::max<size_t>(sizeHint, 1024)), allocator(&arena) {}
+
+void AST::append(std::unique_ptr<AST> other) {
+    ASTNode* from = other->root();
+    const size_t count = from->getChildren().size();
+    for (size_t i = 0; i < count; ++i) rootNode->addChild(from->takeChild(i));
+    parts.push_back(std::move(other));
+}
+
 } // namespace TokenTree
@@ -12,12 +12,144 @@
 #ifndef ASTNODE_H
 #define ASTNODE_H
 
+#include <atomic>
+#include <cstdint>
+#include <functional>
 #include <memory>
+#include <span>
 #include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 #include <memory_resource>
 
+#include "Value.h"
+
 namespace TokenTree {
+    /**
+     * @enum Operator
+     * @brief Operador de un nodo BinaryOp o Unary, resuelto durante el parsing
+     *
+     * Permite que el evaluador y el compilador despachen con un switch
+     * sobre el operador en lugar de comparar cadenas en cada evaluación.
+     */
+    enum class Operator : uint8_t {
+        None,           ///< El nodo no es un operador
+        Add,            ///< +
+        Subtract,       ///< - binario
+        Multiply,       ///< *
+        Divide,         ///< /
+        Modulo,         ///< %
+        Equal,          ///< ==
+        NotEqual,       ///< !=
+        Less,           ///< <
+        LessEqual,      ///< <=
+        Greater,        ///< >
+        GreaterEqual,   ///< >=
+        And,            ///< and (cortocircuito)
+        Or,             ///< or (cortocircuito)
+        Not,            ///< ! unario
+        Negate          ///< - unario
+    };
+
+    /**
+     * @enum Specialization
+     * @brief Forma en que el evaluador ejecuta un nodo BinaryOp, según los tipos observados
+     *
+     * La primera ejecución de una operación aritmética o de comparación
+     * registra los tipos de sus operandos; si corresponden a una forma
+     * especializada, las siguientes solo comprueban esos tipos y calculan
+     * el resultado directamente. Si la comprobación falla, el nodo pasa
+     * definitivamente a la forma genérica.
+     */
+    enum class Specialization : uint8_t {
+        Unseen,             ///< El nodo aún no se ha ejecutado
+        Generic,            ///< Operandos de tipos variados: comprobación completa
+        AddNumNum,          ///< número + número
+        SubtractNumNum,     ///< número - número
+        MultiplyNumNum,     ///< número * número
+        DivideNumNum,       ///< número / número
+        ModuloNumNum,       ///< número % número
+        LessNumNum,         ///< número < número
+        LessEqualNumNum,    ///< número <= número
+        GreaterNumNum,      ///< número > número
+        GreaterEqualNumNum, ///< número >= número
+        EqualNumNum,        ///< número == número
+        NotEqualNumNum,     ///< número != número
+        ConcatStrStr        ///< cadena + cadena
+    };
+
+    /**
+     * @struct LocalSlot
+     * @brief Ubicación de una variable local calculada por el resolver
+     *
+     * depth es el número de entornos que hay que subir desde el entorno
+     * actual e index la ranura dentro del entorno alcanzado.
+     */
+    struct LocalSlot {
+        uint32_t depth;  ///< Entornos a subir desde el actual
+        uint32_t index;  ///< Ranura dentro de ese entorno
+    };
+
+    /**
+     * @struct NameHash
+     * @brief Hash de nombres que admite búsquedas con std::string_view
+     *
+     * Los nombres de los nodos se leen como vistas (ASTNode::getValue); con
+     * este hash y std::equal_to<> una tabla indexada por std::string los
+     * busca sin crear una cadena temporal.
+     */
+    struct NameHash {
+        using is_transparent = void;
+        size_t operator()(std::string_view name) const { return std::hash<std::string_view>{}(name); }
+    };
+
+    /**
+     * @typedef NameMap
+     * @brief Tabla por nombre de variable que se consulta con std::string_view
+     */
+    template <class T>
+    using NameMap = std::unordered_map<std::string, T, NameHash, std::equal_to<>>;
+
+    class ASTNode;
+    class Environment;
+
+    /**
+     * @struct GlobalCache
+     * @brief Caché en línea de la variable global a la que se refiere un nodo
+     *
+     * La rellena el evaluador la primera vez que un Identifier, un Call o
+     * el destino de un Assign se resuelve por nombre en el entorno global.
+     * Las variables globales nunca se borran y su valor no cambia de
+     * dirección al definir otras, así que la entrada sigue siendo válida
+     * mientras el entorno global sea el mismo; si cambia, se vuelve a buscar.
+     * El entorno se identifica por Environment::getSerial(), no por su
+     * dirección, porque un AST puede sobrevivir a su entorno global y
+     * ejecutarse después con otro (comando serve).
+     */
+    struct GlobalCache {
+        uint64_t globals = 0;           ///< Environment::getSerial() del entorno en el que se resolvió
+        Value* value = nullptr;         ///< Valor de la variable dentro de él
+    };
+
+    /**
+     * @struct NodeDeleter
+     * @brief Destructor de nodos reservados en la arena de un AST
+     *
+     * Solo destruye el nodo: su memoria pertenece a la arena y se libera
+     * de una vez al destruirse el AST.
+     */
+    struct NodeDeleter {
+        void operator()(ASTNode* node) const;
+    };
+
+    /**
+     * @typedef NodePtr
+     * @brief Puntero propietario a un nodo del AST (ver AST::make)
+     */
+    using NodePtr = std::unique_ptr<ASTNode, NodeDeleter>;
+
     /**
      * @class ASTNode
      * @brief Nodo del Árbol de Sintaxis Abstracta
@@ -35,9 +167,12 @@ namespace TokenTree {
          * Define los diferentes tipos de construcciones del lenguaje que
          * pueden ser representadas como nodos en el AST.
          */
-        enum class Type { 
+        enum class Type : uint8_t {
             Number,      ///< Literal numérico
-            BinaryOp,    ///< Operación binaria (+, -, *, /, etc.)
+            BinaryOp,    ///< Operación binaria (+, -, *, /, and, or, etc.)
+            Unary,       ///< Operación unaria (! y -)
+            Grouping,    ///< Expresión entre paréntesis
+            Assign,      ///< Asignación a una variable (identificador = valor)
             String,      ///< Literal de cadena
             Boolean,     ///< Literal booleano (true/false)
             Nil,         ///< Literal nil
@@ -49,27 +184,106 @@ namespace TokenTree {
             Call,        ///< Llamada a función
             Program,     ///< Programa o bloque de código
             VarDecl,     ///< Declaración de variable
-            Identifier   ///< Identificador (nombre de variable/función)
+            Identifier,  ///< Identificador (nombre de variable/función)
+            Array,       ///< Literal de array ([a, b, c]; los hijos son los elementos)
+            Index,       ///< Lectura de un elemento (hijos: array e índice)
+            SetIndex     ///< Asignación a un elemento (hijos: array, índice y valor)
         };
+
+        /// Número de tipos de nodo (para tablas indexadas por Type)
+        static constexpr size_t TYPE_COUNT = static_cast<size_t>(Type::SetIndex) + 1;
+
+        /**
+         * @brief Nombre de un tipo de nodo, para los informes
+         * @param type Tipo de nodo
+         * @return const char* Nombre del enumerador ("BinaryOp", "Call"...)
+         */
+        static const char* typeName(Type type);
+
+        /**
+         * @typedef Literal
+         * @brief Valor ya decodificado de un nodo literal
+         *
+         * Los nodos Number, Boolean y String guardan aquí su valor,
+         * calculado una sola vez durante el parsing, para que evaluarlos no
+         * requiera convertir texto ni reservar memoria: el valor se copia
+         * tal cual. El resto de nodos contiene nil.
+         */
+        using Literal = Value;
+
+        /**
+         * @typedef allocator_type
+         * @brief Asignador de los hijos del nodo (el de la arena del AST)
+         */
+        using allocator_type = std::pmr::polymorphic_allocator<>;
         
     private:
         Type type;                                          ///< Tipo del nodo
-        std::string value;                                  ///< Valor asociado al nodo
-        std::vector<std::unique_ptr<ASTNode>> children;    ///< Nodos hijos
+        Operator op = Operator::None;                       ///< Operador (BinaryOp y Unary)
+        mutable Specialization specialization = Specialization::Unseen; ///< Forma observada (BinaryOp)
+        bool captured = false;                              ///< Una closure puede capturar ese entorno
+        uint32_t scopeSize = 0;                             ///< Ranuras del entorno que abre el nodo
+        std::string_view value;                             ///< Valor asociado al nodo (texto en la arena)
+        Literal literal;                                    ///< Valor de los nodos literales
+        std::span<const LocalSlot> slots;                   ///< Ubicaciones resueltas, en la arena (ver getSlots)
+        mutable GlobalCache globalCache;                    ///< Variable global ya resuelta (evaluador)
+        std::pmr::vector<NodePtr> children;                 ///< Nodos hijos
         
     public:
         /**
          * @brief Constructor de ASTNode
          * @param type Tipo del nodo
-         * @param value Valor asociado al nodo
+         * @param value Valor asociado al nodo (se copia a la arena del AST)
+         * @param allocator Asignador del texto, las ranuras y los hijos
+         */
+        ASTNode(Type type, std::string_view value, const allocator_type& allocator = {});
+
+        /**
+         * @brief Constructor de ASTNode para operadores
+         * @param type Tipo del nodo (BinaryOp o Unary)
+         * @param value Lexema del operador, usado en la representación textual
+         * @param op Operador ya resuelto
+         * @param allocator Asignador del texto, las ranuras y los hijos
          */
-        ASTNode(Type type, std::string value);
+        ASTNode(Type type, std::string_view value, Operator op, const allocator_type& allocator = {});
+
+        /**
+         * @brief Constructor de ASTNode para literales
+         * @param type Tipo del nodo (Number, Boolean o String)
+         * @param value Texto del literal, usado en la representación textual
+         * @param literal Valor ya decodificado
+         * @param allocator Asignador del texto, las ranuras y los hijos
+         */
+        ASTNode(Type type, std::string_view value, Literal literal, const allocator_type& allocator = {});
         
         /**
          * @brief Agrega un nodo hijo al nodo actual
-         * @param child Puntero único al nodo hijo a agregar
+         * @param child Nodo hijo a agregar (reservado en el mismo AST)
+         */
+        void addChild(NodePtr child);
+
+        /**
+         * @brief Reserva espacio para los hijos que se van a agregar
+         * @param count Número total de hijos esperado
+         *
+         * Evita que la lista crezca por duplicación dentro de la arena, que
+         * no recupera los bloques abandonados.
+         */
+        void reserveChildren(size_t count);
+
+        /**
+         * @brief Extrae un hijo para transformarlo (ver setChild)
+         * @param index Posición del hijo
+         * @return NodePtr El hijo; su posición queda vacía hasta llamar a setChild
+         */
+        NodePtr takeChild(size_t index);
+
+        /**
+         * @brief Coloca un nodo en la posición de un hijo existente
+         * @param index Posición del hijo
+         * @param child Nodo nuevo (reservado en el mismo AST)
          */
-        void addChild(std::unique_ptr<ASTNode> child);
+        void setChild(size_t index, NodePtr child);
         
         /**
          * @brief Convierte el nodo y sus hijos a representación textual
@@ -88,15 +302,161 @@ namespace TokenTree {
         
         /**
          * @brief Obtiene el valor asociado al nodo
-         * @return const std::string& Referencia al valor del nodo
+         * @return std::string_view Valor del nodo (válido mientras viva el nodo)
          */
-        const std::string& getValue() const;
+        std::string_view getValue() const;
+
+        /**
+         * @brief Obtiene el operador del nodo
+         * @return Operator Operador resuelto (Operator::None si no es una operación)
+         */
+        Operator getOperator() const;
+
+        /**
+         * @brief Obtiene el valor decodificado de un literal
+         * @return const Literal& Valor del literal (nil si no es un literal)
+         */
+        const Literal& getLiteral() const;
+
+        /**
+         * @brief Obtiene las ubicaciones locales resueltas del nodo
+         * @return std::span<const LocalSlot> Ubicaciones calculadas por el resolver
+         *
+         * - Identifier, Call: ranuras candidatas, de la más interior a la más
+         *   exterior. Se usa la primera ya definida; si ninguna lo está, la
+         *   variable se busca por nombre entre las globales.
+         * - VarDecl, Function y parámetros: ranura que definen (depth 0), o
+         *   vacío si la declaración es global.
+         */
+        std::span<const LocalSlot> getSlots() const;
+
+        /**
+         * @brief Establece las ubicaciones locales resueltas del nodo
+         * @param resolved Ubicaciones calculadas por el resolver (se copian a la arena)
+         */
+        void setSlots(const std::vector<LocalSlot>& resolved);
+
+        /**
+         * @brief Obtiene el número de ranuras del entorno que abre el nodo
+         * @return uint32_t Ranuras de un bloque, o de los parámetros de una función
+         */
+        uint32_t getScopeSize() const;
+
+        /**
+         * @brief Establece el número de ranuras del entorno que abre el nodo
+         * @param size Número de ranuras
+         */
+        void setScopeSize(uint32_t size);
+
+        /**
+         * @brief Indica si el entorno que abre el nodo puede ser capturado
+         * @return bool true si dentro del bloque (o de la función) se declara
+         *         alguna función, cuya closure mantendría vivo el entorno
+         */
+        bool isCaptured() const;
+
+        /**
+         * @brief Marca el entorno que abre el nodo como capturable
+         */
+        void setCaptured();
+
+        /**
+         * @brief Obtiene la caché de la variable global del nodo
+         * @return GlobalCache& Caché (modificable aunque el nodo sea const)
+         */
+        GlobalCache& getGlobalCache() const { return globalCache; }
+
+        /**
+         * @brief Obtiene la forma en que se ejecuta el nodo
+         * @return Specialization Forma especializada, genérica o Unseen
+         *
+         * Los workers de parallel_map pueden especializar el mismo nodo a
+         * la vez; cualquier forma que quede es correcta para su operador,
+         * así que basta con que cada lectura y escritura sea atómica.
+         */
+        Specialization getSpecialization() const {
+            return std::atomic_ref<Specialization>(specialization).load(std::memory_order_relaxed);
+        }
+
+        /**
+         * @brief Cambia la forma en que se ejecuta el nodo (modificable aunque sea const)
+         * @param form Forma nueva
+         */
+        void specialize(Specialization form) const {
+            std::atomic_ref<Specialization>(specialization).store(form, std::memory_order_relaxed);
+        }
         
         /**
          * @brief Obtiene los nodos hijos
-         * @return const std::vector<std::unique_ptr<ASTNode>>& Referencia al vector de hijos
+         * @return const std::pmr::vector<NodePtr>& Referencia al vector de hijos
+         */
+        const std::pmr::vector<NodePtr>& getChildren() const;
+    };
+
+    inline void NodeDeleter::operator()(ASTNode* node) const {
+        std::destroy_at(node);
+    }
+
+    /**
+     * @class AST
+     * @brief Árbol de sintaxis completo junto con la memoria de sus nodos
+     *
+     * Los nodos, su texto, sus ranuras y sus listas de hijos se reservan de
+     * forma contigua en una arena monótona
+     * (std::pmr::monotonic_buffer_resource), en el mismo orden en que el
+     * parser los crea. Así el parsing no reserva memoria nodo a nodo, los
+     * recorridos del árbol se mantienen cerca en caché y la destrucción
+     * libera todos los bloques de una vez. Los nodos deben crearse con make
+     * y no pueden sobrevivir al AST.
+     */
+    class AST {
+    public:
+        /**
+         * @brief Constructor de AST
+         * @param sizeHint Bytes estimados para el primer bloque de la arena
+         */
+        explicit AST(size_t sizeHint = 0);
+
+        AST(const AST&) = delete;
+        AST& operator=(const AST&) = delete;
+
+        /**
+         * @brief Crea un nodo en la arena del árbol
+         * @param args Argumentos del constructor de ASTNode (sin asignador)
+         * @return NodePtr Nodo nuevo, cuyos hijos también usan la arena
+         */
+        template <class... Args>
+        NodePtr make(Args&&... args) {
+            return NodePtr(allocator.new_object<ASTNode>(std::forward<Args>(args)...));
+        }
+
+        /**
+         * @brief Obtiene el nodo raíz
+         * @return ASTNode* Raíz del árbol (tipo Program), o nullptr si aún no existe
+         */
+        ASTNode* root() const { return rootNode.get(); }
+
+        /**
+         * @brief Establece el nodo raíz
+         * @param node Raíz creada con make
          */
-        const std::vector<std::unique_ptr<ASTNode>>& getChildren() const;
+        void setRoot(NodePtr node) { rootNode = std::move(node); }
+
+        /**
+         * @brief Añade al final del programa las sentencias de otro árbol
+         * @param other Árbol con raíz Program (este también debe tenerla)
+         *
+         * Los nodos no se copian: siguen en la arena de other, que pasa a
+         * pertenecer a este árbol. El resultado es el mismo programa que
+         * daría parsear los dos fuentes concatenados.
+         */
+        void append(std::unique_ptr<AST> other);
+
+    private:
+        std::vector<std::unique_ptr<AST>> parts;   ///< Árboles unidos con append (se destruyen los últimos)
+        std::pmr::monotonic_buffer_resource arena; ///< Memoria de todos los nodos
+        ASTNode::allocator_type allocator;         ///< Asignador sobre la arena
+        NodePtr rootNode;                          ///< Raíz (se destruye antes que la arena)
     };
 }
 
@@ -0,0 +1,48 @@
+/**
+ * @file Array.cpp
+ * @brief Implementación de los arrays de Setker
+ * @author Javier
+ * @date 2025
+ */
+
+#include "Array.h"
+
+#include <algorithm>
+
+#include "Workers.h"
+
+namespace TokenTree {
+    void ArrayObject::fill(const Value& value) {
+        size_t count = size();
+        if (value.isNumber()) {
+            values.clear();
+            numbers.assign(count, value.asNumber());
+            numeric = true;
+        } else {
+            numbers.clear();
+            values.assign(count, value);
+            numeric = false;
+        }
+    }
+
+    Value ArrayObject::transfer(Transfer& transfer) const {
+        auto copy = makeRef<ArrayObject>();
+        // Antes que los elementos: alguno puede contener el propio array
+        transfer.remember(this, copy);
+        if (numeric) {
+            copy->numbers = numbers;
+        } else {
+            copy->values.reserve(values.size());
+            for (const Value& value : values) copy->values.push_back(transfer.copy(value));
+            copy->numeric = false;
+        }
+        return copy;
+    }
+
+    void ArrayObject::box() {
+        values.reserve(std::max(numbers.capacity(), numbers.size() + 1));
+        for (double number : numbers) values.emplace_back(number);
+        numbers = {};
+        numeric = false;
+    }
+}
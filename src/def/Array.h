@@ -0,0 +1,140 @@
+/**
+ * @file Array.h
+ * @brief Arrays de Setker
+ * @author Javier
+ * @date 2025
+ *
+ * Este archivo define ArrayObject, el valor que crean los literales
+ * [a, b, c]. Los elementos se guardan de forma contigua; mientras todos
+ * son números se guardan como double sin etiquetar, de modo que las
+ * nativas de Native.cpp (sum, fill, scale, offset) recorren un búfer de
+ * double que el compilador puede vectorizar.
+ */
+
+#ifndef ARRAY_H
+#define ARRAY_H
+
+#include <cstddef>
+#include <vector>
+
+#include "Heap.h"
+#include "Value.h"
+
+namespace TokenTree {
+    /**
+     * @struct ArrayObject
+     * @brief Secuencia mutable de valores, indexada desde 0
+     *
+     * Tiene dos representaciones: numbers mientras todos los elementos son
+     * números y values en cuanto se guarda cualquier otro valor. El paso a
+     * values es definitivo salvo que fill() vuelva a llenar el array de
+     * números. Como puede guardar funciones que a su vez lo referencian, es
+     * un contenedor del Heap.
+     */
+    struct ArrayObject : Object, Collectable {
+        /**
+         * @brief Constructor de ArrayObject
+         * @param count Elementos iniciales (todos 0)
+         */
+        explicit ArrayObject(size_t count = 0) : Object(Kind::Array), numbers(count) { track(Type::Array); }
+
+        /// @return size_t Número de elementos
+        size_t size() const { return numeric ? numbers.size() : values.size(); }
+
+        /// @return bool true si todos los elementos están en el búfer de double
+        bool isNumeric() const { return numeric; }
+
+        /**
+         * @brief Obtiene los elementos sin etiquetar (solo si isNumeric())
+         * @return double* Primer elemento de size() números contiguos
+         */
+        double* numberData() { return numbers.data(); }
+        const double* numberData() const { return numbers.data(); }
+
+        /**
+         * @brief Obtiene los elementos como valores (solo si !isNumeric())
+         * @return const Value* Primer elemento de size() valores contiguos
+         */
+        const Value* valueData() const { return values.data(); }
+
+        /**
+         * @brief Lee un elemento
+         * @param index Posición (menor que size())
+         * @return Value Copia del elemento
+         */
+        Value get(size_t index) const { return numeric ? Value(numbers[index]) : values[index]; }
+
+        /**
+         * @brief Sustituye un elemento
+         * @param index Posición (menor que size())
+         * @param value Valor nuevo
+         */
+        void set(size_t index, const Value& value) {
+            if (numeric) {
+                if (value.isNumber()) {
+                    numbers[index] = value.asNumber();
+                    return;
+                }
+                box();
+            }
+            values[index] = value;
+        }
+
+        /**
+         * @brief Añade un elemento al final
+         * @param value Valor nuevo
+         */
+        void push(const Value& value) {
+            if (numeric) {
+                if (value.isNumber()) {
+                    numbers.push_back(value.asNumber());
+                    return;
+                }
+                box();
+            }
+            values.push_back(value);
+        }
+
+        /**
+         * @brief Reserva espacio para los elementos que se van a añadir
+         * @param count Número total de elementos esperado
+         */
+        void reserve(size_t count) {
+            if (numeric) numbers.reserve(count);
+            else values.reserve(count);
+        }
+
+        /**
+         * @brief Sustituye todos los elementos por el mismo valor
+         * @param value Valor de relleno (si es un número, el array vuelve al búfer de double)
+         */
+        void fill(const Value& value);
+
+        Collectable* collectable() override { return this; }
+
+        /// Copia: los mismos elementos, copiados a su vez
+        Value transfer(Transfer& transfer) const override;
+
+    protected:
+        size_t references() const override { return refCount; }
+        void traverse(Tracer& tracer) const override {
+            for (const Value& value : values) tracer.visit(value);
+        }
+        void pin(Pins& pins) override { pins.objects.emplace_back(static_cast<Object*>(this)); }
+        void clear() override {
+            values.clear();
+            numbers.clear();
+            numeric = true;
+        }
+
+    private:
+        std::vector<double> numbers; ///< Elementos mientras numeric
+        std::vector<Value> values;   ///< Elementos en cuanto alguno no es un número
+        bool numeric = true;         ///< Representación en uso
+
+        /// Pasa los elementos de numbers a values
+        void box();
+    };
+}
+
+#endif // ARRAY_H
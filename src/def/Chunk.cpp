@@ -0,0 +1,46 @@
+/**
+ * @file Chunk.cpp
+ * @brief Implementación de las tablas auxiliares del bytecode
+ * @author Javier
+ * @date 2025
+ *
+ * Este archivo contiene las búsquedas sobre las tablas de un Chunk
+ * (rutas de sentencias y ligaduras alternativas) y la tabla de globales.
+ */
+
+#include "Chunk.h"
+#include "ErrorCode.h"
+
+#include <algorithm>
+#include <iterator>
+#include <limits>
+
+namespace TokenTree {
+    const std::vector<uint32_t>& Chunk::pathAt(size_t offset) const {
+        static const std::vector<uint32_t> empty;
+        // Último tramo que empieza en o antes del offset
+        auto it = std::upper_bound(sites.begin(), sites.end(), offset,
+            [](size_t value, const std::pair<uint32_t, uint32_t>& site) { return value < site.first; });
+        if (it == sites.begin()) return empty;
+        return paths[std::prev(it)->second];
+    }
+
+    const std::vector<Binding>* Chunk::fallbackAt(size_t offset) const {
+        auto it = std::lower_bound(fallbacks.begin(), fallbacks.end(), offset,
+            [](const std::pair<uint32_t, std::vector<Binding>>& entry, size_t value) { return entry.first < value; });
+        if (it == fallbacks.end() || it->first != offset) return nullptr;
+        return &it->second;
+    }
+
+    uint16_t GlobalTable::intern(std::string_view name) {
+        auto it = index.find(name);
+        if (it != index.end()) return it->second;
+        if (names.size() > std::numeric_limits<uint16_t>::max()) {
+            throw Error(ErrorCodes::CompileError, "Too many global variables.");
+        }
+        auto slot = static_cast<uint16_t>(names.size());
+        names.emplace_back(name);
+        index.emplace(name, slot);
+        return slot;
+    }
+}
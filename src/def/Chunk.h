@@ -0,0 +1,182 @@
+/**
+ * @file Chunk.h
+ * @brief Representación en bytecode de los programas Setker
+ * @author Javier
+ * @date 2025
+ *
+ * Este archivo define el juego de instrucciones de la máquina virtual,
+ * el fragmento de código (chunk) que genera el compilador y los prototipos
+ * de función que lo contienen. Es el formato intermedio entre el AST y
+ * la ejecución con 'run --vm'.
+ */
+
+#ifndef CHUNK_H
+#define CHUNK_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "Environment.h"
+
+/**
+ * @def SETKER_OPCODES
+ * @brief Lista de instrucciones de la máquina virtual (X-macro)
+ *
+ * A partir de esta única lista se generan el enum OpCode y la tabla de
+ * despacho de la VM, de modo que ambos nunca se desincronizan.
+ * Los operandos se codifican a continuación del código de operación:
+ * u8 = un byte, u16 = dos bytes en orden big-endian.
+ */
+#define SETKER_OPCODES(X) \
+    X(Constant)      /* u16 k: apila constants[k]                              */ \
+    X(Nil)           /* apila nil                                              */ \
+    X(True)          /* apila true                                             */ \
+    X(False)         /* apila false                                            */ \
+    X(Pop)           /* descarta la cima                                       */ \
+    X(Reserve)       /* u16 n: reserva n ranuras locales sin definir           */ \
+    X(PopScope)      /* u16 n: cierra upvalues y descarta n ranuras locales    */ \
+    X(GetLocal)      /* u16 s: apila la ranura s del marco                     */ \
+    X(SetLocal)      /* u16 s: asigna la cima a la ranura s (sin desapilar)    */ \
+    X(DefineLocal)   /* u16 s: desapila y define la ranura s                   */ \
+    X(GetUpvalue)    /* u16 u: apila el upvalue u de la closure                */ \
+    X(SetUpvalue)    /* u16 u: asigna la cima al upvalue u (sin desapilar)     */ \
+    X(GetGlobal)     /* u16 g: apila la global g                               */ \
+    X(SetGlobal)     /* u16 g: asigna la cima a la global g (sin desapilar)    */ \
+    X(DefineGlobal)  /* u16 g: desapila y define la global g                   */ \
+    X(Equal)         /* a b -> a == b                                          */ \
+    X(NotEqual)      /* a b -> a != b                                          */ \
+    X(Greater)       /* a b -> a > b                                           */ \
+    X(GreaterEqual)  /* a b -> a >= b                                          */ \
+    X(Less)          /* a b -> a < b                                           */ \
+    X(LessEqual)     /* a b -> a <= b                                          */ \
+    X(Add)           /* a b -> a + b (números o concatenación)                 */ \
+    X(Subtract)      /* a b -> a - b                                           */ \
+    X(Multiply)      /* a b -> a * b                                           */ \
+    X(Divide)        /* a b -> a / b                                           */ \
+    X(Modulo)        /* a b -> fmod(a, b)                                      */ \
+    X(Not)           /* a -> !a                                                */ \
+    X(Negate)        /* a -> -a                                                */ \
+    X(Print)         /* desapila e imprime                                     */ \
+    X(Jump)          /* u16 d: salta d bytes hacia delante                     */ \
+    X(JumpIfFalse)   /* u16 d: salta si la cima es falsy (sin desapilar)       */ \
+    X(JumpIfTrue)    /* u16 d: salta si la cima es truthy (sin desapilar)      */ \
+    X(Loop)          /* u16 d: salta d bytes hacia atrás                       */ \
+    X(CheckCall)     /* u8 n, u16 k: valida que la cima sea invocable con n    */ \
+                     /* argumentos; k es el nombre para el mensaje de error    */ \
+    X(Call)          /* u8 n: invoca la función situada bajo n argumentos      */ \
+    X(Closure)       /* u16 f: apila una closure de functions[f]               */ \
+    X(Array)         /* u16 n: sustituye los n valores de la cima por un array */ \
+    X(GetIndex)      /* a i -> a[i]                                            */ \
+    X(SetIndex)      /* a i v -> v, tras asignar a[i] = v                      */ \
+    X(Return)        /* desapila el resultado y vuelve al marco anterior       */
+
+namespace TokenTree {
+    /**
+     * @enum OpCode
+     * @brief Códigos de operación de la máquina virtual
+     */
+    enum class OpCode : uint8_t {
+#define SETKER_OPCODE_ENUM(name) name,
+        SETKER_OPCODES(SETKER_OPCODE_ENUM)
+#undef SETKER_OPCODE_ENUM
+    };
+
+    struct FunctionProto;
+
+    /**
+     * @struct Binding
+     * @brief Ubicación de una variable resuelta en tiempo de compilación
+     */
+    struct Binding {
+        /**
+         * @enum Kind
+         * @brief Dónde vive la variable
+         */
+        enum class Kind : uint8_t {
+            Local,   ///< Ranura de la pila del marco actual
+            Upvalue, ///< Variable capturada de una función envolvente
+            Global   ///< Tabla de globales de la VM
+        };
+        Kind kind;       ///< Tipo de ubicación
+        uint16_t index;  ///< Ranura, índice de upvalue o índice de global
+    };
+
+    /**
+     * @struct Chunk
+     * @brief Secuencia de bytecode con sus tablas asociadas
+     *
+     * Además del código y las constantes, guarda la información necesaria
+     * para reproducir los mensajes de error del evaluador ("[line N]") y
+     * las ligaduras alternativas de cada acceso a variable local, que se
+     * consultan cuando la ranura todavía no ha sido definida.
+     */
+    struct Chunk {
+        std::vector<uint8_t> code;                             ///< Instrucciones y operandos
+        std::vector<Environment::Value> constants;             ///< Tabla de constantes
+        std::vector<std::shared_ptr<FunctionProto>> functions; ///< Funciones anidadas
+        std::vector<std::vector<uint32_t>> paths;              ///< Rutas de sentencias (del bloque exterior al interior)
+        std::vector<std::pair<uint32_t, uint32_t>> sites;      ///< (offset inicial, ruta) en orden creciente
+        std::vector<std::pair<uint32_t, std::vector<Binding>>> fallbacks; ///< Ligaduras alternativas por offset
+
+        /**
+         * @brief Obtiene la ruta de sentencias de la instrucción en un offset
+         * @param offset Posición dentro de code
+         * @return const std::vector<uint32_t>& Índices de sentencia, del exterior al interior
+         */
+        const std::vector<uint32_t>& pathAt(size_t offset) const;
+
+        /**
+         * @brief Obtiene las ligaduras alternativas de un acceso a variable
+         * @param offset Posición del código de operación dentro de code
+         * @return const std::vector<Binding>* Ligaduras en orden de búsqueda, o nullptr
+         */
+        const std::vector<Binding>* fallbackAt(size_t offset) const;
+    };
+
+    /**
+     * @struct UpvalueDesc
+     * @brief Descripción de una variable capturada por una closure
+     */
+    struct UpvalueDesc {
+        bool isLocal;    ///< true si se captura una ranura del marco envolvente
+        uint16_t index;  ///< Ranura local o índice de upvalue del envolvente
+    };
+
+    /**
+     * @struct FunctionProto
+     * @brief Función compilada (sin entorno capturado)
+     */
+    struct FunctionProto {
+        std::string name;                  ///< Nombre de la función ("script" para el programa)
+        int arity = 0;                     ///< Número de parámetros
+        std::vector<UpvalueDesc> upvalues; ///< Variables capturadas al crear la closure
+        Chunk chunk;                       ///< Código de la función
+    };
+
+    /**
+     * @struct GlobalTable
+     * @brief Tabla de nombres de variables globales
+     *
+     * Asigna a cada nombre global un índice fijo, de modo que la VM accede
+     * a las globales por posición en lugar de por búsqueda de cadena.
+     */
+    struct GlobalTable {
+        std::vector<std::string> names;                    ///< Nombre de cada índice
+        NameMap<uint16_t> index;                           ///< Índice de cada nombre
+
+        /**
+         * @brief Obtiene (o asigna) el índice de una global
+         * @param name Nombre de la variable
+         * @return uint16_t Índice de la variable en la tabla
+         * @throws Error Si se supera el número máximo de globales
+         */
+        uint16_t intern(std::string_view name);
+    };
+}
+
+#endif // CHUNK_H
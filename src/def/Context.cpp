@@ -0,0 +1,62 @@
+/**
+ * @file Context.cpp
+ * @brief Implementación del estado de ejecución de cada intérprete
+ * @author Javier
+ * @date 2025
+ */
+
+#include "Context.h"
+
+#include <cstdlib>
+#include <utility>
+
+#include "Native.h"
+
+namespace TokenTree {
+    namespace {
+        /// Context instalado en este hilo (nullptr = el del proceso)
+        thread_local Context* installed = nullptr;
+    }
+
+    Context::Context(std::FILE* out) : output(out) {
+        resetGlobals();
+    }
+
+    Context::~Context() {
+        // Las globales se liberan mientras su tabla de cadenas sigue viva
+        output.flush();
+        globals.reset();
+        // Las funciones que se referencian entre sí (o a su propio entorno) solo se liberan así
+        heap.collect();
+    }
+
+    void Context::resetGlobals() {
+        // Las cadenas que creen las nativas van a la tabla de este Context
+        Scope scope(*this);
+        globals = std::make_shared<Environment>();
+        for (auto& native : makeNatives()) globals->define(native->name, native);
+    }
+
+    Context& Context::current() {
+        return installed ? *installed : process();
+    }
+
+    Context& Context::process() {
+        // Nunca se destruye (hay valores en entornos estáticos que mueren
+        // después), pero su salida se vacía al terminar el proceso
+        static auto* context = [] {
+            auto* created = new Context(stdout);
+            std::atexit([] { process().output.flush(); });
+            return created;
+        }();
+        return *context;
+    }
+
+    Context::Scope::Scope(Context& context)
+        : previous(std::exchange(installed, &context)), previousStrings(StringTable::install(&context.strings)) {}
+
+    Context::Scope::~Scope() {
+        installed = previous;
+        StringTable::install(previousStrings);
+    }
+}
@@ -0,0 +1,117 @@
+/**
+ * @file Context.h
+ * @brief Estado de ejecución propio de cada intérprete
+ * @author Javier
+ * @date 2025
+ *
+ * Este archivo define Context, que agrupa todo lo que un programa en
+ * ejecución comparte entre sus funciones: la tabla de cadenas internadas,
+ * el recolector de ciclos, las variables globales, la arena de entornos y
+ * la salida de print. Con un Context por intérprete, varios programas
+ * pueden ejecutarse a la vez en hilos distintos sin compartir ningún
+ * objeto.
+ */
+
+#ifndef CONTEXT_H
+#define CONTEXT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+#include "Environment.h"
+#include "FrameArena.h"
+#include "Heap.h"
+#include "Output.h"
+#include "Value.h"
+
+namespace TokenTree {
+    /**
+     * @struct TailCalls
+     * @brief Estado con el que el evaluador elimina las llamadas de cola
+     *
+     * Un return f(...) deja aquí los argumentos ya evaluados y la llamada
+     * en curso los recoge para ejecutar f sin crecer la pila de C++.
+     */
+    struct TailCalls {
+        /// Tramos de líneas que conserva cada llamada al principio y al final
+        /// de su cadena de cola; los de en medio se resumen en un contador
+        /// (también en la VM), para que una recursión mutua no gaste memoria
+        static constexpr size_t KEPT_RUNS = 8;
+
+        std::vector<Value> args;     ///< Argumentos de la llamada pendiente
+        std::vector<uint32_t> lines; ///< Sentencias que abandonó la llamada pendiente (de dentro afuera)
+        std::vector<size_t> trace;   ///< Líneas de los marcos eliminados, por cada llamada activa
+    };
+
+    /**
+     * @class Context
+     * @brief Cadenas, globales, arena y salida de un intérprete
+     *
+     * El evaluador y la máquina virtual usan el Context instalado en el
+     * hilo actual (ver Scope); si no hay ninguno, el del proceso, que
+     * escribe en stdout y es el que usan los comandos de main.
+     *
+     * Un Context solo puede estar instalado en un hilo a la vez, y los
+     * valores de un Context no deben llegar a otro.
+     */
+    class Context {
+    public:
+        /**
+         * @brief Constructor de Context: globales con las funciones nativas
+         * @param out Destino de print (sin transferir la propiedad)
+         */
+        explicit Context(std::FILE* out = stdout);
+        ~Context();
+        Context(const Context&) = delete;
+        Context& operator=(const Context&) = delete;
+
+        StringTable strings;                  ///< Cadenas internadas (se destruye la última)
+        Heap heap;                            ///< Contenedores que pueden formar ciclos
+        FrameArena frames;                    ///< Ranuras de los entornos que no escapan
+        Output output;                        ///< Salida de print
+        TailCalls tail;                       ///< Llamadas de cola del evaluador
+        std::shared_ptr<Environment> globals; ///< Entorno global del evaluador
+        unsigned workers = 0;                 ///< Hilos de parallel_map (0 = uno por núcleo, 1 = sin repartir)
+
+        /**
+         * @brief Vuelve a empezar con globales nuevas (solo las nativas)
+         */
+        void resetGlobals();
+
+        /**
+         * @brief Obtiene el Context del hilo actual
+         * @return Context& Context instalado, o el del proceso
+         */
+        static Context& current();
+
+        /**
+         * @brief Obtiene el Context del proceso (el que se usa sin instalar otro)
+         * @return Context& Context sobre stdout, que nunca se destruye
+         */
+        static Context& process();
+
+        /**
+         * @class Scope
+         * @brief Instala un Context (y su tabla de cadenas) en el hilo actual
+         *
+         * Al destruirse restaura el que hubiera antes, de modo que pueden
+         * anidarse.
+         */
+        class Scope {
+        public:
+            explicit Scope(Context& context);
+            ~Scope();
+            Scope(const Scope&) = delete;
+            Scope& operator=(const Scope&) = delete;
+
+        private:
+            Context* previous;
+            StringTable* previousStrings;
+        };
+    };
+}
+
+#endif // CONTEXT_H
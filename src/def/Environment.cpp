@@ -10,17 +10,38 @@
  */
 
 #include "Environment.h"
+#include <algorithm>
+#include <atomic>
 #include <stdexcept>
 
 namespace TokenTree {
-    Environment::Environment() : enclosing(nullptr) {}
-    Environment::Environment(std::shared_ptr<Environment> enclosing) : enclosing(enclosing) {}
+    namespace {
+        /// Siguiente identificador de entorno global (compartido por todos los hilos)
+        std::atomic<uint64_t> nextSerial{1};
+    }
 
-    void Environment::define(const std::string& name, const Value& value) {
-        values[name] = value;
+    Environment::Environment() : serial(nextSerial.fetch_add(1, std::memory_order_relaxed)) {
+        track(Type::Environment);
+    }
+    Environment::Environment(std::shared_ptr<Environment> enclosing)
+        : enclosing(enclosing.get()), owner(std::move(enclosing)) {
+        track(Type::Environment);
     }
+    Environment::Environment(std::shared_ptr<Environment> enclosing, size_t slotCount)
+        : ownedSlots(slotCount, Undefined{}), slots(ownedSlots.data()),
+          enclosing(enclosing.get()), owner(std::move(enclosing)) {
+        track(Type::Environment);
+    }
+    Environment::Environment(Environment* enclosing, Value* slots)
+        : slots(slots), enclosing(enclosing) {}
 
-    Environment::Value Environment::get(const std::string& name) const {
+    void Environment::define(std::string_view name, const Value& value) {
+        auto it = values.find(name);
+        if (it != values.end()) it->second = value;
+        else values.emplace(name, value);
+    }
+
+    Environment::Value Environment::get(std::string_view name) const {
         auto it = values.find(name);
         if (it != values.end()) {
             return it->second;
@@ -28,19 +49,74 @@ namespace TokenTree {
         if (enclosing) {
             return enclosing->get(name);
         }
-        throw std::runtime_error("Undefined variable '" + name + "'.");
+        throw std::runtime_error("Undefined variable '" + std::string(name) + "'.");
     }
 
-    void Environment::assign(const std::string& name, const Value& value) {
+    void Environment::assign(std::string_view name, const Value& value) {
         auto it = values.find(name);
         if (it != values.end()) {
-            values[name] = value;
+            it->second = value;
             return;
         }
         if (enclosing) {
             enclosing->assign(name, value);
             return;
         }
-        throw std::runtime_error("Undefined variable '" + name + "'.");
+        throw std::runtime_error("Undefined variable '" + std::string(name) + "'.");
+    }
+
+    Environment::Value* Environment::find(std::span<const LocalSlot> candidates) {
+        for (const auto& candidate : candidates) {
+            Environment* env = this;
+            for (uint32_t i = 0; i < candidate.depth; ++i) env = env->enclosing;
+            Value& value = env->slots[candidate.index];
+            if (!value.isUndefined()) return &value;
+        }
+        return nullptr;
+    }
+
+    const LocalSlot* Environment::match(std::span<const LocalSlot> candidates) const {
+        for (const auto& candidate : candidates) {
+            const Environment* env = this;
+            for (uint32_t i = 0; i < candidate.depth; ++i) env = env->enclosing;
+            if (!env->slots[candidate.index].isUndefined()) return &candidate;
+        }
+        return nullptr;
+    }
+
+    Environment::Value* Environment::findLocal(std::string_view name) {
+        auto it = values.find(name);
+        if (it != values.end()) return &it->second;
+        Value imported;
+        if (!source || !source->import(std::string(name), imported)) return nullptr;
+        return &values.emplace(name, std::move(imported)).first->second;
+    }
+
+    Environment& Environment::global() {
+        Environment* env = this;
+        while (env->enclosing) env = env->enclosing;
+        return *env;
+    }
+
+    size_t Environment::references() const {
+        return static_cast<size_t>(weak_from_this().use_count());
+    }
+
+    void Environment::traverse(Tracer& tracer) const {
+        for (const auto& entry : values) tracer.visit(entry.second);
+        for (const Value& value : ownedSlots) tracer.visit(value);
+        if (owner) tracer.visit(owner.get());
+    }
+
+    void Environment::pin(Pins& pins) {
+        pins.shared.push_back(shared_from_this());
+    }
+
+    void Environment::clear() {
+        // Las ranuras no se mueven: otras referencias a ellas quedan en nil
+        values.clear();
+        std::fill(ownedSlots.begin(), ownedSlots.end(), Value());
+        owner.reset();
+        enclosing = nullptr;
     }
 }
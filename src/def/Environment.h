@@ -12,19 +12,37 @@
 #ifndef ENVIRONMENT_H
 #define ENVIRONMENT_H
 
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <unordered_map>
-#include <variant>
+#include <vector>
 #include <memory>
+#include <span>
 #include "ASTNode.h"
-
-// Forward declaration para evitar dependencias circulares
-namespace Evaluator { 
-    struct LoxFunction; 
-    using FunctionPtr = std::shared_ptr<LoxFunction>; 
-}
+#include "Heap.h"
+#include "Value.h"
 
 namespace TokenTree {
+    class Transfer;
+
+    /**
+     * @class GlobalSource
+     * @brief Origen de las variables que un entorno global todavía no tiene
+     */
+    class GlobalSource {
+    public:
+        virtual ~GlobalSource() = default;
+
+        /**
+         * @brief Busca una variable en el origen y la copia
+         * @param name Nombre de la variable
+         * @param value Recibe la copia
+         * @return bool false si el origen tampoco la define
+         */
+        virtual bool import(const std::string& name, Value& value) = 0;
+    };
+
     /**
      * @class Environment
      * @brief Entorno de ejecución para variables y funciones
@@ -32,21 +50,23 @@ namespace TokenTree {
      * Implementa un sistema de entornos anidados que permite el manejo
      * de variables locales y globales, soportando scoping léxico y
      * closures. Cada entorno puede tener un entorno padre (enclosing).
+     *
+     * Los entornos que una closure puede capturar viven en el heap
+     * (std::shared_ptr) y mantienen vivo a su padre. Los que no escapan
+     * usan ranuras de una FrameArena y solo enlazan al padre sin poseerlo,
+     * ya que nunca sobreviven a él.
+     *
+     * Los del heap (que deben crearse con std::make_shared) se registran en
+     * el Heap del Context: una función guardada en una de sus ranuras los
+     * mantiene vivos a la vez que ellos a ella.
      */
-    class Environment {
+    class Environment : public std::enable_shared_from_this<Environment>, public Collectable {
     public:
         /**
          * @typedef Value
-         * @brief Tipo variante para valores almacenados en el entorno
-         * 
-         * Puede contener:
-         * - std::monostate: Valor nil/vacío
-         * - double: Números
-         * - bool: Valores booleanos
-         * - std::string: Cadenas de texto
-         * - Evaluator::FunctionPtr: Funciones definidas por el usuario
-         */
-        using Value = std::variant<std::monostate, double, bool, std::string, Evaluator::FunctionPtr>;
+         * @brief Valor almacenado en el entorno (ver TokenTree::Value)
+         */
+        using Value = TokenTree::Value;
         
         /**
          * @brief Constructor para entorno global (sin padre)
@@ -58,6 +78,25 @@ namespace TokenTree {
          * @param enclosing Puntero al entorno padre
          */
         Environment(std::shared_ptr<Environment> enclosing);
+
+        /**
+         * @brief Constructor para entorno local con ranuras indexadas
+         * @param enclosing Puntero al entorno padre
+         * @param slotCount Número de ranuras calculado por el resolver
+         *
+         * Todas las ranuras empiezan como Undefined hasta que se definen.
+         */
+        Environment(std::shared_ptr<Environment> enclosing, size_t slotCount);
+
+        /**
+         * @brief Constructor para entorno local que no escapa
+         * @param enclosing Entorno padre (debe sobrevivir a este entorno)
+         * @param slots Ranuras ya reservadas (por ejemplo, en una FrameArena)
+         */
+        Environment(Environment* enclosing, Value* slots);
+
+        Environment(const Environment&) = delete;
+        Environment& operator=(const Environment&) = delete;
         
         /**
          * @brief Define una nueva variable en el entorno actual
@@ -67,7 +106,7 @@ namespace TokenTree {
          * Crea una nueva variable en el entorno actual. Si la variable
          * ya existe, sobrescribe su valor.
          */
-        void define(const std::string& name, const Value& value);
+        void define(std::string_view name, const Value& value);
         
         /**
          * @brief Obtiene el valor de una variable
@@ -78,7 +117,7 @@ namespace TokenTree {
          * Busca la variable primero en el entorno actual, luego en
          * entornos padre hasta encontrarla o lanzar error.
          */
-        Value get(const std::string& name) const;
+        Value get(std::string_view name) const;
         
         /**
          * @brief Asigna un nuevo valor a una variable existente
@@ -89,11 +128,88 @@ namespace TokenTree {
          * Busca la variable en el entorno actual y entornos padre,
          * asignando el nuevo valor en el entorno donde se encuentra.
          */
-        void assign(const std::string& name, const Value& value);
-        
+        void assign(std::string_view name, const Value& value);
+
+        /**
+         * @brief Define una variable local en una ranura
+         * @param slot Ranura asignada por el resolver
+         * @param value Valor de la variable
+         */
+        void defineAt(size_t slot, const Value& value) { slots[slot] = value; }
+
+        /**
+         * @brief Busca la primera ranura ya definida de una lista de candidatas
+         * @param candidates Ubicaciones resueltas, de la más interior a la más exterior
+         * @return Value* Valor encontrado, o nullptr si ninguna está definida
+         *
+         * Si devuelve nullptr la variable debe buscarse por nombre en el
+         * entorno global (ver global()).
+         */
+        Value* find(std::span<const LocalSlot> candidates);
+
+        /**
+         * @brief Obtiene la candidata que find() elegiría
+         * @param candidates Ubicaciones resueltas, de la más interior a la más exterior
+         * @return const LocalSlot* Primera candidata definida, o nullptr (variable global)
+         *
+         * Sirve para saber a qué profundidad se encontró una variable sin
+         * añadir trabajo a find().
+         */
+        const LocalSlot* match(std::span<const LocalSlot> candidates) const;
+
+        /**
+         * @brief Busca una variable por nombre solo en este entorno
+         * @param name Nombre de la variable
+         * @return Value* Su valor, o nullptr si no está definida aquí
+         *
+         * La dirección devuelta no cambia al definir otras variables ni al
+         * asignar esta, así que puede guardarse (ver GlobalCache). Si el
+         * entorno tiene origen (importFrom), una variable que no define se
+         * copia de él antes de responder.
+         */
+        Value* findLocal(std::string_view name);
+
+        /**
+         * @brief Completa este entorno global con las variables de otro intérprete
+         * @param source Origen (sin transferir la propiedad; nullptr lo desactiva)
+         *
+         * Así empiezan los workers de parallel_map: con las globales vacías,
+         * copiando solo las que usan y la primera vez que las usan.
+         */
+        void importFrom(GlobalSource* source) { this->source = source; }
+
+        /**
+         * @brief Obtiene el entorno global (raíz de la cadena)
+         * @return Environment& Entorno sin padre en el que termina la cadena
+         */
+        Environment& global();
+
+        /**
+         * @brief Identificador del entorno global
+         * @return uint64_t Distinto para cada entorno global creado en el
+         *         proceso (0 en los entornos locales)
+         *
+         * A diferencia de la dirección, no se repite cuando un entorno nuevo
+         * ocupa la memoria de uno ya destruido.
+         */
+        uint64_t getSerial() const { return serial; }
+
+    protected:
+        size_t references() const override;
+        void traverse(Tracer& tracer) const override;
+        void pin(Pins& pins) override;
+        void clear() override;
+
     private:
-        std::unordered_map<std::string, Value> values;  ///< Variables del entorno actual
-        std::shared_ptr<Environment> enclosing;         ///< Entorno padre
+        NameMap<Value> values;                          ///< Variables por nombre (entorno global)
+        std::vector<Value> ownedSlots;                  ///< Ranuras propias (entornos en el heap)
+        Value* slots = nullptr;                         ///< Variables locales por ranura
+        Environment* enclosing = nullptr;               ///< Entorno padre
+        std::shared_ptr<Environment> owner;             ///< Mantiene vivo al padre (entornos en el heap)
+        uint64_t serial = 0;                            ///< Ver getSerial()
+        GlobalSource* source = nullptr;                 ///< Ver importFrom()
+
+        friend class Transfer;
     };
 }
 
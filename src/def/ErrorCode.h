@@ -62,15 +62,23 @@ namespace TokenTree {
         inline const ErrorType OperandsMustBeNumbers       {"OperandsMustBeNumbers",       70}; ///< Operandos deben ser numéricos
         inline const ErrorType ArgumentCountMismatch       {"ArgumentCountMismatch",       70}; ///< Número incorrecto de argumentos
         inline const ErrorType CallOnNonFunction           {"CallOnNonFunction",           70}; ///< Intento de llamar a no-función
+        inline const ErrorType IndexOnNonArray             {"IndexOnNonArray",             70}; ///< Indexación de un valor que no es un array
+        inline const ErrorType InvalidIndex                {"InvalidIndex",                70}; ///< Índice no entero o fuera del array
+        inline const ErrorType ArgumentTypeMismatch        {"ArgumentTypeMismatch",        70}; ///< Argumento de tipo incorrecto (nativas)
         inline const ErrorType RuntimeError                {"RuntimeError",                70}; ///< Error genérico de ejecución
         
+        // Ejecución detenida por un límite (--max-steps, --max-time, --max-memory) - Código 75
+        inline const ErrorType BudgetExceeded              {"BudgetExceeded",              75}; ///< Límite de pasos, tiempo o memoria superado
+
         // Errores de parsing (Parse Errors) - Código 65
         inline const ErrorType ParseError                  {"ParseError",                  65}; ///< Error de análisis sintáctico
+        inline const ErrorType CompileError                {"CompileError",                65}; ///< Programa excede los límites del bytecode
         
         // Códigos de salida estándar:
         // 0  - Éxito
         // 65 - Errores de análisis/sintaxis
         // 70 - Errores de tiempo de ejecución
+        // 75 - Límite de ejecución superado
     }
 }
 
@@ -0,0 +1,38 @@
+/**
+ * @file FrameArena.cpp
+ * @brief Implementación de la arena de ranuras del evaluador
+ * @author Javier
+ * @date 2025
+ */
+
+#include "FrameArena.h"
+
+#include <algorithm>
+
+namespace TokenTree {
+    FrameArena::Frame::Frame(FrameArena& arena, size_t count)
+        : arena(arena), count(count), chunk(arena.current), top(arena.top) {
+        auto& chunks = arena.chunks;
+        if (chunks.empty() || arena.top + count > chunks[arena.current].capacity) {
+            // El marco no cabe en el bloque activo: se pasa al siguiente (o a uno nuevo)
+            size_t next = chunks.empty() ? 0 : arena.current + 1;
+            if (next == chunks.size() || chunks[next].capacity < count) {
+                size_t capacity = std::max(CHUNK_SIZE, count);
+                chunks.insert(chunks.begin() + static_cast<std::ptrdiff_t>(next),
+                              Chunk{std::make_unique<Value[]>(capacity), capacity});
+            }
+            arena.current = next;
+            arena.top = 0;
+        }
+        data = chunks[arena.current].data.get() + arena.top;
+        arena.top += count;
+        std::fill(data, data + count, Value(Undefined{}));
+    }
+
+    FrameArena::Frame::~Frame() {
+        // Soltar los valores ahora (cadenas, funciones) y no al reutilizar la ranura
+        std::fill(data, data + count, Value());
+        arena.current = chunk;
+        arena.top = top;
+    }
+}
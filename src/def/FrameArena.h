@@ -0,0 +1,87 @@
+/**
+ * @file FrameArena.h
+ * @brief Memoria de pila para las ranuras de entornos que no escapan
+ * @author Javier
+ * @date 2025
+ *
+ * Este archivo define el asignador por bloques que usa el evaluador para
+ * los entornos de bloques y llamadas que ninguna closure puede capturar.
+ * Las ranuras se reservan y liberan en orden LIFO, sin pasar por el heap
+ * una vez que los bloques de memoria ya existen.
+ */
+
+#ifndef FRAMEARENA_H
+#define FRAMEARENA_H
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "Environment.h"
+
+namespace TokenTree {
+    /**
+     * @class FrameArena
+     * @brief Pila de ranuras (Value) organizada en bloques que nunca se mueven
+     *
+     * Los punteros devueltos siguen siendo válidos mientras el marco esté
+     * abierto, aunque se reserven marcos nuevos encima: al agotarse un
+     * bloque se continúa en el siguiente en lugar de realocar.
+     */
+    class FrameArena {
+    public:
+        using Value = Environment::Value;
+
+        /**
+         * @class Frame
+         * @brief Reserva RAII de ranuras en la arena
+         *
+         * Al destruirse (también durante la propagación de una excepción)
+         * limpia sus ranuras y las devuelve a la arena.
+         */
+        class Frame {
+        public:
+            /**
+             * @brief Reserva ranuras inicializadas a Undefined
+             * @param arena Arena de la que se reserva
+             * @param count Número de ranuras
+             */
+            Frame(FrameArena& arena, size_t count);
+            ~Frame();
+
+            Frame(const Frame&) = delete;
+            Frame& operator=(const Frame&) = delete;
+
+            /**
+             * @brief Obtiene la primera ranura reservada
+             * @return Value* Ranuras contiguas del marco
+             */
+            Value* slots() const { return data; }
+
+        private:
+            FrameArena& arena;  ///< Arena propietaria
+            Value* data;        ///< Ranuras reservadas
+            size_t count;       ///< Número de ranuras
+            size_t chunk;       ///< Bloque activo antes de reservar
+            size_t top;         ///< Posición libre antes de reservar
+        };
+
+    private:
+        static constexpr size_t CHUNK_SIZE = 4096; ///< Ranuras por bloque
+
+        /**
+         * @struct Chunk
+         * @brief Bloque contiguo de ranuras
+         */
+        struct Chunk {
+            std::unique_ptr<Value[]> data; ///< Ranuras del bloque
+            size_t capacity;               ///< Tamaño del bloque
+        };
+
+        std::vector<Chunk> chunks; ///< Bloques reservados (se reutilizan)
+        size_t current = 0;        ///< Bloque activo
+        size_t top = 0;            ///< Primera ranura libre del bloque activo
+    };
+}
+
+#endif // FRAMEARENA_H
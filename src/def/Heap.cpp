@@ -0,0 +1,149 @@
+/**
+ * @file Heap.cpp
+ * @brief Implementación del recolector de ciclos
+ * @author Javier
+ * @date 2025
+ *
+ * La recolección sigue el esquema de borrado de prueba: primero cuenta,
+ * para cada contenedor, las referencias que no vienen de otros
+ * contenedores; después marca lo alcanzable desde los que tienen alguna,
+ * y finalmente rompe los ciclos del resto.
+ */
+
+#include "Heap.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <utility>
+
+#include "Context.h"
+
+namespace TokenTree {
+    Collectable::~Collectable() {
+        if (heap) heap->remove(this);
+    }
+
+    void Collectable::track(Type type) {
+        this->type = type;
+        Heap::current().add(this);
+    }
+
+    Heap::~Heap() {
+        // Los que sobreviven (referenciados desde fuera del Context) dejan de estar registrados
+        for (Collectable* object : tracked) object->heap = nullptr;
+    }
+
+    Heap& Heap::current() {
+        return Context::current().heap;
+    }
+
+    void Heap::add(Collectable* object) {
+        object->heap = this;
+        object->index = tracked.size();
+        tracked.push_back(object);
+        ++counters.live[static_cast<size_t>(object->type)];
+        ++counters.allocated;
+        counters.peak = std::max(counters.peak, tracked.size());
+        ++sinceCollection;
+    }
+
+    void Heap::remove(Collectable* object) {
+        Collectable* last = tracked.back();
+        tracked[object->index] = last;
+        last->index = object->index;
+        tracked.pop_back();
+        --counters.live[static_cast<size_t>(object->type)];
+        object->heap = nullptr;
+    }
+
+    size_t Heap::collect() {
+        if (collecting) return 0;
+        collecting = true;
+        auto start = std::chrono::steady_clock::now();
+        const size_t count = tracked.size();
+
+        // 1. Referencias de cada contenedor que no vienen de otro contenedor
+        std::vector<int64_t> external(count);
+        for (size_t i = 0; i < count; ++i) external[i] = static_cast<int64_t>(tracked[i]->references());
+        struct Subtract final : Collectable::Tracer {
+            Heap* heap;
+            std::vector<int64_t>& external;
+            Subtract(Heap* heap, std::vector<int64_t>& external) : heap(heap), external(external) {}
+            using Tracer::visit;
+            void visit(Collectable* target) override {
+                if (target->heap == heap) --external[target->index];
+            }
+        } subtract(this, external);
+        for (Collectable* object : tracked) object->traverse(subtract);
+
+        // 2. Lo alcanzable desde los referenciados desde fuera sigue vivo
+        struct Mark final : Collectable::Tracer {
+            Heap* heap;
+            std::vector<uint8_t> reachable;
+            std::vector<Collectable*> pending;
+            Mark(Heap* heap, size_t count) : heap(heap), reachable(count, 0) {}
+            using Tracer::visit;
+            void visit(Collectable* target) override {
+                if (target->heap == heap && !reachable[target->index]) {
+                    reachable[target->index] = 1;
+                    pending.push_back(target);
+                }
+            }
+        } mark(this, count);
+        for (size_t i = 0; i < count; ++i) {
+            // Un resultado negativo indicaría referencias mal informadas: se trata como raíz
+            if (external[i] != 0) mark.visit(tracked[i]);
+            while (!mark.pending.empty()) {
+                Collectable* object = mark.pending.back();
+                mark.pending.pop_back();
+                object->traverse(mark);
+            }
+        }
+
+        // 3. El resto solo se mantiene por ciclos: se sujeta mientras se
+        //    sueltan sus referencias y se libera al soltar los pins
+        Collectable::Pins pins;
+        std::vector<Collectable*> garbage;
+        for (size_t i = 0; i < count; ++i) {
+            if (mark.reachable[i]) continue;
+            garbage.push_back(tracked[i]);
+            tracked[i]->pin(pins);
+        }
+        for (Collectable* object : garbage) object->clear();
+        pins = {};
+
+        counters.collected += garbage.size();
+        ++counters.collections;
+        counters.nanoseconds += static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count());
+        schedule();
+        collecting = false;
+        return garbage.size();
+    }
+
+    void Heap::setThresholds(size_t threshold, unsigned growth) {
+        this->threshold = threshold;
+        this->growth = growth;
+        schedule();
+    }
+
+    void Heap::schedule() {
+        sinceCollection = 0;
+        nextCollection = std::max(threshold, tracked.size() * growth / 100);
+    }
+
+    void Heap::report(std::ostream& out, size_t strings) const {
+        const auto& live = counters.live;
+        auto count = [&](Collectable::Type type) { return live[static_cast<size_t>(type)]; };
+        size_t total = tracked.size();
+        char milliseconds[32];
+        std::snprintf(milliseconds, sizeof(milliseconds), "%.3f", static_cast<double>(counters.nanoseconds) / 1e6);
+        out << "Heap: " << total << " live (" << count(Collectable::Type::Environment) << " environments, "
+            << count(Collectable::Type::Function) << " functions, " << count(Collectable::Type::Closure) << " closures, "
+            << count(Collectable::Type::Upvalue) << " upvalues, " << count(Collectable::Type::Array)
+            << " arrays), peak " << counters.peak << "\n";
+        out << "  " << counters.allocated << " allocated, " << counters.collections << " collections freed "
+            << counters.collected << " in cycles (" << milliseconds << " ms), " << strings << " interned strings\n";
+    }
+}
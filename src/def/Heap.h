@@ -0,0 +1,219 @@
+/**
+ * @file Heap.h
+ * @brief Recolector de ciclos para entornos, funciones, closures y arrays
+ * @author Javier
+ * @date 2025
+ *
+ * Este archivo define Heap, el registro de los objetos que pueden formar
+ * ciclos de referencias: los entornos del heap, las funciones del
+ * evaluador (que guardan el entorno en el que se declararon), las
+ * closures y upvalues de la VM y los arrays. El contador de referencias libera todo lo
+ * demás en cuanto deja de usarse; una función declarada dentro de un
+ * bloque, en cambio, vive en una ranura del entorno que ella misma
+ * mantiene vivo, y sin el recolector ese entorno no se liberaría nunca.
+ *
+ * El recolector no necesita conocer las raíces (la pila de C++, la de la
+ * VM, la FrameArena...): al restar a cada contenedor las referencias que
+ * recibe de otros contenedores, los que aún tienen alguna son referenciados
+ * desde fuera. Todo lo alcanzable desde ellos sigue vivo, y el resto solo
+ * se mantiene por ciclos: se rompen soltando sus referencias y el
+ * contador termina de liberarlo.
+ */
+
+#ifndef HEAP_H
+#define HEAP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <vector>
+
+#include "Value.h"
+
+namespace TokenTree {
+    class Heap;
+
+    /**
+     * @class Collectable
+     * @brief Contenedor de referencias registrado en un Heap
+     *
+     * Las clases derivadas se registran con track() al construirse y
+     * describen sus referencias fuertes con traverse(). Cada referencia que
+     * traverse() informa debe ser exactamente una de las que cuenta
+     * references().
+     */
+    class Collectable {
+    public:
+        /**
+         * @enum Type
+         * @brief Tipo de contenedor (para las estadísticas)
+         *
+         * No se llama Kind para no chocar con Object::Kind en las clases que
+         * derivan de las dos.
+         */
+        enum class Type : uint8_t {
+            Environment, ///< Entorno del evaluador en el heap
+            Function,    ///< Función del evaluador (Evaluator::LoxFunction)
+            Closure,     ///< Closure de la VM
+            Upvalue,     ///< Variable capturada por una closure de la VM
+            Array        ///< Array (ArrayObject)
+        };
+        static constexpr size_t TYPE_COUNT = 5;
+
+        /**
+         * @class Tracer
+         * @brief Recibe las referencias de un contenedor durante una recolección
+         */
+        class Tracer {
+        public:
+            virtual void visit(Collectable* target) = 0;
+
+            /// Informa de la referencia de un valor (solo cuenta si es un contenedor)
+            void visit(const Value& value) {
+                if (value.isObject()) {
+                    if (Collectable* target = value.asObject()->collectable()) visit(target);
+                }
+            }
+
+        protected:
+            ~Tracer() = default;
+        };
+
+        /**
+         * @struct Pins
+         * @brief Referencias temporales que mantienen vivos los contenedores mientras se rompen sus ciclos
+         */
+        struct Pins {
+            std::vector<Value> objects;                      ///< Objetos referenciados por Value
+            std::vector<std::shared_ptr<const void>> shared; ///< Objetos referenciados por std::shared_ptr
+        };
+
+        Collectable(const Collectable&) = delete;
+        Collectable& operator=(const Collectable&) = delete;
+
+    protected:
+        Collectable() = default;
+        virtual ~Collectable();
+
+        /**
+         * @brief Registra el contenedor en el Heap del Context actual
+         * @param type Tipo de contenedor
+         *
+         * Debe llamarse desde el constructor de la clase derivada; antes de
+         * la siguiente recolección el objeto tiene que estar completo.
+         */
+        void track(Type type);
+
+        /// @return size_t Referencias fuertes que recibe ahora (Value, Ref o std::shared_ptr)
+        virtual size_t references() const = 0;
+        /// @brief Informa al tracer de cada referencia fuerte que el contenedor tiene
+        virtual void traverse(Tracer& tracer) const = 0;
+        /// @brief Añade a pins una referencia que mantenga vivo el contenedor
+        virtual void pin(Pins& pins) = 0;
+        /// @brief Suelta todas sus referencias (solo se llama sobre basura)
+        virtual void clear() = 0;
+
+    private:
+        friend class Heap;
+
+        Heap* heap = nullptr;          ///< Heap en el que está registrado (nullptr si no lo está)
+        size_t index = 0;              ///< Posición en el registro del heap
+        Type type = Type::Environment; ///< Tipo de contenedor
+    };
+
+    /**
+     * @struct HeapStats
+     * @brief Estadísticas acumuladas de un Heap
+     */
+    struct HeapStats {
+        size_t live[Collectable::TYPE_COUNT] = {};  ///< Contenedores vivos, por tipo
+        size_t peak = 0;                            ///< Máximo de contenedores vivos a la vez
+        uint64_t allocated = 0;                     ///< Contenedores registrados en total
+        uint64_t collections = 0;                   ///< Recolecciones ejecutadas
+        uint64_t collected = 0;                     ///< Contenedores liberados al romper ciclos
+        uint64_t nanoseconds = 0;                   ///< Tiempo total de las recolecciones
+    };
+
+    /**
+     * @class Heap
+     * @brief Registro de contenedores y recolector de ciclos de un intérprete
+     *
+     * Cada Context tiene el suyo. La recolección automática se comprueba en
+     * puntos seguros (al crear funciones, closures y arrays) con poll(): se ejecuta
+     * cuando desde la anterior se han registrado al menos
+     * max(threshold, supervivientes * growth / 100) contenedores nuevos, de
+     * modo que su coste total es proporcional a lo que se reserva.
+     */
+    class Heap {
+    public:
+        /// Contenedores nuevos que, como mínimo, separan dos recolecciones automáticas
+        static constexpr size_t DEFAULT_THRESHOLD = 10000;
+        /// Porcentaje de los supervivientes que debe reservarse antes de volver a recolectar
+        static constexpr unsigned DEFAULT_GROWTH = 100;
+
+        Heap() = default;
+        ~Heap();
+        Heap(const Heap&) = delete;
+        Heap& operator=(const Heap&) = delete;
+
+        /**
+         * @brief Obtiene el Heap del Context del hilo actual
+         * @return Heap& Heap en el que se registran los contenedores nuevos
+         */
+        static Heap& current();
+
+        /**
+         * @brief Recolecta si se ha alcanzado el umbral
+         *
+         * Solo debe llamarse cuando todos los contenedores estén completos y
+         * cada referencia que los mantiene vivos esté contada.
+         */
+        void poll() {
+            if (threshold != 0 && sinceCollection >= nextCollection) collect();
+        }
+
+        /**
+         * @brief Libera todos los contenedores que solo se mantienen por ciclos
+         * @return size_t Número de contenedores liberados
+         */
+        size_t collect();
+
+        /**
+         * @brief Cambia los umbrales de la recolección automática
+         * @param threshold Contenedores nuevos mínimos entre recolecciones (0 = solo collect())
+         * @param growth Porcentaje de los supervivientes que debe reservarse antes de recolectar
+         */
+        void setThresholds(size_t threshold, unsigned growth = DEFAULT_GROWTH);
+
+        /**
+         * @brief Obtiene las estadísticas acumuladas
+         * @return const HeapStats& Contenedores vivos y trabajo del recolector
+         */
+        const HeapStats& stats() const { return counters; }
+
+        /**
+         * @brief Escribe un resumen legible de las estadísticas
+         * @param out Flujo de salida
+         * @param strings Cadenas internadas en la tabla del intérprete
+         */
+        void report(std::ostream& out, size_t strings) const;
+
+    private:
+        friend class Collectable;
+
+        std::vector<Collectable*> tracked;            ///< Contenedores registrados
+        HeapStats counters;                           ///< Ver stats()
+        size_t threshold = DEFAULT_THRESHOLD;         ///< Ver setThresholds()
+        unsigned growth = DEFAULT_GROWTH;             ///< Ver setThresholds()
+        size_t sinceCollection = 0;                   ///< Registrados desde la última recolección
+        size_t nextCollection = DEFAULT_THRESHOLD;    ///< Registros que disparan la siguiente
+        bool collecting = false;                      ///< Evita recolecciones anidadas
+
+        void add(Collectable* object);
+        void remove(Collectable* object);
+        void schedule();
+    };
+}
+
+#endif // HEAP_H
@@ -16,6 +16,11 @@
 
 #include "Keywords.h"
 
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <utility>
+
 // Definición de constantes para palabras clave del lenguaje Setker
 // Utilizamos string_view para evitar copias innecesarias y mejorar rendimiento
 static constexpr std::string_view AND = "and";      ///< Operador lógico AND
@@ -29,6 +34,94 @@ static constexpr std::string_view THIS = "this";    ///< Referencia a instancia
 static constexpr std::string_view TRUE = "true";    ///< Literal booleano verdadero
 static constexpr std::string_view FUN = "fun";      ///< Declaración de función
 
+// Todas las palabras reservadas con su token
+static constexpr std::array<std::pair<std::string_view, TokenType>, 16> KEYWORDS = {{
+    {AND, TokenType::AND},       {OR, TokenType::OR},
+    {CLASS, TokenType::CLASS},   {FUN, TokenType::FUN},
+    {Keywords::VAR, TokenType::VAR},
+    {Keywords::IF, TokenType::IF},       {Keywords::ELSE, TokenType::ELSE},
+    {Keywords::FOR, TokenType::FOR},     {Keywords::WHILE, TokenType::WHILE},
+    {Keywords::RETURN, TokenType::RETURN},
+    {TRUE, TokenType::TRUE},     {FALSE, TokenType::FALSE},
+    {NIL, TokenType::NIL},       {THIS, TokenType::THIS},
+    {SUPER, TokenType::SUPER},   {PRINT, TokenType::PRINT},
+}};
+
+static constexpr unsigned TABLE_BITS = 5;                  ///< Tabla de 32 huecos
+static constexpr size_t TABLE_SIZE = size_t{1} << TABLE_BITS;
+
+/**
+ * @brief Empaqueta la primera, la segunda y la última letra y la longitud
+ * @param word Palabra no vacía
+ * @return uint32_t Clave de la palabra (nunca 0)
+ *
+ * Es barata de calcular y distinta para cada palabra clave, así que cada
+ * palabra tiene un único hueco candidato en TABLE.
+ */
+static constexpr uint32_t keyOf(std::string_view word) {
+    // En una palabra de una sola letra la "segunda" es la propia primera
+    return static_cast<uint32_t>(static_cast<uint8_t>(word[0])) |
+           static_cast<uint32_t>(static_cast<uint8_t>(word[word.size() > 1])) << 8 |
+           static_cast<uint32_t>(static_cast<uint8_t>(word.back())) << 16 |
+           static_cast<uint32_t>(std::min<size_t>(word.size(), 0xFF)) << 24;
+}
+
+/**
+ * @brief Hash multiplicativo de una clave
+ * @param key Clave (keyOf)
+ * @param seed Multiplicador
+ * @return size_t Hueco de la tabla
+ */
+static constexpr size_t slotOf(uint32_t key, uint32_t seed) {
+    return (key * seed) >> (32 - TABLE_BITS);
+}
+
+/**
+ * @brief Busca en compilación un multiplicador sin colisiones
+ * @return uint32_t Primer multiplicador impar que da un hueco distinto a cada palabra (0 si no hay)
+ */
+static constexpr uint32_t findSeed() {
+    for (uint32_t seed = 1; seed < (1u << 20); seed += 2) {
+        std::array<bool, TABLE_SIZE> used{};
+        bool perfect = true;
+        for (const auto& [word, type] : KEYWORDS) {
+            size_t slot = slotOf(keyOf(word), seed);
+            if (used[slot]) {
+                perfect = false;
+                break;
+            }
+            used[slot] = true;
+        }
+        if (perfect) return seed;
+    }
+    return 0;
+}
+
+static constexpr uint32_t SEED = findSeed();
+static_assert(SEED != 0, "No se encontró un hash perfecto para las palabras clave");
+
+/**
+ * @struct Slot
+ * @brief Hueco de la tabla de palabras clave
+ */
+struct Slot {
+    uint32_t key = 0;                           ///< keyOf(word), 0 si el hueco está vacío
+    std::string_view word;                      ///< Palabra clave
+    TokenType type = TokenType::IDENTIFIER;     ///< Token de la palabra
+};
+
+/// Tabla indexada por slotOf: cada palabra clave en su hueco, el resto vacío
+static constexpr auto TABLE = [] {
+    std::array<Slot, TABLE_SIZE> table{};
+    for (const auto& [word, type] : KEYWORDS) {
+        Slot& slot = table[slotOf(keyOf(word), SEED)];
+        slot.key = keyOf(word);
+        slot.word = word;
+        slot.type = type;
+    }
+    return table;
+}();
+
 /**
  * @brief Evalúa si una cadena corresponde a una palabra clave del lenguaje
  * 
@@ -49,38 +142,15 @@ static constexpr std::string_view FUN = "fun";      ///< Declaración de funció
  *         - Tipo específico si es una palabra clave reconocida
  *         - TokenType::IDENTIFIER si no es una palabra clave
  * 
- * @note La función utiliza comparaciones de string eficientes con string_view
+ * @note La búsqueda usa un hash perfecto calculado en compilación (TABLE)
  * @note Es case-sensitive: solo reconoce palabras clave en minúsculas
  */
-TokenType Keywords::valorateKeyword(std::string keyword) {
-    // Operadores lógicos
-    if (keyword == AND) return TokenType::AND;
-    if (keyword == OR) return TokenType::OR;
-    
-    // Declaraciones de estructura
-    if (keyword == CLASS) return TokenType::CLASS;
-    if (keyword == FUN) return TokenType::FUN;
-    if (keyword == VAR) return TokenType::VAR;
-    
-    // Control de flujo
-    if (keyword == IF) return TokenType::IF;
-    if (keyword == ELSE) return TokenType::ELSE;
-    if (keyword == FOR) return TokenType::FOR;
-    if (keyword == WHILE) return TokenType::WHILE;
-    if (keyword == RETURN) return TokenType::RETURN;
-    
-    // Literales y valores especiales
-    if (keyword == TRUE) return TokenType::TRUE;
-    if (keyword == FALSE) return TokenType::FALSE;
-    if (keyword == NIL) return TokenType::NIL;
-    
-    // Referencias de objeto
-    if (keyword == THIS) return TokenType::THIS;
-    if (keyword == SUPER) return TokenType::SUPER;
-    
-    // Funciones built-in
-    if (keyword == PRINT) return TokenType::PRINT;
-    
-    // Si no es una palabra clave, es un identificador
-    return TokenType::IDENTIFIER;
+TokenType Keywords::valorateKeyword(std::string_view keyword) {
+    // Hash perfecto: un único hueco candidato. Las longitudes imposibles no
+    // se descartan aparte: su clave nunca coincide con la de ningún hueco
+    if (keyword.empty()) return TokenType::IDENTIFIER;
+    uint32_t key = keyOf(keyword);
+    const Slot& slot = TABLE[slotOf(key, SEED)];
+    // Los huecos vacíos tienen clave 0, que ninguna palabra produce
+    return slot.key == key && slot.word == keyword ? slot.type : TokenType::IDENTIFIER;
 }
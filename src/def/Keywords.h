@@ -48,7 +48,7 @@ public:
      * entre identificadores definidos por el usuario y palabras
      * reservadas del lenguaje.
      */
-    static TokenType valorateKeyword(std::string keyword);
+    static TokenType valorateKeyword(std::string_view keyword);
 };
 
 #endif //KEWYORDS_H
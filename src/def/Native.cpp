@@ -0,0 +1,212 @@
+/**
+ * @file Native.cpp
+ * @brief Implementación y registro de las funciones nativas
+ * @author Javier
+ * @date 2025
+ */
+
+#include "Native.h"
+
+#include <chrono>
+#include <string>
+
+#include "Array.h"
+#include "Context.h"
+#include "ErrorCode.h"
+#include "Workers.h"
+
+namespace TokenTree {
+    namespace {
+        /**
+         * @brief clock(): segundos transcurridos, con resolución de reloj monótono
+         * @return Value Segundos (con decimales) desde un origen fijo
+         *
+         * Usa steady_clock, así que la diferencia entre dos llamadas mide
+         * tiempos por debajo del milisegundo y no salta si se ajusta la hora.
+         */
+        Value clock(const Value*) {
+            auto now = std::chrono::steady_clock::now().time_since_epoch();
+            return std::chrono::duration<double>(now).count();
+        }
+
+        /**
+         * @brief Comprueba que un argumento sea un array
+         * @param value Argumento
+         * @param native Nombre de la nativa, para el mensaje de error
+         * @return ArrayObject* El array (sin transferir la referencia)
+         * @throws Error ArgumentTypeMismatch si no lo es
+         */
+        ArrayObject* arrayArgument(const Value& value, const char* native) {
+            if (!value.isObject(Object::Kind::Array)) {
+                throw Error(ErrorCodes::ArgumentTypeMismatch, std::string("First argument to ") + native + "() must be an array.");
+            }
+            return value.as<ArrayObject>();
+        }
+
+        /**
+         * @brief Comprueba que un array solo contenga números
+         * @throws Error ArgumentTypeMismatch si algún elemento no lo es
+         */
+        void requireNumbers(const ArrayObject* array, const char* native) {
+            if (array->isNumeric()) return;
+            const Value* values = array->valueData();
+            for (size_t i = 0; i < array->size(); ++i) {
+                if (!values[i].isNumber()) {
+                    throw Error(ErrorCodes::ArgumentTypeMismatch, std::string(native) + "() expects an array of numbers.");
+                }
+            }
+        }
+
+        /**
+         * @brief len(x): elementos de un array o caracteres de una cadena
+         */
+        Value len(const Value* args) {
+            if (args[0].isString()) return static_cast<double>(args[0].asString().size());
+            if (!args[0].isObject(Object::Kind::Array)) {
+                throw Error(ErrorCodes::ArgumentTypeMismatch, "Argument to len() must be an array or a string.");
+            }
+            return static_cast<double>(args[0].as<ArrayObject>()->size());
+        }
+
+        /**
+         * @brief push(a, v): añade v al final de a
+         * @return Value Nueva longitud del array
+         */
+        Value push(const Value* args) {
+            ArrayObject* array = arrayArgument(args[0], "push");
+            array->push(args[1]);
+            return static_cast<double>(array->size());
+        }
+
+        /**
+         * @brief Suma los elementos en cuatro acumuladores independientes
+         * @tparam Get Función que devuelve el elemento i como double
+         *
+         * Los acumuladores no dependen unos de otros, así que el compilador
+         * puede sumarlos con una sola instrucción SIMD. Los arrays numéricos
+         * y los que no lo son suman en el mismo orden y dan el mismo
+         * resultado.
+         */
+        template <class Get>
+        double sumOf(size_t count, Get get) {
+            double lanes[4] = {0, 0, 0, 0};
+            size_t i = 0;
+            for (; i + 4 <= count; i += 4) {
+                for (size_t lane = 0; lane < 4; ++lane) lanes[lane] += get(i + lane);
+            }
+            double total = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+            for (; i < count; ++i) total += get(i);
+            return total;
+        }
+
+        /**
+         * @brief sum(a): suma de un array de números
+         */
+        Value sum(const Value* args) {
+            const ArrayObject* array = arrayArgument(args[0], "sum");
+            requireNumbers(array, "sum");
+            if (array->isNumeric()) {
+                const double* numbers = array->numberData();
+                return sumOf(array->size(), [numbers](size_t i) { return numbers[i]; });
+            }
+            const Value* values = array->valueData();
+            return sumOf(array->size(), [values](size_t i) { return values[i].asNumber(); });
+        }
+
+        /**
+         * @brief fill(a, v): sustituye todos los elementos de a por v
+         * @return Value El propio array
+         */
+        Value fill(const Value* args) {
+            arrayArgument(args[0], "fill")->fill(args[1]);
+            return args[0];
+        }
+
+        /**
+         * @brief Aplica una operación con un número a cada elemento de un array
+         * @param args Array de números y número
+         * @param native Nombre de la nativa, para los mensajes de error
+         * @param op Operación (elemento, número) -> resultado
+         * @return Value Array nuevo con los resultados (numérico)
+         */
+        template <class Op>
+        Value mapNumbers(const Value* args, const char* native, Op op) {
+            const ArrayObject* source = arrayArgument(args[0], native);
+            if (!args[1].isNumber()) {
+                throw Error(ErrorCodes::ArgumentTypeMismatch, std::string("Second argument to ") + native + "() must be a number.");
+            }
+            requireNumbers(source, native);
+            const double k = args[1].asNumber();
+            const size_t count = source->size();
+            auto result = makeRef<ArrayObject>(count);
+            double* out = result->numberData();
+            if (source->isNumeric()) {
+                // Bucle sin dependencias ni saltos: se vectoriza
+                const double* in = source->numberData();
+                for (size_t i = 0; i < count; ++i) out[i] = op(in[i], k);
+            } else {
+                const Value* in = source->valueData();
+                for (size_t i = 0; i < count; ++i) out[i] = op(in[i].asNumber(), k);
+            }
+            return result;
+        }
+
+        /**
+         * @brief scale(a, k): array nuevo con cada elemento de a multiplicado por k
+         */
+        Value scale(const Value* args) {
+            return mapNumbers(args, "scale", [](double x, double k) { return x * k; });
+        }
+
+        /**
+         * @brief offset(a, k): array nuevo con k sumado a cada elemento de a
+         */
+        Value offset(const Value* args) {
+            return mapNumbers(args, "offset", [](double x, double k) { return x + k; });
+        }
+
+        /**
+         * @brief parallel_map(f, a): array nuevo con f(x) para cada elemento x de a
+         *
+         * Las llamadas se reparten entre varios hilos (Context::workers) y
+         * cada uno trabaja con copias de f, de los elementos y de las
+         * globales que lee (ver mapInParallel).
+         */
+        Value parallelMap(const Value* args) {
+            if (args[0].isObject(Object::Kind::Closure)) {
+                throw Error(ErrorCodes::ArgumentTypeMismatch, "parallel_map() is not available in the VM.");
+            }
+            if (!args[0].isObject(Object::Kind::Function) && !args[0].isObject(Object::Kind::Native)) {
+                throw Error(ErrorCodes::ArgumentTypeMismatch, "First argument to parallel_map() must be a function.");
+            }
+            if (!args[1].isObject(Object::Kind::Array)) {
+                throw Error(ErrorCodes::ArgumentTypeMismatch, "Second argument to parallel_map() must be an array.");
+            }
+            return mapInParallel(args[0], *args[1].as<ArrayObject>(), Context::current().workers);
+        }
+    }
+
+    Value NativeFunction::transfer(Transfer&) const {
+        return makeRef<NativeFunction>(name, arity, fn);
+    }
+
+    Value NativeFunction::call(const Value* args, size_t count) const {
+        if (count != arity) {
+            throw Error(ErrorCodes::ArgumentCountMismatch, "Expected " + std::to_string(arity) + " args but got " + std::to_string(count) + ".");
+        }
+        return fn(args);
+    }
+
+    std::vector<Ref<NativeFunction>> makeNatives() {
+        return {
+            makeRef<NativeFunction>("clock", 0, clock),
+            makeRef<NativeFunction>("len", 1, len),
+            makeRef<NativeFunction>("push", 2, push),
+            makeRef<NativeFunction>("sum", 1, sum),
+            makeRef<NativeFunction>("fill", 2, fill),
+            makeRef<NativeFunction>("scale", 2, scale),
+            makeRef<NativeFunction>("offset", 2, offset),
+            makeRef<NativeFunction>("parallel_map", 2, parallelMap),
+        };
+    }
+}
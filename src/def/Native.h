@@ -0,0 +1,71 @@
+/**
+ * @file Native.h
+ * @brief Funciones nativas de Setker (implementadas en C++)
+ * @author Javier
+ * @date 2025
+ *
+ * Este archivo define el tipo de las funciones nativas y el registro con
+ * el que el evaluador y la máquina virtual las instalan como variables
+ * globales al arrancar. Para añadir una nativa basta con escribir su
+ * función y añadirla a la tabla de Native.cpp.
+ */
+
+#ifndef NATIVE_H
+#define NATIVE_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "Value.h"
+
+namespace TokenTree {
+    /**
+     * @struct NativeFunction
+     * @brief Función del lenguaje implementada en C++
+     *
+     * Se invoca directamente con los argumentos ya evaluados, sin crear
+     * entorno ni marco de llamada.
+     */
+    struct NativeFunction : Object {
+        /// Aridad máxima de una nativa (tamaño del búfer de argumentos del evaluador)
+        static constexpr size_t MAX_ARITY = 8;
+
+        /**
+         * @typedef Fn
+         * @brief Implementación: recibe exactamente arity argumentos
+         */
+        using Fn = Value (*)(const Value* args);
+
+        const std::string name; ///< Nombre de la global (y de "<native fn>")
+        const size_t arity;     ///< Número de argumentos
+        const Fn fn;            ///< Implementación
+
+        /**
+         * @brief Constructor de NativeFunction
+         * @param name Nombre con el que se registra
+         * @param arity Número de argumentos (como mucho MAX_ARITY)
+         * @param fn Implementación
+         */
+        NativeFunction(std::string name, size_t arity, Fn fn)
+            : Object(Kind::Native), name(std::move(name)), arity(arity), fn(fn) {}
+
+        /// Copia: otra nativa con la misma implementación (no guardan estado)
+        Value transfer(Transfer& transfer) const override;
+
+        /// Llama a fn tras comprobar el número de argumentos
+        Value call(const Value* args, size_t count) const override;
+    };
+
+    /**
+     * @brief Crea todas las funciones nativas
+     * @return std::vector<Ref<NativeFunction>> Objetos nuevos, propios de quien los pide
+     *
+     * Cada motor las define como globales con su nombre; un programa puede
+     * redefinirlas con var o fun como cualquier otra global. Cada intérprete
+     * crea las suyas para no compartir contadores de referencias entre hilos.
+     */
+    std::vector<Ref<NativeFunction>> makeNatives();
+}
+
+#endif // NATIVE_H
@@ -0,0 +1,56 @@
+/**
+ * @file Output.cpp
+ * @brief Implementación de la salida con búfer
+ * @author Javier
+ * @date 2025
+ */
+
+#include "Output.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#define SETKER_ISATTY(file) isatty(fileno(file))
+#elif defined(_WIN32)
+#include <io.h>
+#define SETKER_ISATTY(file) _isatty(_fileno(file))
+#else
+#define SETKER_ISATTY(file) 0
+#endif
+
+namespace TokenTree {
+    Output::Output(std::FILE* file)
+        : file(file), capacity(DEFAULT_CAPACITY), lineBuffered(file && SETKER_ISATTY(file) != 0) {
+        buffer.reserve(capacity);
+    }
+
+    Output::~Output() {
+        flush();
+    }
+
+    void Output::flush() {
+        // Sin archivo, el texto se queda en el búfer hasta take()
+        if (buffer.empty() || !file) return;
+        std::fwrite(buffer.data(), 1, buffer.size(), file);
+        std::fflush(file);
+        buffer.clear();
+    }
+
+    void Output::setFile(std::FILE* target) {
+        flush();
+        file = target;
+        lineBuffered = file && SETKER_ISATTY(file) != 0;
+    }
+
+    std::string Output::take() {
+        // Se copia para conservar la capacidad reservada del búfer
+        std::string text(buffer);
+        buffer.clear();
+        return text;
+    }
+
+    void Output::setCapacity(size_t bytes) {
+        flush();
+        capacity = bytes;
+        buffer.reserve(capacity);
+    }
+}
@@ -0,0 +1,108 @@
+/**
+ * @file Output.h
+ * @brief Salida con búfer para la instrucción print
+ * @author Javier
+ * @date 2025
+ *
+ * Este archivo define el escritor que usan el evaluador y la máquina
+ * virtual para print. En lugar de vaciar la salida en cada línea, junta
+ * el texto en un búfer y lo escribe de una vez, de modo que un programa
+ * que imprime un millón de líneas hace unas pocas llamadas al sistema.
+ */
+
+#ifndef OUTPUT_H
+#define OUTPUT_H
+
+#include <cstddef>
+#include <cstdio>
+#include <string>
+#include <string_view>
+
+namespace TokenTree {
+    /**
+     * @class Output
+     * @brief Búfer de salida sobre un FILE de C
+     *
+     * El búfer se vacía:
+     * - Cuando alcanza la capacidad configurada
+     * - Al final de cada línea si la salida es una terminal
+     * - Con flush(), que se llama antes de informar de un error (para que
+     *   la salida ya producida aparezca antes que el mensaje) y al salir
+     * - Al destruirse
+     */
+    class Output {
+    public:
+        /// Capacidad por defecto del búfer en bytes
+        static constexpr size_t DEFAULT_CAPACITY = 64 * 1024;
+
+        /**
+         * @brief Constructor de Output
+         * @param file Archivo de destino (abierto, sin transferir la propiedad),
+         *        o nullptr para guardar la salida en memoria hasta take()
+         */
+        explicit Output(std::FILE* file);
+        ~Output();
+
+        Output(const Output&) = delete;
+        Output& operator=(const Output&) = delete;
+
+        /**
+         * @brief Añade texto al búfer
+         * @param text Texto a escribir
+         * @return Output& El propio escritor
+         */
+        Output& operator<<(std::string_view text) {
+            buffer.append(text);
+            return *this;
+        }
+
+        /**
+         * @brief Añade un carácter al búfer
+         * @param c Carácter a escribir
+         * @return Output& El propio escritor
+         */
+        Output& operator<<(char c) {
+            buffer.push_back(c);
+            return *this;
+        }
+
+        /**
+         * @brief Termina una línea y vacía el búfer si toca
+         */
+        void endLine() {
+            buffer.push_back('\n');
+            if (lineBuffered || buffer.size() >= capacity) flush();
+        }
+
+        /**
+         * @brief Escribe en el archivo todo lo pendiente
+         */
+        void flush();
+
+        /**
+         * @brief Cambia la capacidad del búfer
+         * @param bytes Bytes a acumular antes de escribir (0 = escribir cada línea)
+         */
+        void setCapacity(size_t bytes);
+
+        /**
+         * @brief Cambia el archivo de destino (tras escribir lo pendiente en el anterior)
+         * @param target Archivo abierto, sin transferir la propiedad
+         */
+        void setFile(std::FILE* target);
+
+        /**
+         * @brief Obtiene la salida acumulada en memoria (sin archivo)
+         * @return std::string Texto escrito desde la última llamada
+         */
+        std::string take();
+
+    private:
+        std::FILE* file;     ///< Destino
+        std::string buffer;  ///< Texto pendiente de escribir
+        size_t capacity;     ///< Tamaño a partir del cual se vacía
+        bool lineBuffered;   ///< Vaciar en cada línea (la salida es una terminal)
+    };
+}
+
+#endif // OUTPUT_H
@@ -0,0 +1,217 @@
+/**
+ * @file Parallel.cpp
+ * @brief Implementación del reparto de tareas entre hilos
+ * @author Javier
+ * @date 2025
+ */
+
+#include "Parallel.h"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <thread>
+#include <vector>
+
+namespace TokenTree {
+    unsigned defaultThreads() {
+        return std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    void parallelFor(size_t count, unsigned threads, const std::function<void(size_t)>& task) {
+        if (threads == 0) threads = defaultThreads();
+        const size_t workers = std::min<size_t>(threads, count);
+
+        std::atomic<size_t> next{0};
+        std::exception_ptr failure;
+        std::mutex failureMutex;
+        auto work = [&] {
+            for (size_t i; (i = next.fetch_add(1, std::memory_order_relaxed)) < count;) {
+                try {
+                    task(i);
+                } catch (...) {
+                    // Se conserva la primera; las tareas restantes siguen ejecutándose
+                    std::lock_guard<std::mutex> lock(failureMutex);
+                    if (!failure) failure = std::current_exception();
+                }
+            }
+        };
+
+        std::vector<std::thread> pool;
+        pool.reserve(workers > 0 ? workers - 1 : 0);
+        for (size_t i = 1; i < workers; ++i) pool.emplace_back(work);
+        work();
+        for (auto& thread : pool) thread.join();
+        if (failure) std::rethrow_exception(failure);
+    }
+
+    std::vector<size_t> largestFirst(size_t count, const std::function<size_t(size_t)>& cost) {
+        std::vector<size_t> costs(count);
+        for (size_t i = 0; i < count; ++i) costs[i] = cost(i);
+        std::vector<size_t> order(count);
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return costs[a] > costs[b]; });
+        return order;
+    }
+
+    /**
+     * @struct WorkPool::Job
+     * @brief Tareas de una llamada a run() y su reparto entre los workers
+     */
+    struct WorkPool::Job {
+        /**
+         * @struct Range
+         * @brief Índices pendientes de un worker: [next, end)
+         *
+         * Cada tramo ocupa su propia línea de caché para que tomar una
+         * tarea del tramo propio no invalide el de los demás hilos.
+         */
+        struct alignas(64) Range {
+            std::mutex mutex;
+            size_t next = 0;
+            size_t end = 0;
+        };
+
+        const std::function<void(unsigned, size_t)>& task;
+        const unsigned workers;
+        std::unique_ptr<Range[]> ranges;
+        std::exception_ptr failure;
+        std::mutex failureMutex;
+
+        Job(size_t count, unsigned workers, const std::function<void(unsigned, size_t)>& task)
+            : task(task), workers(workers), ranges(new Range[workers]) {
+            for (unsigned i = 0; i < workers; ++i) {
+                ranges[i].next = count * i / workers;
+                ranges[i].end = count * (i + 1) / workers;
+            }
+        }
+
+        /**
+         * @brief Toma la siguiente tarea de un worker, robándola si hace falta
+         * @param worker Worker que la pide
+         * @param index Recibe el índice de la tarea
+         * @return bool false si ya no quedan tareas sin empezar en ningún tramo
+         */
+        bool take(unsigned worker, size_t& index) {
+            Range& own = ranges[worker];
+            {
+                std::lock_guard<std::mutex> lock(own.mutex);
+                if (own.next < own.end) {
+                    index = own.next++;
+                    return true;
+                }
+            }
+            // Tramo propio vacío: la mitad final del primero que tenga tareas, empezando por el siguiente
+            for (unsigned step = 1; step < workers; ++step) {
+                Range& victim = ranges[(worker + step) % workers];
+                size_t begin;
+                size_t end;
+                {
+                    std::lock_guard<std::mutex> lock(victim.mutex);
+                    const size_t left = victim.end - victim.next;
+                    if (left == 0) continue;
+                    end = victim.end;
+                    begin = end - (left + 1) / 2;
+                    victim.end = begin;
+                }
+                std::lock_guard<std::mutex> lock(own.mutex);
+                own.next = begin + 1;
+                own.end = end;
+                index = begin;
+                return true;
+            }
+            return false;
+        }
+
+        /**
+         * @brief Ejecuta tareas hasta que no quede ninguna
+         * @param worker Worker que las ejecuta
+         */
+        void work(unsigned worker) {
+            for (size_t index; take(worker, index);) {
+                try {
+                    task(worker, index);
+                } catch (...) {
+                    // Se conserva la primera; las tareas restantes siguen ejecutándose
+                    std::lock_guard<std::mutex> lock(failureMutex);
+                    if (!failure) failure = std::current_exception();
+                }
+            }
+        }
+    };
+
+    WorkPool::WorkPool(unsigned count) {
+        threads.reserve(count > 1 ? count - 1 : 0);
+        for (unsigned worker = 1; worker < count; ++worker) threads.emplace_back(&WorkPool::serve, this, worker);
+    }
+
+    WorkPool::~WorkPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto& thread : threads) thread.join();
+    }
+
+    WorkPool& WorkPool::shared() {
+        static WorkPool pool(defaultThreads());
+        return pool;
+    }
+
+    void WorkPool::run(size_t count, unsigned limit, const std::function<void(unsigned, size_t)>& task) {
+        if (count == 0) return;
+        const bool claimed = !busy.exchange(true, std::memory_order_acquire);
+        // Como en parallelFor, se pueden pedir más hilos que núcleos
+        if (claimed) {
+            for (unsigned worker = size(); worker < limit; ++worker) threads.emplace_back(&WorkPool::serve, this, worker);
+        }
+        const unsigned workers = static_cast<unsigned>(std::min<size_t>({limit ? limit : size(), size(), count}));
+        // Un solo hilo, o el pool ya ocupado: todo en el hilo que llama. También
+        // entonces se marca ocupado, para que las tareas no repartan su trabajo
+        if (workers == 1 || !claimed) {
+            Job alone(count, 1, task);
+            alone.work(0);
+            if (claimed) busy.store(false, std::memory_order_release);
+            if (alone.failure) std::rethrow_exception(alone.failure);
+            return;
+        }
+
+        Job current(count, workers, task);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            job = &current;
+            pending = workers - 1;
+            ++generation;
+        }
+        wake.notify_all();
+        current.work(0);
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            finished.wait(lock, [this] { return pending == 0; });
+            job = nullptr;
+        }
+        busy.store(false, std::memory_order_release);
+        if (current.failure) std::rethrow_exception(current.failure);
+    }
+
+    void WorkPool::serve(unsigned worker) {
+        uint64_t seen = 0;
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            wake.wait(lock, [&] { return stopping || generation != seen; });
+            if (stopping) return;
+            seen = generation;
+            Job* current = job;
+            // Los hilos que sobran para este trabajo (o que despiertan cuando ya terminó) vuelven a dormir
+            if (!current || worker >= current->workers) continue;
+            lock.unlock();
+            current->work(worker);
+            lock.lock();
+            if (--pending == 0) finished.notify_one();
+        }
+    }
+}
@@ -0,0 +1,125 @@
+/**
+ * @file Parallel.h
+ * @brief Reparto de tareas independientes entre varios hilos
+ * @author Javier
+ * @date 2025
+ *
+ * Este archivo define el bucle paralelo que usa el front end para
+ * tokenizar y parsear varios archivos a la vez y el pool de hilos
+ * permanentes en el que parallel_map ejecuta las funciones del programa.
+ * En los dos las tareas se reparten bajo demanda, de modo que una tarea
+ * grande no deja a los demás hilos esperando.
+ */
+
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace TokenTree {
+    /**
+     * @brief Número de hilos por defecto
+     * @return unsigned Núcleos disponibles (al menos 1)
+     */
+    unsigned defaultThreads();
+
+    /**
+     * @brief Ejecuta task(0) ... task(count - 1) repartidas entre varios hilos
+     * @param count Número de tareas
+     * @param threads Hilos como máximo, contando el que llama (0 = defaultThreads())
+     * @param task Tarea; no debe compartir estado mutable con las demás
+     * @throws Cualquier excepción de una tarea, una vez terminadas todas
+     *
+     * El hilo que llama también ejecuta tareas. Cada tarea empieza cuando
+     * un hilo queda libre, en orden de índice.
+     */
+    void parallelFor(size_t count, unsigned threads, const std::function<void(size_t)>& task);
+
+    /**
+     * @brief Ordena tareas de mayor a menor coste para parallelFor
+     * @param count Número de tareas
+     * @param cost Coste estimado de cada tarea (por ejemplo, bytes del fuente)
+     * @return std::vector<size_t> Índices de las tareas, la más costosa primero
+     *
+     * Empezar por las grandes evita que una de ellas sea la última en
+     * empezar y deje a los demás hilos esperando.
+     */
+    std::vector<size_t> largestFirst(size_t count, const std::function<size_t(size_t)>& cost);
+
+    /**
+     * @class WorkPool
+     * @brief Hilos permanentes que se reparten las tareas robándose trabajo
+     *
+     * Cada hilo empieza con un tramo contiguo de los índices y los toma de
+     * uno en uno desde el principio; cuando se le acaba, roba la mitad
+     * final del tramo de otro. Las tareas de coste muy desigual no dejan
+     * hilos parados, y mientras no roba cada hilo recorre índices
+     * consecutivos sin competir con los demás. Los hilos duermen entre una
+     * llamada a run() y la siguiente.
+     */
+    class WorkPool {
+    public:
+        /**
+         * @brief Constructor de WorkPool
+         * @param threads Hilos en total, contando al que llama a run() (al menos 1)
+         */
+        explicit WorkPool(unsigned threads);
+        ~WorkPool();
+        WorkPool(const WorkPool&) = delete;
+        WorkPool& operator=(const WorkPool&) = delete;
+
+        /**
+         * @brief Obtiene el pool del proceso
+         * @return WorkPool& Pool con defaultThreads() hilos, creado la primera vez que se pide
+         */
+        static WorkPool& shared();
+
+        /**
+         * @brief Número de hilos, contando al que llama a run()
+         * @return unsigned Valor máximo de worker más uno (crece si run() pide más)
+         */
+        unsigned size() const { return static_cast<unsigned>(threads.size()) + 1; }
+
+        /**
+         * @brief Ejecuta task(worker, 0) ... task(worker, count - 1) repartidas entre los hilos
+         * @param count Número de tareas
+         * @param limit Hilos como máximo, contando el que llama (0 = size(); si es mayor, el pool crece)
+         * @param task Tarea; worker identifica el hilo que la ejecuta (el que llama es el 0)
+         * @throws Cualquier excepción de una tarea, una vez terminadas todas
+         *
+         * Dos tareas con el mismo worker nunca se ejecutan a la vez, así que
+         * pueden compartir el estado de su worker. Si el pool ya está
+         * ejecutando otro run() (llamado desde una tarea o desde otro hilo),
+         * todas las tareas se ejecutan en el hilo que llama, como worker 0.
+         */
+        void run(size_t count, unsigned limit, const std::function<void(unsigned, size_t)>& task);
+
+    private:
+        struct Job;
+
+        std::vector<std::thread> threads;   ///< Hilos del pool (el worker i + 1 es threads[i])
+        std::mutex mutex;                   ///< Protege job, generation, pending y stopping
+        std::condition_variable wake;       ///< Avisa a los hilos de un trabajo nuevo
+        std::condition_variable finished;   ///< Avisa a run() de que un hilo terminó su parte
+        Job* job = nullptr;                 ///< Trabajo en curso
+        uint64_t generation = 0;            ///< Número de trabajos empezados
+        unsigned pending = 0;               ///< Hilos del pool que aún trabajan en job
+        bool stopping = false;              ///< El destructor está esperando a los hilos
+        std::atomic<bool> busy{false};      ///< Hay un run() en curso
+
+        /**
+         * @brief Bucle de uno de los hilos del pool
+         * @param worker Índice del hilo (1 .. size() - 1)
+         */
+        void serve(unsigned worker);
+    };
+}
+
+#endif // PARALLEL_H
@@ -0,0 +1,84 @@
+/**
+ * @file SourceFile.cpp
+ * @brief Implementación de la carga de archivos de código fuente
+ * @author Javier
+ * @date 2025
+ */
+
+#include "SourceFile.h"
+
+#include <fstream>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define SETKER_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace TokenTree {
+    SourceFile::SourceFile(const std::string& path) {
+        open = map(path) || read(path);
+    }
+
+    SourceFile::~SourceFile() {
+#ifdef SETKER_MMAP
+        if (mapping) munmap(mapping, mappedSize);
+#endif
+    }
+
+    bool SourceFile::map(const std::string& path) {
+#ifdef SETKER_MMAP
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat info {};
+        // Solo archivos regulares: tuberías y dispositivos se leen en read()
+        if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode)) {
+            close(fd);
+            return false;
+        }
+        if (info.st_size == 0) {
+            close(fd);
+            return true; // mmap no admite longitud 0: la vista queda vacía
+        }
+        size_t size = static_cast<size_t>(info.st_size);
+        void* address = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd); // la proyección sigue siendo válida sin el descriptor
+        if (address == MAP_FAILED) return false;
+        // El tokenizer recorre el archivo una vez de principio a fin
+        madvise(address, size, MADV_SEQUENTIAL);
+        mapping = address;
+        mappedSize = size;
+        view = std::string_view(static_cast<const char*>(address), size);
+        return true;
+#else
+        (void)path;
+        return false;
+#endif
+    }
+
+    bool SourceFile::read(const std::string& path) {
+        // Modo texto, como cualquier lectura de fuentes (en Windows convierte los CRLF)
+        std::ifstream file(path);
+        if (!file.is_open()) return false;
+        file.seekg(0, std::ios::end);
+        auto end = file.tellg();
+        if (end > 0) {
+            // Tamaño conocido: una sola reserva y una sola lectura
+            buffer.resize(static_cast<size_t>(end));
+            file.seekg(0, std::ios::beg);
+            file.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+            buffer.resize(static_cast<size_t>(file.gcount()));
+        } else {
+            // Sin tamaño (tuberías): lectura por bloques desde la posición actual
+            file.clear();
+            char chunk[1 << 16];
+            while (file.read(chunk, sizeof chunk) || file.gcount() > 0) {
+                buffer.append(chunk, static_cast<size_t>(file.gcount()));
+            }
+        }
+        view = buffer;
+        return true;
+    }
+}
@@ -0,0 +1,79 @@
+/**
+ * @file SourceFile.h
+ * @brief Carga de archivos de código fuente sin copias intermedias
+ * @author Javier
+ * @date 2025
+ *
+ * Este archivo define SourceFile, que expone el contenido de un archivo
+ * como una vista de solo lectura. En sistemas POSIX el archivo se
+ * proyecta en memoria (mmap) y el tokenizer lee directamente de las
+ * páginas del sistema; en el resto, o si la proyección falla, se lee
+ * con una única lectura del tamaño exacto.
+ */
+
+#ifndef SOURCEFILE_H
+#define SOURCEFILE_H
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace TokenTree {
+    /**
+     * @class SourceFile
+     * @brief Contenido de un archivo de código fuente, propiedad del objeto
+     *
+     * La vista devuelve por contents() (y por tanto los lexemas de los
+     * tokens que apuntan a ella) es válida mientras el SourceFile exista.
+     * No termina en '\0'.
+     */
+    class SourceFile {
+    public:
+        /**
+         * @brief Abre y carga un archivo
+         * @param path Ruta del archivo
+         *
+         * Si no puede abrirse, isOpen() devuelve false y contents() está vacío.
+         */
+        explicit SourceFile(const std::string& path);
+        ~SourceFile();
+
+        SourceFile(const SourceFile&) = delete;
+        SourceFile& operator=(const SourceFile&) = delete;
+
+        /**
+         * @brief Indica si el archivo se abrió correctamente
+         * @return bool true si contents() refleja el archivo
+         */
+        bool isOpen() const { return open; }
+
+        /**
+         * @brief Obtiene el contenido del archivo
+         * @return std::string_view Vista de solo lectura del contenido
+         */
+        std::string_view contents() const { return view; }
+
+    private:
+        std::string_view view;  ///< Contenido (proyección o buffer)
+        std::string buffer;     ///< Copia leída cuando no se usa mmap
+        void* mapping = nullptr; ///< Dirección de la proyección, si la hay
+        size_t mappedSize = 0;  ///< Tamaño de la proyección
+        bool open = false;      ///< El archivo se abrió
+
+        /**
+         * @brief Proyecta el archivo en memoria
+         * @param path Ruta del archivo
+         * @return bool true si se proyectó (o si está vacío)
+         */
+        bool map(const std::string& path);
+
+        /**
+         * @brief Lee el archivo completo con una única lectura
+         * @param path Ruta del archivo
+         * @return bool true si se leyó
+         */
+        bool read(const std::string& path);
+    };
+}
+
+#endif // SOURCEFILE_H
@@ -10,25 +10,16 @@
 
 #include "Tokens.h"
 
+#include <charconv>
 #include <cmath>
 #include <cstdint>
 #include <sstream>
 
-// Implementación del constructor
-Token::Token(TokenType type, std::string lexeme, Literal literalValue)
-    : type(type), lexeme(std::move(lexeme)), literal(literalValue) {}
-
-// Implementación de los getters
-TokenType Token::getType() const {
-    return type;
-}
-
-std::string Token::getLexeme() const {
-    return lexeme;
-}
-
-Literal Token::getLiteral() const {
-    return literal;
+double Token::getNumber() const {
+    // Igual que std::stod: se toma el prefijo numérico más largo ("1.2.3" vale 1.2)
+    double value = 0;
+    std::from_chars(lexeme.data(), lexeme.data() + lexeme.size(), value);
+    return value;
 }
 
 // Implementación del método print
@@ -83,10 +74,8 @@ std::string Token::print() const {
 
     std::string literalString = "null";
 
-    if (std::holds_alternative<bool>(literal)) {
-        literalString = std::get<bool>(literal) ? "true" : "false";
-    } else if (std::holds_alternative<double>(literal)) {
-        double value = std::get<double>(literal);
+    if (type == TokenType::NUMBER) {
+        double value = getNumber();
         std::ostringstream oss;
         oss.precision(15);
         if (std::abs(value - std::round(value)) < 1e-9) {
@@ -95,8 +84,8 @@ std::string Token::print() const {
             oss << value;
         }
         literalString = oss.str();
-    } else if (std::holds_alternative<std::string>(literal)) {
-        literalString = std::get<std::string>(literal);
+    } else if (type == TokenType::STRING) {
+        literalString = lexeme;
     }
 
     if (type == TokenType::STRING) {
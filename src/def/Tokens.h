@@ -13,7 +13,7 @@
 #define TOKENS_H
 
 #include <string>
-#include <variant>
+#include <string_view>
 
 /**
  * @enum TokenType
@@ -83,65 +83,48 @@ enum class TokenType {
      EOF_OF_FILE     ///< Marcador de fin de archivo
  };
 
-/**
- * @typedef Literal
- * @brief Tipo variante para representar valores literales de tokens
- * 
- * Utiliza std::variant para almacenar diferentes tipos de valores:
- * - void*: Para tokens sin valor (por ejemplo, operadores)
- * - bool: Para literales booleanos (true/false)
- * - double: Para literales numéricos
- * - std::string: Para literales de cadena
- */
-using Literal = std::variant<void*, bool, double, std::string>;
-
 /**
  * @class Token
  * @brief Representa un token individual identificado por el analizador léxico
  * 
  * Encapsula toda la información necesaria sobre un token:
  * - Su tipo (TokenType)
- * - Su representación textual original (lexeme)
- * - Su valor literal si aplicable
+ * - Su representación textual original (lexeme), como vista al código fuente
+ *
+ * El token no copia texto: el lexema apunta al buffer leído por
+ * read_file_contents (o a una constante para los símbolos fijos), que
+ * debe seguir vivo mientras se usen los tokens. El valor de los literales
+ * se decodifica a partir del lexema solo cuando se pide.
  */
 class Token {
-    TokenType type;     ///< Tipo del token
-    std::string lexeme; ///< Texto original del token
-    Literal literal;    ///< Valor literal del token
+    TokenType type;          ///< Tipo del token
+    std::string_view lexeme; ///< Texto original del token (sin comillas en STRING)
 
 public:
     /**
-     * @brief Constructor completo de Token
-     * @param type Tipo del token
-     * @param lexeme Texto original del token
-     * @param literalValue Valor literal del token
-     */
-    Token(TokenType type, std::string lexeme, Literal literalValue);
-    
-    /**
-     * @brief Constructor simplificado para tokens sin valor literal
+     * @brief Constructor de Token
      * @param type Tipo del token
-     * @param lexeme Texto original del token
+     * @param lexeme Texto original del token, dentro de un buffer que lo sobrevive
      */
-    Token(TokenType type, std::string lexeme) : Token(type, lexeme, nullptr) {}
+    Token(TokenType type, std::string_view lexeme) : type(type), lexeme(lexeme) {}
 
     /**
      * @brief Obtiene el tipo del token
      * @return TokenType Tipo del token
      */
-    [[nodiscard]] TokenType getType() const;
+    [[nodiscard]] TokenType getType() const { return type; }
     
     /**
      * @brief Obtiene el texto original del token
-     * @return std::string Lexema del token
+     * @return std::string_view Lexema del token (contenido sin comillas en STRING)
      */
-    [[nodiscard]] std::string getLexeme() const;
+    [[nodiscard]] std::string_view getLexeme() const { return lexeme; }
     
     /**
-     * @brief Obtiene el valor literal del token
-     * @return Literal Valor literal del token
+     * @brief Decodifica el valor de un literal numérico
+     * @return double Valor del token NUMBER
      */
-    [[nodiscard]] Literal getLiteral() const;
+    [[nodiscard]] double getNumber() const;
     
     /**
      * @brief Genera una representación en cadena del token para debugging
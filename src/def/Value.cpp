@@ -0,0 +1,123 @@
+/**
+ * @file Value.cpp
+ * @brief Implementación de las tablas de internado de cadenas y de las operaciones de Object
+ * @author Javier
+ * @date 2025
+ */
+
+#include "Value.h"
+
+#include <unordered_set>
+
+#include "ErrorCode.h"
+
+namespace TokenTree {
+    namespace {
+        /**
+         * @struct StringKey
+         * @brief Clave de búsqueda en la tabla: contenido y su hash
+         */
+        struct StringKey {
+            std::string_view chars;
+            size_t hash;
+        };
+
+        /// Hash de la tabla: reutiliza el hash guardado en la clave o en el objeto
+        struct StringHash {
+            using is_transparent = void;
+            size_t operator()(const StringKey& key) const { return key.hash; }
+            size_t operator()(const StringObject* string) const { return string->hash(); }
+        };
+
+        /// Igualdad de la tabla: compara contenidos solo si los hashes coinciden
+        struct StringEqual {
+            using is_transparent = void;
+            bool operator()(const StringObject* a, const StringObject* b) const { return a == b; }
+            bool operator()(const StringKey& key, const StringObject* string) const {
+                return key.hash == string->hash() && key.chars == string->chars;
+            }
+            bool operator()(const StringObject* string, const StringKey& key) const {
+                return (*this)(key, string);
+            }
+        };
+
+        /// Tabla instalada en este hilo (nullptr = la del proceso)
+        thread_local StringTable* installed = nullptr;
+    }
+
+    /// Cadenas vivas, indexadas por contenido. La tabla no mantiene referencias.
+    struct StringTable::Set : std::unordered_set<StringObject*, StringHash, StringEqual> {};
+
+    StringTable::StringTable() : strings(std::make_unique<Set>()) {}
+
+    StringTable::~StringTable() {
+        // Las cadenas que siguen vivas (en un AST, por ejemplo) dejan de estar internadas
+        for (StringObject* string : *strings) string->table = nullptr;
+    }
+
+    size_t StringTable::size() const {
+        return strings->size();
+    }
+
+    StringTable& StringTable::current() {
+        if (installed) return *installed;
+        // Nunca se destruye: hay cadenas en entornos estáticos que mueren después
+        static auto* process = new StringTable();
+        return *process;
+    }
+
+    StringTable* StringTable::install(StringTable* table) {
+        StringTable* previous = installed;
+        installed = table;
+        return previous;
+    }
+
+    template <class Chars>
+    Value StringTable::lookup(Chars&& chars) {
+        if (chars.size() > StringObject::MAX_INTERNED_LENGTH) {
+            return Value(new StringObject(std::string(std::forward<Chars>(chars)), nullptr));
+        }
+        StringKey key{chars, std::hash<std::string_view>{}(chars)};
+        auto it = strings->find(key);
+        if (it != strings->end()) return Value(*it);
+        auto* string = new StringObject(std::string(std::forward<Chars>(chars)), this, key.hash);
+        strings->insert(string);
+        return Value(string);
+    }
+
+    Value StringTable::intern(std::string_view chars) {
+        return lookup(chars);
+    }
+
+    Value StringTable::intern(std::string&& chars) {
+        return lookup(std::move(chars));
+    }
+
+    void StringTable::erase(StringObject* string) {
+        strings->erase(string);
+    }
+
+    StringObject::~StringObject() {
+        if (table) table->erase(this);
+    }
+
+    Value Object::transfer(Transfer&) const {
+        throw Error(ErrorCodes::ArgumentTypeMismatch, "Value cannot be passed to another interpreter.");
+    }
+
+    Value Object::call(const Value*, size_t) const {
+        throw Error(ErrorCodes::CallOnNonFunction, "Attempt to call non-function.");
+    }
+
+    Value StringObject::transfer(Transfer&) const {
+        return makeString(std::string_view(chars));
+    }
+
+    Value makeString(std::string_view chars) {
+        return StringTable::current().intern(chars);
+    }
+
+    Value makeString(std::string&& chars) {
+        return StringTable::current().intern(std::move(chars));
+    }
+}
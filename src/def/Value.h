@@ -0,0 +1,385 @@
+/**
+ * @file Value.h
+ * @brief Representación compacta (NaN-boxing) de los valores de Setker
+ * @author Javier
+ * @date 2025
+ *
+ * Este archivo define Value, el tipo de todos los valores del lenguaje.
+ * Ocupa 8 bytes: los números se guardan tal cual como double y el resto
+ * de valores se codifican dentro del espacio de los NaN silenciosos:
+ * nil, true, false y el marcador interno Undefined como etiquetas, y las
+ * cadenas, funciones y arrays como punteros a objetos del heap (Object)
+ * con contador de referencias intrusivo.
+ */
+
+#ifndef VALUE_H
+#define VALUE_H
+
+#include <bit>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace TokenTree {
+    class Collectable;
+    class Transfer;
+    class Value;
+
+    /**
+     * @struct Object
+     * @brief Base de todos los valores que viven en el heap
+     *
+     * Lleva su propio contador de referencias, que mantienen Value y Ref.
+     * El objeto se destruye cuando deja de estar referenciado.
+     */
+    struct Object {
+        /**
+         * @enum Kind
+         * @brief Tipo concreto del objeto
+         */
+        enum class Kind : uint8_t {
+            String,    ///< Cadena inmutable (StringObject)
+            Function,  ///< Función del evaluador (Evaluator::LoxFunction)
+            Closure,   ///< Función compilada de la VM (VM::Closure)
+            Native,    ///< Función implementada en C++ (NativeFunction)
+            Array      ///< Array de valores (ArrayObject)
+        };
+
+        uint32_t refCount = 0; ///< Número de Value/Ref que apuntan al objeto
+        const Kind kind;       ///< Tipo concreto
+
+        explicit Object(Kind kind) : kind(kind) {}
+        Object(const Object&) = delete;
+        Object& operator=(const Object&) = delete;
+        virtual ~Object() = default;
+
+        /**
+         * @brief Obtiene el objeto como contenedor del recolector de ciclos (ver Heap)
+         * @return Collectable* El propio objeto, o nullptr si no referencia a otros
+         */
+        virtual Collectable* collectable() { return nullptr; }
+
+        /**
+         * @brief Copia el objeto en el intérprete instalado en este hilo (ver Transfer)
+         * @param transfer Copia en curso, que conserva los objetos ya copiados
+         * @return Value Copia independiente del original
+         * @throws Error ArgumentTypeMismatch si el objeto no se puede copiar
+         *
+         * Solo lee el original: otros hilos pueden estar copiándolo a la vez.
+         */
+        virtual Value transfer(Transfer& transfer) const;
+
+        /**
+         * @brief Llama al objeto desde C++ (funciones del evaluador y nativas)
+         * @param args Argumentos ya evaluados
+         * @param count Número de argumentos
+         * @return Value Valor que retorna la llamada
+         * @throws Error CallOnNonFunction si no es invocable, o el error de la llamada
+         */
+        virtual Value call(const Value* args, size_t count) const;
+    };
+
+    class StringTable;
+
+    /**
+     * @struct StringObject
+     * @brief Cadena de texto inmutable
+     *
+     * Las cadenas cortas (literales, claves, resultados pequeños) pasan por
+     * la tabla de internado de makeString: dos cadenas internadas en la
+     * misma tabla con el mismo contenido son siempre el mismo objeto. Las
+     * largas no se internan para no recorrerlas en cada concatenación; su
+     * hash se calcula la primera vez que se necesita.
+     */
+    struct StringObject : Object {
+        /// Longitud máxima de las cadenas que se internan
+        static constexpr size_t MAX_INTERNED_LENGTH = 64;
+
+        const std::string chars; ///< Contenido de la cadena
+
+        /**
+         * @brief Constructor de StringObject (usar makeString)
+         * @param chars Contenido de la cadena
+         * @param table Tabla en la que se registra (nullptr si no se interna)
+         * @param hash Hash de chars (solo si ya se conoce)
+         */
+        StringObject(std::string chars, StringTable* table, size_t hash = 0)
+            : Object(Kind::String), chars(std::move(chars)), cachedHash(hash), hashed(table != nullptr), table(table) {}
+        ~StringObject() override;
+
+        /// Copia: la misma cadena en la tabla del hilo actual
+        Value transfer(Transfer& transfer) const override;
+
+        /**
+         * @brief Indica si la cadena está internada
+         * @return bool true si está registrada en una tabla (viva)
+         */
+        bool interned() const { return table != nullptr; }
+
+        /**
+         * @brief Obtiene el hash del contenido (se calcula una sola vez)
+         * @return size_t Hash de chars
+         */
+        size_t hash() const {
+            if (!hashed) {
+                cachedHash = std::hash<std::string_view>{}(chars);
+                hashed = true;
+            }
+            return cachedHash;
+        }
+
+        /**
+         * @brief Compara el contenido de dos cadenas
+         * @param other Otra cadena
+         * @return bool true si el contenido es idéntico
+         *
+         * Entre cadenas internadas basta comparar los punteros.
+         */
+        bool equals(const StringObject& other) const {
+            if (this == &other) return true;
+            if (table && table == other.table) return false;
+            return chars.size() == other.chars.size() && hash() == other.hash() && chars == other.chars;
+        }
+
+    private:
+        friend class StringTable;
+
+        mutable size_t cachedHash; ///< Hash del contenido
+        mutable bool hashed;       ///< true si cachedHash ya es válido
+        StringTable* table;        ///< Tabla en la que está internada (o nullptr)
+    };
+
+    /**
+     * @class Ref
+     * @brief Puntero con contador de referencias intrusivo a un Object
+     * @tparam T Tipo concreto del objeto (derivado de Object)
+     */
+    template <class T>
+    class Ref {
+    public:
+        Ref() = default;
+        Ref(T* object) : ptr(object) { retain(); }
+        Ref(const Ref& other) : ptr(other.ptr) { retain(); }
+        Ref(Ref&& other) noexcept : ptr(std::exchange(other.ptr, nullptr)) {}
+        ~Ref() { release(); }
+
+        Ref& operator=(Ref other) noexcept {
+            std::swap(ptr, other.ptr);
+            return *this;
+        }
+
+        T* get() const { return ptr; }
+        T* operator->() const { return ptr; }
+        T& operator*() const { return *ptr; }
+        explicit operator bool() const { return ptr != nullptr; }
+
+    private:
+        T* ptr = nullptr;
+
+        void retain() const {
+            if (ptr) ++static_cast<Object*>(ptr)->refCount;
+        }
+        void release() {
+            if (ptr && --static_cast<Object*>(ptr)->refCount == 0) delete static_cast<Object*>(ptr);
+        }
+    };
+
+    /**
+     * @brief Crea un objeto y devuelve la primera referencia a él
+     * @tparam T Tipo del objeto
+     * @param args Argumentos del constructor
+     * @return Ref<T> Referencia al objeto nuevo
+     */
+    template <class T, class... Args>
+    Ref<T> makeRef(Args&&... args) {
+        return Ref<T>(new T(std::forward<Args>(args)...));
+    }
+
+    /**
+     * @struct Undefined
+     * @brief Marcador de variable declarada pero todavía no definida
+     *
+     * No es un valor del lenguaje: solo ocupa las ranuras que se reservan
+     * de antemano (entornos del evaluador, pila de la máquina virtual)
+     * hasta que se ejecuta la declaración correspondiente. Nunca llega al
+     * programa.
+     */
+    struct Undefined {};
+
+    /**
+     * @class Value
+     * @brief Valor de Setker en 8 bytes (NaN-boxing)
+     *
+     * Codificación de los 64 bits:
+     * - Cualquier double que no sea un NaN silencioso con los bits de
+     *   etiqueta: el propio número (los NaN se normalizan al crearse)
+     * - QNAN | etiqueta: nil, false, true o Undefined
+     * - SIGN_BIT | QNAN | puntero: objeto del heap (48 bits de dirección)
+     *
+     * Copiar un número, booleano o nil es copiar 8 bytes; copiar un objeto
+     * además incrementa su contador de referencias.
+     */
+    class Value {
+    public:
+        /// Construye nil
+        Value() noexcept : bits(QNAN | TAG_NIL) {}
+        Value(double number) noexcept : bits(std::bit_cast<uint64_t>(number)) {
+            // Un NaN calculado podría coincidir con una etiqueta: se normaliza
+            if ((bits & QNAN) == QNAN) bits = CANONICAL_NAN;
+        }
+        Value(bool boolean) noexcept : bits(QNAN | (boolean ? TAG_TRUE : TAG_FALSE)) {}
+        Value(Undefined) noexcept : bits(QNAN | TAG_UNDEFINED) {}
+        Value(Object* object) noexcept
+            : bits(SIGN_BIT | QNAN | static_cast<uint64_t>(reinterpret_cast<uintptr_t>(object))) {
+            retain();
+        }
+        template <class T>
+        Value(const Ref<T>& object) noexcept : Value(static_cast<Object*>(object.get())) {}
+        Value(const char*) = delete; // evita la conversión implícita a bool
+
+        Value(const Value& other) noexcept : bits(other.bits) { retain(); }
+        Value(Value&& other) noexcept : bits(std::exchange(other.bits, QNAN | TAG_NIL)) {}
+        ~Value() { release(); }
+
+        Value& operator=(const Value& other) noexcept {
+            other.retain();
+            release();
+            bits = other.bits;
+            return *this;
+        }
+        Value& operator=(Value&& other) noexcept {
+            if (this != &other) {
+                release();
+                bits = std::exchange(other.bits, QNAN | TAG_NIL);
+            }
+            return *this;
+        }
+
+        bool isNumber() const { return (bits & QNAN) != QNAN; }
+        bool isNil() const { return bits == (QNAN | TAG_NIL); }
+        bool isBool() const { return (bits | 1) == (QNAN | TAG_TRUE); }
+        bool isUndefined() const { return bits == (QNAN | TAG_UNDEFINED); }
+        bool isObject() const { return (bits & (SIGN_BIT | QNAN)) == (SIGN_BIT | QNAN); }
+        bool isObject(Object::Kind kind) const { return isObject() && asObject()->kind == kind; }
+        bool isString() const { return isObject(Object::Kind::String); }
+
+        double asNumber() const { return std::bit_cast<double>(bits); }
+        bool asBool() const { return bits == (QNAN | TAG_TRUE); }
+        Object* asObject() const {
+            return reinterpret_cast<Object*>(static_cast<uintptr_t>(bits & ~(SIGN_BIT | QNAN)));
+        }
+        const std::string& asString() const { return static_cast<StringObject*>(asObject())->chars; }
+
+        /**
+         * @brief Obtiene el objeto con su tipo concreto
+         * @tparam T Tipo del objeto; el llamador debe haber comprobado kind
+         * @return T* Puntero al objeto (sin transferir la referencia)
+         */
+        template <class T>
+        T* as() const { return static_cast<T*>(asObject()); }
+
+    private:
+        static constexpr uint64_t SIGN_BIT = 0x8000000000000000ULL;
+        static constexpr uint64_t QNAN = 0x7ffc000000000000ULL;
+        static constexpr uint64_t CANONICAL_NAN = 0x7ff8000000000000ULL;
+        static constexpr uint64_t TAG_NIL = 1;
+        static constexpr uint64_t TAG_FALSE = 2;
+        static constexpr uint64_t TAG_TRUE = 3;
+        static constexpr uint64_t TAG_UNDEFINED = 4;
+
+        uint64_t bits; ///< Representación codificada
+
+        void retain() const {
+            if (isObject()) ++asObject()->refCount;
+        }
+        void release() {
+            if (isObject()) {
+                Object* object = asObject();
+                if (--object->refCount == 0) delete object;
+            }
+        }
+    };
+
+    static_assert(sizeof(void*) == 8, "NaN-boxing de Value requiere punteros de 64 bits");
+    static_assert(sizeof(Value) == 8, "Value debe ocupar 8 bytes");
+
+    /**
+     * @class StringTable
+     * @brief Tabla de internado de cadenas
+     *
+     * Cada intérprete tiene la suya (ver Context), ya que los contadores de
+     * referencias no son atómicos y dos hilos no pueden compartir objetos.
+     * makeString usa la tabla instalada en el hilo actual o, si no hay
+     * ninguna, la del proceso. La tabla no mantiene vivas sus cadenas: cada
+     * una se borra de ella al destruirse, y las que sobreviven a la tabla
+     * simplemente dejan de estar internadas.
+     */
+    class StringTable {
+    public:
+        StringTable();
+        ~StringTable();
+        StringTable(const StringTable&) = delete;
+        StringTable& operator=(const StringTable&) = delete;
+
+        /**
+         * @brief Obtiene la tabla que usa makeString en este hilo
+         * @return StringTable& Tabla instalada, o la del proceso
+         */
+        static StringTable& current();
+
+        /**
+         * @brief Instala una tabla para este hilo
+         * @param table Tabla a usar (nullptr vuelve a la del proceso)
+         * @return StringTable* Tabla instalada antes, para restaurarla
+         */
+        static StringTable* install(StringTable* table);
+
+        /**
+         * @brief Obtiene la cadena internada con ese contenido
+         * @param chars Contenido de la cadena
+         * @return Value Valor que referencia la cadena
+         */
+        Value intern(std::string_view chars);
+
+        /**
+         * @brief Obtiene la cadena internada con ese contenido
+         * @param chars Contenido (se reutiliza su memoria si la cadena es nueva)
+         * @return Value Valor que referencia la cadena
+         */
+        Value intern(std::string&& chars);
+
+        /**
+         * @brief Cuenta las cadenas internadas vivas
+         * @return size_t Número de cadenas de la tabla
+         */
+        size_t size() const;
+
+    private:
+        friend struct StringObject;
+        struct Set;
+        std::unique_ptr<Set> strings; ///< Cadenas vivas, indexadas por contenido
+
+        template <class Chars>
+        Value lookup(Chars&& chars);
+        void erase(StringObject* string);
+    };
+
+    /**
+     * @brief Obtiene un valor de cadena con ese contenido
+     * @param chars Contenido de la cadena
+     * @return Value Valor que referencia la cadena (internada si es corta)
+     */
+    Value makeString(std::string_view chars);
+
+    /**
+     * @brief Obtiene un valor de cadena con ese contenido
+     * @param chars Contenido de la cadena (se reutiliza su memoria si la cadena es nueva)
+     * @return Value Valor que referencia la cadena (internada si es corta)
+     */
+    Value makeString(std::string&& chars);
+}
+
+#endif // VALUE_H
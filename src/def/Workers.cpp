@@ -0,0 +1,161 @@
+/**
+ * @file Workers.cpp
+ * @brief Implementación de la copia entre intérpretes y de parallel_map
+ * @author Javier
+ * @date 2025
+ */
+
+#include "Workers.h"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "Context.h"
+#include "ErrorCode.h"
+#include "Parallel.h"
+
+namespace TokenTree {
+    constinit thread_local Transfer* Transfer::active = nullptr;
+
+    Transfer::Transfer(Environment& from, std::shared_ptr<Environment> to) : from(from), to(std::move(to)) {}
+
+    Value Transfer::copy(const Value& value) {
+        // Números, booleanos y nil no tienen contador: se copian los 8 bytes
+        if (!value.isObject()) return value;
+        const Object* object = value.asObject();
+        if (auto it = objects.find(object); it != objects.end()) return it->second;
+        Value copied = object->transfer(*this);
+        objects.emplace(object, copied);
+        return copied;
+    }
+
+    std::shared_ptr<Environment> Transfer::copy(const Environment* env) {
+        if (!env) return nullptr;
+        if (!env->enclosing) return to;
+        if (auto it = environments.find(env); it != environments.end()) return it->second;
+        if (!env->owner) {
+            throw Error(ErrorCodes::ArgumentTypeMismatch, "Value cannot be passed to another interpreter.");
+        }
+        std::shared_ptr<Environment> enclosing = copy(env->enclosing);
+        // Copiar el padre puede haber llegado hasta aquí por una función guardada en él
+        if (auto it = environments.find(env); it != environments.end()) return it->second;
+        auto copied = std::make_shared<Environment>(std::move(enclosing), env->ownedSlots.size());
+        environments.emplace(env, copied);
+        for (size_t i = 0; i < env->ownedSlots.size(); ++i) copied->ownedSlots[i] = copy(env->ownedSlots[i]);
+        for (const auto& [name, value] : env->values) copied->values.emplace(name, copy(value));
+        return copied;
+    }
+
+    void Transfer::remember(const Object* original, const Value& copy) {
+        objects.emplace(original, copy);
+    }
+
+    bool Transfer::import(const std::string& name, Value& value) {
+        const Value* found = from.findLocal(name);
+        if (!found) return false;
+        value = copy(*found);
+        return true;
+    }
+
+    namespace {
+        /**
+         * @struct Worker
+         * @brief Intérprete de uno de los hilos de una llamada a parallel_map
+         *
+         * Empieza sin globales: las importa del intérprete que llama a
+         * medida que la función las usa.
+         */
+        struct Worker {
+            Context context{nullptr};                             ///< Sin archivo: print se guarda por elemento
+            std::optional<Transfer> in;                           ///< Copias desde el intérprete que llama
+            Value function;                                       ///< Copia de la función
+            std::vector<std::pair<size_t, std::string>> printed;  ///< Salida de los elementos que imprimieron
+
+            /**
+             * @brief Constructor de Worker (en el hilo que lo va a usar)
+             * @param caller Globales del intérprete que llama
+             * @param original Función que se aplica
+             */
+            Worker(Environment& caller, const Value& original) {
+                Context::Scope scope(context);
+                context.globals = std::make_shared<Environment>();
+                in.emplace(caller, context.globals);
+                context.globals->importFrom(&*in);
+                function = in->copy(original);
+            }
+        };
+    }
+
+    Value mapInParallel(const Value& function, const ArrayObject& array, unsigned threads) {
+        Context& caller = Context::current();
+        if (threads == 0) threads = defaultThreads();
+        const size_t count = array.size();
+
+        std::vector<std::unique_ptr<Worker>> workers(threads);
+        std::vector<Value> results(count);
+        std::vector<unsigned> producedBy(count);
+        // Primer elemento cuya llamada falló (count si ninguno) y su error
+        std::atomic<size_t> failed{count};
+        std::exception_ptr failure;
+        std::mutex failureMutex;
+
+        WorkPool::shared().run(count, threads, [&](unsigned w, size_t i) {
+            // Tras un error solo faltan los elementos anteriores a él
+            if (i > failed.load(std::memory_order_relaxed)) return;
+            std::unique_ptr<Worker>& worker = workers[w];
+            Transfer* previous = Transfer::active;
+            try {
+                if (!worker) worker = std::make_unique<Worker>(*caller.globals, function);
+                Context::Scope scope(worker->context);
+                Transfer::active = &*worker->in;
+                Value argument = array.isNumeric() ? Value(array.numberData()[i]) : worker->in->copy(array.valueData()[i]);
+                results[i] = worker->function.asObject()->call(&argument, 1);
+                producedBy[i] = w;
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(failureMutex);
+                if (i < failed.load(std::memory_order_relaxed)) {
+                    failed.store(i, std::memory_order_relaxed);
+                    failure = std::current_exception();
+                }
+            }
+            Transfer::active = previous;
+            if (!worker) return;
+            std::string text = worker->context.output.take();
+            if (!text.empty()) worker->printed.emplace_back(i, std::move(text));
+        });
+
+        // Lo impreso, en el orden de los elementos y sin lo de los posteriores a un error
+        const size_t last = failed.load(std::memory_order_relaxed);
+        std::vector<std::pair<size_t, std::string>> printed;
+        for (auto& worker : workers) {
+            if (!worker) continue;
+            for (auto& entry : worker->printed) {
+                if (entry.first <= last) printed.push_back(std::move(entry));
+            }
+        }
+        std::sort(printed.begin(), printed.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+        for (const auto& entry : printed) caller.output << entry.second;
+        if (!printed.empty()) caller.output.flush();
+        if (failure) std::rethrow_exception(failure);
+
+        // Los resultados pasan al intérprete que llama; sus funciones, a sus globales
+        auto mapped = makeRef<ArrayObject>();
+        mapped->reserve(count);
+        std::vector<std::unique_ptr<Transfer>> back(workers.size());
+        for (size_t i = 0; i < count; ++i) {
+            if (!results[i].isObject()) {
+                mapped->push(results[i]);
+                continue;
+            }
+            std::unique_ptr<Transfer>& transfer = back[producedBy[i]];
+            if (!transfer) transfer = std::make_unique<Transfer>(*workers[producedBy[i]]->context.globals, caller.globals);
+            mapped->push(transfer->copy(results[i]));
+        }
+        return mapped;
+    }
+}
@@ -0,0 +1,112 @@
+/**
+ * @file Workers.h
+ * @brief Ejecución de funciones del programa en varios hilos (parallel_map)
+ * @author Javier
+ * @date 2025
+ *
+ * Este archivo define la copia de valores entre intérpretes y el reparto
+ * de las llamadas de parallel_map entre los hilos del WorkPool. Los
+ * contadores de referencias no son atómicos y cada Context es de un solo
+ * hilo, así que cada worker ejecuta en su propio Context, con copias de la
+ * función, de los elementos y de las globales que usa; sus resultados se
+ * copian de vuelta al intérprete que llamó.
+ */
+
+#ifndef WORKERS_H
+#define WORKERS_H
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include "Array.h"
+#include "Environment.h"
+#include "Value.h"
+
+namespace TokenTree {
+    /**
+     * @class Transfer
+     * @brief Copia valores de un intérprete (Context) al instalado en este hilo
+     *
+     * Copia entero cada valor: cadenas, arrays, funciones y los entornos que
+     * capturan, sin modificar el original (otros hilos pueden estar
+     * leyéndolo a la vez). Cada objeto se copia una sola vez por Transfer,
+     * de modo que las copias conservan los alias y los ciclos del original.
+     * El entorno global de origen no se copia: se sustituye por el de
+     * destino, que puede importar de él sus variables (GlobalSource).
+     */
+    class Transfer : public GlobalSource {
+    public:
+        /**
+         * @brief Constructor de Transfer
+         * @param from Entorno global del intérprete de origen
+         * @param to Entorno global del intérprete de destino
+         */
+        Transfer(Environment& from, std::shared_ptr<Environment> to);
+
+        /**
+         * @brief Copia un valor
+         * @param value Valor del intérprete de origen
+         * @return Value Copia en el intérprete de este hilo
+         * @throws Error ArgumentTypeMismatch si contiene algo que no se puede copiar
+         */
+        Value copy(const Value& value);
+
+        /**
+         * @brief Copia la cadena de entornos que captura una función
+         * @param env Entorno del intérprete de origen (en el heap, o el global)
+         * @return std::shared_ptr<Environment> Copia (el global de destino para el de origen)
+         */
+        std::shared_ptr<Environment> copy(const Environment* env);
+
+        /**
+         * @brief Registra la copia de un objeto antes de copiar su contenido
+         * @param original Objeto de origen
+         * @param copy Su copia
+         *
+         * Los objetos que contienen otros lo llaman nada más crearse la
+         * copia, para que un ciclo que vuelva a ellos la encuentre.
+         */
+        void remember(const Object* original, const Value& copy);
+
+        /// Copia una variable del entorno global de origen (ver Environment::importFrom)
+        bool import(const std::string& name, Value& value) override;
+
+        /**
+         * @brief Transfer del worker de parallel_map que se ejecuta en este hilo
+         *
+         * nullptr fuera de los workers. Mientras no es nullptr, el AST es
+         * compartido con otros hilos: el evaluador copia con él los
+         * literales de cadena en lugar de compartir su objeto y no rellena
+         * las GlobalCache de los nodos.
+         */
+        static constinit thread_local Transfer* active;
+
+    private:
+        Environment& from;                 ///< Global de origen
+        std::shared_ptr<Environment> to;   ///< Global de destino
+        std::unordered_map<const Object*, Value> objects;                            ///< Copias hechas
+        std::unordered_map<const Environment*, std::shared_ptr<Environment>> environments; ///< Entornos copiados
+    };
+
+    /**
+     * @brief Aplica una función a cada elemento de un array, en varios hilos
+     * @param function Función del evaluador o nativa, de un argumento
+     * @param array Elementos
+     * @param threads Hilos como máximo, contando el que llama (0 = uno por núcleo)
+     * @return Value Array nuevo con function(x) para cada elemento x, en el mismo orden
+     * @throws El error de la primera llamada que falla (en el orden de los elementos)
+     *
+     * Cada worker ejecuta en su propio Context con copias de la función y
+     * de las globales que usa, así que nada de lo que haga llega al
+     * programa que llama salvo el valor que retorna (también copiado) y lo
+     * que imprime, que se añade a la salida en el orden de los elementos.
+     * Tras un error solo se completan las llamadas de los elementos
+     * anteriores, de modo que la salida y el error son los mismos que con
+     * un bucle que llamara a la función elemento a elemento.
+     */
+    Value mapInParallel(const Value& function, const ArrayObject& array, unsigned threads);
+}
+
+#endif // WORKERS_H
@@ -9,29 +9,40 @@
  * tokenización, parsing, evaluación y ejecución.
  */
 
+#include <chrono>
+#include <cstdlib>
 #include <cstring>
 #include <fstream>
 #include <iostream>
-#include <sstream>
+#include <memory>
 #include <string>
+#include <string_view>
+#include <vector>
 
 #include "commands/Parser.h"
+#include "commands/Profiler.h"
 #include "commands/Tokenizer.h"
 #include "commands/Evaluator.h"
 #include "commands/Run.h"
+#include "commands/Serve.h"
+#include "commands/Stats.h"
+#include "def/ASTCache.h"
 #include "def/ErrorCode.h"
+#include "def/Heap.h"
+#include "def/Output.h"
+#include "def/SourceFile.h"
 
 /**
- * @brief Lee el contenido completo de un archivo de texto
- * @param filename Ruta del archivo a leer
- * @return std::string Contenido del archivo como cadena
+ * @brief Obtiene el contenido completo de un archivo de código fuente
+ * @param source Archivo ya cargado (proyectado en memoria o leído)
+ * @param filename Ruta del archivo, para el mensaje de error
+ * @return std::string_view Contenido del archivo, válido mientras viva source
  * @throws std::exit(1) Si no se puede abrir el archivo
  * 
- * Esta función abre un archivo en modo texto, lee todo su contenido
- * en un buffer de cadena y devuelve el resultado. Si el archivo no
- * se puede abrir, termina el programa con código de error 1.
+ * El contenido no se copia: los tokens apuntan directamente a él. Si el
+ * archivo no se pudo abrir, termina el programa con código de error 1.
  */
-std::string read_file_contents(const std::string& filename);
+std::string_view read_file_contents(const TokenTree::SourceFile& source, const std::string& filename);
 
 /**
  * @brief Muestra información de ayuda detallada sobre el intérprete
@@ -52,7 +63,22 @@ void print_help();
  * - tokenize: Análisis léxico y muestra de tokens
  * - parse: Análisis sintáctico y construcción del AST
  * - evaluate: Evaluación de expresiones paso a paso
- * - run: Ejecución completa del programa
+ * - run: Ejecución completa del programa (--vm para usar la máquina virtual,
+ *   -O para plegar constantes, --no-cache para no usar ni escribir la caché de AST,
+ *   --output-buffer N para vaciar la salida de print cada N bytes, --gc-threshold N
+ *   y --gc-growth P para los umbrales del recolector de ciclos, --gc-stats para
+ *   informar del heap al terminar, --stats para informar de lo que hizo el
+ *   evaluador y --max-steps N, --max-time MS y --max-memory MB para detener
+ *   el programa si supera esos límites). Con varios
+ *   archivos se parsean en paralelo (-j N hilos) y se ejecutan en orden;
+ *   -j N también limita los hilos de parallel_map
+ * - parse con varios archivos: los parsea en paralelo y muestra el programa completo
+ * - profile: Ejecuta el programa con el evaluador y muestra dónde pasa el
+ *   tiempo (--folded para escribir además las pilas para un flamegraph)
+ * - serve: Ejecuta muchos trabajos en el mismo proceso, leídos de la entrada
+ *   estándar o de un socket Unix (--socket), reutilizando los programas ya
+ *   parseados (--cache N programas) y deteniendo los que superan --max-steps N
+ *   o --max-time MS (10 s por defecto)
  * - help: Muestra información de ayuda
  * 
  * La función coordina las diferentes fases del procesamiento del lenguaje,
@@ -60,9 +86,9 @@ void print_help();
  */
 int main(int argc, char *argv[]) {
     int exitCode = 0;
-    // Disable output buffering
-    std::cout << std::unitbuf;
-    std::cerr << std::unitbuf;    try {
+    // Los errores se ven al momento; print usa su propio búfer (Output)
+    std::cerr << std::unitbuf;
+    try {
         if (argc < 2) {
             std::cerr << "Usage: ./your_program <command> [filename]" << std::endl;
             std::cerr << "Use 'help' command for more information." << std::endl;
@@ -76,6 +102,41 @@ int main(int argc, char *argv[]) {
             return 0;
         }
 
+        if (command == "serve") {
+            // Opciones: serve [--socket <ruta>] [--cache N] [--max-steps N] [--max-time MS]
+            Serve::Options options;
+            for (int i = 2; i < argc; ++i) {
+                if (std::strcmp(argv[i], "--socket") == 0 && i + 1 < argc) {
+                    options.socketPath = argv[++i];
+                } else if (std::strcmp(argv[i], "--cache") == 0 && i + 1 < argc) {
+                    char* end;
+                    unsigned long long count = std::strtoull(argv[++i], &end, 10);
+                    if (*end != '\0' || *argv[i] == '-' || count == 0) {
+                        std::cerr << "Invalid --cache size: " << argv[i] << std::endl;
+                        return 1;
+                    }
+                    options.cacheCapacity = static_cast<size_t>(count);
+                } else if ((std::strcmp(argv[i], "--max-steps") == 0 || std::strcmp(argv[i], "--max-time") == 0) &&
+                           i + 1 < argc) {
+                    // Límites de cada trabajo; 0 los desactiva
+                    const char* flag = argv[i];
+                    char* end;
+                    unsigned long long limit = std::strtoull(argv[++i], &end, 10);
+                    if (*end != '\0' || *argv[i] == '-') {
+                        std::cerr << "Invalid " << flag << " limit: " << argv[i] << std::endl;
+                        return 1;
+                    }
+                    if (std::strcmp(flag, "--max-steps") == 0) options.budget.steps = limit;
+                    else options.budget.time = std::chrono::milliseconds(limit);
+                } else {
+                    std::cerr << "Usage: ./your_program serve [--socket <path>] [--cache N] [--max-steps N]"
+                                 " [--max-time MS]" << std::endl;
+                    return 1;
+                }
+            }
+            return Serve::serve(options);
+        }
+
         if (argc < 3) {
             std::cerr << "Usage: ./your_program <command> <filename>" << std::endl;
             std::cerr << "Use 'help' command for more information." << std::endl;
@@ -83,36 +144,183 @@ int main(int argc, char *argv[]) {
         }
 
         if (command == "tokenize") {
-            std::string file_contents = read_file_contents(argv[2]);
+            TokenTree::SourceFile source(argv[2]);
+            auto file_contents = read_file_contents(source, argv[2]);
 
             using namespace Tokenizer;
             exitCode = tokenize(file_contents);
-        } else if (command == "parse") {
-            std::string file_contents = read_file_contents(argv[2]);
-
-            // Obtener tokens y código de salida
-            auto result = Tokenizer::getTokens(file_contents);
-            exitCode = result.exitCode;
-            if (exitCode == 0) {
-                // Use Parser to convert to AST and print
-                exitCode = Parser::parse(result.tokens);
+        } else if (command == "parse" && argc > 3) {
+            // Varios archivos: se parsean en paralelo y se muestran como un solo programa
+            std::vector<std::unique_ptr<TokenTree::SourceFile>> files;
+            std::vector<std::string_view> sources;
+            std::vector<std::string> names(argv + 2, argv + argc);
+            for (const auto& name : names) {
+                files.push_back(std::make_unique<TokenTree::SourceFile>(name));
+                sources.push_back(read_file_contents(*files.back(), name));
             }
+            exitCode = Parser::parse(sources, names);
+        } else if (command == "parse") {
+            TokenTree::SourceFile source(argv[2]);
+            auto file_contents = read_file_contents(source, argv[2]);
+
+            // El parser pide los tokens al lexer a medida que los necesita
+            Tokenizer::Lexer lexer(file_contents);
+            exitCode = Parser::parse(lexer);
         } else if (command == "evaluate") {
-            std::string file_contents = read_file_contents(argv[2]);
+            TokenTree::SourceFile source(argv[2]);
+            auto file_contents = read_file_contents(source, argv[2]);
 
-            auto result = Tokenizer::getTokens(file_contents);
-            exitCode = result.exitCode;
-            if (exitCode == 0) {                
-                exitCode = Evaluator::evaluate(result.tokens);
-                std::cout << std::endl;
-            }
+            Tokenizer::Lexer lexer(file_contents);
+            exitCode = Evaluator::evaluate(lexer);
+            // Si hubo errores léxicos no llegó a evaluarse nada
+            if (lexer.finish() == 0) std::cout << std::endl;
         } else if (command == "run") {
-            std::string file_contents = read_file_contents(argv[2]);
-            auto result = Tokenizer::getTokens(file_contents);
-            exitCode = result.exitCode;
-            if (exitCode == 0) {
-                exitCode = Run::run(result.tokens);
-            }        } else {
+            // Opciones: run [--vm] [-O] [--no-cache] [--output-buffer N] [-j N]
+            //               [--gc-threshold N] [--gc-growth P] [--gc-stats]
+            //               [--stats] [--max-steps N] [--max-time MS] [--max-memory MB] <archivo>...
+            Run::Options options;
+            bool useCache = true;
+            bool heapStats = false;
+            bool runStats = false;
+            Stats::Budget budget;
+            size_t gcThreshold = TokenTree::Heap::DEFAULT_THRESHOLD;
+            unsigned long gcGrowth = TokenTree::Heap::DEFAULT_GROWTH;
+            std::vector<std::string> filenames;
+            for (int i = 2; i < argc; ++i) {
+                if (std::strcmp(argv[i], "--vm") == 0) {
+                    options.backend = Run::Backend::VM;
+                } else if (std::strcmp(argv[i], "-O") == 0) {
+                    options.optimize = true;
+                } else if (std::strcmp(argv[i], "--no-cache") == 0) {
+                    useCache = false;
+                } else if (std::strcmp(argv[i], "--output-buffer") == 0 && i + 1 < argc) {
+                    char* end;
+                    unsigned long long bytes = std::strtoull(argv[++i], &end, 10);
+                    if (*end != '\0' || *argv[i] == '-') {
+                        std::cerr << "Invalid --output-buffer size: " << argv[i] << std::endl;
+                        return 1;
+                    }
+                    Run::Interpreter::process().output().setCapacity(static_cast<size_t>(bytes));
+                } else if (std::strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+                    char* end;
+                    unsigned long threads = std::strtoul(argv[++i], &end, 10);
+                    if (*end != '\0' || *argv[i] == '-' || threads == 0) {
+                        std::cerr << "Invalid -j thread count: " << argv[i] << std::endl;
+                        return 1;
+                    }
+                    options.threads = static_cast<unsigned>(threads);
+                } else if (std::strcmp(argv[i], "--gc-threshold") == 0 && i + 1 < argc) {
+                    char* end;
+                    unsigned long long count = std::strtoull(argv[++i], &end, 10);
+                    if (*end != '\0' || *argv[i] == '-') {
+                        std::cerr << "Invalid --gc-threshold count: " << argv[i] << std::endl;
+                        return 1;
+                    }
+                    gcThreshold = static_cast<size_t>(count);
+                } else if (std::strcmp(argv[i], "--gc-growth") == 0 && i + 1 < argc) {
+                    char* end;
+                    gcGrowth = std::strtoul(argv[++i], &end, 10);
+                    if (*end != '\0' || *argv[i] == '-') {
+                        std::cerr << "Invalid --gc-growth percentage: " << argv[i] << std::endl;
+                        return 1;
+                    }
+                } else if (std::strcmp(argv[i], "--gc-stats") == 0) {
+                    heapStats = true;
+                } else if (std::strcmp(argv[i], "--stats") == 0) {
+                    runStats = true;
+                } else if ((std::strcmp(argv[i], "--max-steps") == 0 || std::strcmp(argv[i], "--max-time") == 0 ||
+                            std::strcmp(argv[i], "--max-memory") == 0) && i + 1 < argc) {
+                    const char* flag = argv[i];
+                    char* end;
+                    unsigned long long limit = std::strtoull(argv[++i], &end, 10);
+                    if (*end != '\0' || *argv[i] == '-' || limit == 0) {
+                        std::cerr << "Invalid " << flag << " limit: " << argv[i] << std::endl;
+                        return 1;
+                    }
+                    if (std::strcmp(flag, "--max-steps") == 0) budget.steps = limit;
+                    else if (std::strcmp(flag, "--max-time") == 0) budget.time = std::chrono::milliseconds(limit);
+                    else budget.memory = static_cast<size_t>(limit) * 1024 * 1024;
+                } else {
+                    filenames.push_back(argv[i]);
+                }
+            }
+            if (filenames.empty()) {
+                std::cerr << "Usage: ./your_program run [--vm] [-O] [--no-cache] [--output-buffer N] [-j N]"
+                             " [--gc-threshold N] [--gc-growth P] [--gc-stats] [--stats] [--max-steps N]"
+                             " [--max-time MS] [--max-memory MB] <filename>..." << std::endl;
+                return 1;
+            }
+            Run::Interpreter& interpreter = Run::Interpreter::process();
+            interpreter.heap().setThresholds(gcThreshold, static_cast<unsigned>(gcGrowth));
+            // Las estadísticas las lleva el evaluador de árbol, también con --vm; los
+            // límites solos se comprueban en el motor elegido
+            Stats::Session session(budget);
+            if (runStats) options.stats = &session;
+            else options.budget = budget;
+            if (filenames.size() > 1) {
+                // Front end en paralelo; se ejecutan en orden como un único programa
+                std::vector<std::unique_ptr<TokenTree::SourceFile>> files;
+                std::vector<Run::Source> sources;
+                for (const auto& name : filenames) {
+                    files.push_back(std::make_unique<TokenTree::SourceFile>(name));
+                    sources.push_back({name, read_file_contents(*files.back(), name),
+                                       useCache ? TokenTree::ASTCache::pathFor(name) : std::string()});
+                }
+                exitCode = Run::run(sources, options);
+            } else {
+                const std::string& filename = filenames.front();
+                TokenTree::SourceFile source(filename);
+                auto file_contents = read_file_contents(source, filename);
+                if (useCache) {
+                    // El AST se guarda junto al fuente y se reutiliza mientras no cambie
+                    exitCode = Run::run(file_contents, TokenTree::ASTCache::pathFor(filename), options);
+                } else {
+                    Tokenizer::Lexer lexer(file_contents);
+                    exitCode = Run::run(lexer, options);
+                }
+            }
+            // Lo impreso por el programa va antes que los informes
+            if (heapStats || runStats) interpreter.output().flush();
+            if (runStats) {
+                session.finish();
+                session.report(std::cerr);
+            }
+            if (heapStats) interpreter.heap().report(std::cerr, interpreter.strings().size());
+        } else if (command == "profile") {
+            // Opciones: profile [-O] [--folded <salida>] <archivo>
+            Profiler::Session session;
+            Run::Options options;
+            options.profiler = &session;
+            std::string foldedPath;
+            std::string filename;
+            for (int i = 2; i < argc; ++i) {
+                if (std::strcmp(argv[i], "-O") == 0) {
+                    options.optimize = true;
+                } else if (std::strcmp(argv[i], "--folded") == 0 && i + 1 < argc) {
+                    foldedPath = argv[++i];
+                } else {
+                    filename = argv[i];
+                }
+            }
+            if (filename.empty()) {
+                std::cerr << "Usage: ./your_program profile [-O] [--folded <output>] <filename>" << std::endl;
+                return 1;
+            }
+            TokenTree::SourceFile source(filename);
+            auto file_contents = read_file_contents(source, filename);
+            exitCode = Run::run(file_contents, TokenTree::ASTCache::pathFor(filename), options);
+            // También se informa de un programa que terminó con error: lo ejecutado hasta ahí
+            session.finish();
+            session.report(std::cerr);
+            if (!foldedPath.empty()) {
+                std::ofstream folded(foldedPath);
+                if (!folded) {
+                    std::cerr << "Error writing file: " << foldedPath << std::endl;
+                    return 1;
+                }
+                session.writeFolded(folded);
+            }
+        } else {
             std::cerr << "Unknown command: " << command << std::endl;
             std::cerr << "Use 'help' command for more information." << std::endl;
             exitCode =  1;
@@ -124,16 +332,12 @@ int main(int argc, char *argv[]) {
     return exitCode;
 }
 
-std::string read_file_contents(const std::string& filename) {
-    std::ifstream file(filename);
-    if (!file.is_open()) {
+std::string_view read_file_contents(const TokenTree::SourceFile& source, const std::string& filename) {
+    if (!source.isOpen()) {
         std::cerr << "Error reading file: " << filename << std::endl;
         std::exit(1);
     }
-
-    std::stringstream buffer;
-    buffer << file.rdbuf();
-    file.close();    return buffer.str();
+    return source.contents();
 }
 
 void print_help() {
@@ -166,12 +370,66 @@ void print_help() {
     std::cout << "    evaluada. Útil para entender el flujo de evaluación del programa." << std::endl;
     std::cout << std::endl;
     
-    std::cout << "  run <archivo>" << std::endl;
+    std::cout << "  run [--vm] [-O] [--no-cache] [--output-buffer N] [-j N]" << std::endl;
+    std::cout << "      [--gc-threshold N] [--gc-growth P] [--gc-stats]" << std::endl;
+    std::cout << "      [--stats] [--max-steps N] [--max-time MS] [--max-memory MB] <archivo>..." << std::endl;
     std::cout << "    Ejecuta completamente el programa contenido en el archivo fuente." << std::endl;
     std::cout << "    Este es el comando principal para ejecutar programas escritos en Setker." << std::endl;
     std::cout << "    Ejecuta todas las instrucciones y muestra la salida final del programa." << std::endl;
+    std::cout << "    Con --vm el programa se compila a bytecode y se ejecuta en la máquina" << std::endl;
+    std::cout << "    virtual, más rápida en bucles y llamadas que el evaluador de árbol." << std::endl;
+    std::cout << "    El AST del programa se guarda junto al fuente (archivo.stkc) y se reutiliza" << std::endl;
+    std::cout << "    mientras el fuente no cambie; --no-cache lo desactiva." << std::endl;
+    std::cout << "    Con -O se pliegan las expresiones constantes y se eliminan las ramas" << std::endl;
+    std::cout << "    if/while con condición constante antes de ejecutar." << std::endl;
+    std::cout << "    La salida de print se acumula y se escribe en bloques de N bytes" << std::endl;
+    std::cout << "    (--output-buffer N, 65536 por defecto; 0 escribe cada línea). En una" << std::endl;
+    std::cout << "    terminal se escribe al final de cada línea." << std::endl;
+    std::cout << "    Con varios archivos, se tokenizan y parsean en paralelo (-j N hilos; por" << std::endl;
+    std::cout << "    defecto uno por núcleo) y se ejecutan en orden como un único programa," << std::endl;
+    std::cout << "    igual que si se hubieran concatenado. También parse acepta varios archivos." << std::endl;
+    std::cout << "    parallel_map(f, a) reparte las llamadas f(x) entre -j N hilos (por defecto" << std::endl;
+    std::cout << "    uno por núcleo); cada hilo trabaja con copias de f, de los elementos y de" << std::endl;
+    std::cout << "    las globales que lee. No está disponible con --vm." << std::endl;
+    std::cout << "    Las funciones que se referencian a sí mismas o a su entorno forman ciclos que" << std::endl;
+    std::cout << "    libera un recolector: se ejecuta tras reservar --gc-threshold N entornos," << std::endl;
+    std::cout << "    funciones y closures nuevos (10000 por defecto; 0 lo desactiva) y al menos" << std::endl;
+    std::cout << "    --gc-growth P por ciento de los que sobrevivieron a la anterior (100 por" << std::endl;
+    std::cout << "    defecto). --gc-stats muestra al terminar, en la salida de error, los" << std::endl;
+    std::cout << "    objetos vivos y el trabajo del recolector." << std::endl;
+    std::cout << "    --stats muestra al terminar, en la salida de error, los nodos evaluados por" << std::endl;
+    std::cout << "    tipo, los entornos creados y el máximo vivo a la vez, las búsquedas de" << std::endl;
+    std::cout << "    variables por profundidad, las llamadas y los bytes de cadenas creados." << std::endl;
+    std::cout << "    --max-steps N (nodos evaluados), --max-time MS (milisegundos) y" << std::endl;
+    std::cout << "    --max-memory MB (memoria residente del proceso) detienen el programa con" << std::endl;
+    std::cout << "    el código 75 si los supera. --stats usa el evaluador de árbol, también con" << std::endl;
+    std::cout << "    --vm; sin --stats, la VM comprueba los límites y cuenta como un paso cada" << std::endl;
+    std::cout << "    vuelta de bucle y cada llamada." << std::endl;
     std::cout << std::endl;
     
+    std::cout << "  profile [-O] [--folded <salida>] <archivo>" << std::endl;
+    std::cout << "    Ejecuta el programa con el evaluador de árbol y, al terminar, muestra en" << std::endl;
+    std::cout << "    la salida de error las llamadas y el tiempo inclusivo y exclusivo de cada" << std::endl;
+    std::cout << "    función, y los nodos del AST que más veces se evalúan. Con --folded" << std::endl;
+    std::cout << "    escribe además las pilas de llamadas (microsegundos exclusivos) en el" << std::endl;
+    std::cout << "    formato de flamegraph.pl." << std::endl;
+    std::cout << std::endl;
+
+    std::cout << "  serve [--socket <ruta>] [--cache N] [--max-steps N] [--max-time MS]" << std::endl;
+    std::cout << "    Mantiene el intérprete en memoria y ejecuta los trabajos que llegan por la" << std::endl;
+    std::cout << "    entrada estándar (o por un socket Unix con --socket), uno por línea:" << std::endl;
+    std::cout << "      run [--vm] [-O] <archivo>     ejecuta un archivo" << std::endl;
+    std::cout << "      source [--vm] [-O] <bytes>    ejecuta los <bytes> bytes siguientes" << std::endl;
+    std::cout << "      stats                         muestra el uso de la caché" << std::endl;
+    std::cout << "      quit                          termina el servidor" << std::endl;
+    std::cout << "    Cada trabajo empieza con globales nuevas y se responde con la línea" << std::endl;
+    std::cout << "    'done code=C out=N err=M time_us=T cache=hit|miss' seguida de N bytes de" << std::endl;
+    std::cout << "    salida y M de errores. Los N programas usados más recientemente (256 por" << std::endl;
+    std::cout << "    defecto) se guardan ya parseados, identificados por su contenido. Un trabajo" << std::endl;
+    std::cout << "    que supera --max-steps N o --max-time MS (10000 por defecto; 0 = sin" << std::endl;
+    std::cout << "    límite) termina con el código 75 y el servidor sigue con el siguiente." << std::endl;
+    std::cout << std::endl;
+
     std::cout << "  help" << std::endl;
     std::cout << "    Muestra esta información de ayuda con la descripción de todos los comandos" << std::endl;
     std::cout << "    disponibles y sus propósitos." << std::endl;
@@ -179,6 +437,11 @@ void print_help() {
     
     std::cout << "EJEMPLOS DE USO:" << std::endl;
     std::cout << "  ./setker run examples/factorial.stk" << std::endl;
+    std::cout << "  ./setker run --vm examples/factorial.stk" << std::endl;
+    std::cout << "  ./setker run -O examples/factorial.stk" << std::endl;
+    std::cout << "  ./setker run -j 8 src/util.stk src/main.stk" << std::endl;
+    std::cout << "  ./setker profile --folded fib.folded examples/functions.stk" << std::endl;
+    std::cout << "  ./setker serve --socket /tmp/setker.sock" << std::endl;
     std::cout << "  ./setker tokenize examples/arithmetic.stk" << std::endl;
     std::cout << "  ./setker parse examples/functions.stk" << std::endl;
     std::cout << "  ./setker evaluate examples/control_flow.stk" << std::endl;